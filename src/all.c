@@ -12,6 +12,7 @@
 #include "options.c"
 #include "util.c"
 #include "stats.c"
+#include "trace.c"
 #include "bit.c"
 
 /* move generation */
@@ -23,6 +24,8 @@
 #include "hash.c"
 #include "ybwc.c"
 #include "search.c"
+#include "pool.c"
+#include "timemodel.c"
 #include "endgame.c"
 #include "midgame.c"
 #include "root.c"
@@ -39,6 +42,13 @@
 #include "base.c"
 #include "opening.c"
 
+#ifdef EDAX_LIBRARY
+
+/* embeddable engine (see libedax.h) */
+#include "libedax.c"
+
+#else
+
 /* game play with various protocols */
 #include "play.c"
 #include "event.c"
@@ -49,7 +59,10 @@
 #include "gtp.c"
 #include "nboard.c"
 #include "xboard.c"
+#include "json.c"
 
 /* main */
 #include "main.c"
 
+#endif
+
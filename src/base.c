@@ -17,6 +17,9 @@
 #include <stdio.h>
 #include <time.h>
 
+/** Size of the wthor file header, as stored on disk. */
+#define WTHOR_HEADER_SIZE 16
+
 /**
  * @brief Set wthor header.
  *
@@ -320,27 +323,41 @@ void wthor_init(WthorBase *base)
 	base->tournament = NULL;
 	base->player = NULL;
 	base->game = NULL;
+	file_map_init(&base->map);
 }
 
 /**
- * @brief Load a wthor base.
+ * @brief Load the tournaments & players of a wthor base.
+ *
+ * Both files are looked for in the directory of the game file.
  *
  * @param base Wthor game base.
  * @param file Game file.
  */
-bool wthor_load(WthorBase *base, const char *file)
+static void wthor_names_load(WthorBase *base, const char *file)
 {
-	FILE *f;
 	char path[FILENAME_MAX];
-	int r = 0;
-
-	wthor_init(base);
 
 	path_get_dir(file, path); strcat(path, "WTHOR.TRN");
 	wthor_tournaments_load(base, path);
 
 	path_get_dir(file, path); strcat(path, "WTHOR.JOU");
 	wthor_players_load(base, path);
+}
+
+/**
+ * @brief Load a wthor base.
+ *
+ * @param base Wthor game base.
+ * @param file Game file.
+ */
+bool wthor_load(WthorBase *base, const char *file)
+{
+	FILE *f;
+	int r = 0;
+
+	wthor_init(base);
+	wthor_names_load(base, file);
 
 	if ((f = fopen(file, "rb")) != NULL) {
 		if (wthor_header_read(&base->header, f) && base->header.board_size == 8) {
@@ -364,6 +381,70 @@ bool wthor_load(WthorBase *base, const char *file)
 	return r != 0;
 }
 
+/**
+ * @brief Read the header of a wthor file to map.
+ *
+ * The header is read with wthor_header_read(), and the file is only mapped
+ * if it holds 8x8 games and if its size matches the number of games of its
+ * header exactly.
+ *
+ * @param header Wthor's file header.
+ * @param file Game file.
+ * @param size Size of the file.
+ * @return true if the file can be mapped.
+ */
+static bool wthor_map_header(WthorHeader *header, const char *file, const size_t size)
+{
+	FILE *f;
+	bool ok;
+
+	if ((f = fopen(file, "rb")) == NULL) {
+		warn("Cannot open file %s\n", file);
+		return false;
+	}
+	ok = wthor_header_read(header, f);
+	fclose(f);
+	if (!ok) return false;
+
+	if (header->board_size != 8) {
+		warn("%s: unsupported board size (%d)\n", file, header->board_size);
+		return false;
+	}
+	if (size < WTHOR_HEADER_SIZE || size - WTHOR_HEADER_SIZE != (size_t) header->n_games * sizeof (WthorGame)) {
+		warn("%s: the size of the file does not match its number of games (%d)\n", file, header->n_games);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Map a wthor base.
+ *
+ * Games are read in place from a memory mapping of the file, so that
+ * large bases are neither copied nor fully loaded into memory.
+ * If the file cannot be mapped, the base is loaded with wthor_load().
+ * A file whose header does not match its size is refused.
+ *
+ * @param base Wthor game base.
+ * @param file Game file.
+ */
+bool wthor_map(WthorBase *base, const char *file)
+{
+	wthor_init(base);
+	if (!file_map(&base->map, file)) return wthor_load(base, file);
+
+	if (!wthor_map_header(&base->header, file, base->map.size)) {
+		file_unmap(&base->map);
+		return false;
+	}
+	wthor_names_load(base, file);
+	base->game = (WthorGame*) ((char*) base->map.data + WTHOR_HEADER_SIZE);
+	base->n_games = base->header.n_games;
+
+	return true;
+}
+
 /**
  * @brief Free a wthor base.
  *
@@ -373,7 +454,8 @@ void wthor_free(WthorBase *base)
 {
 	free(base->player);
 	free(base->tournament);
-	free(base->game);
+	if (base->map.data) file_unmap(&base->map);
+	else free(base->game);
 	wthor_init(base);
 }
 
@@ -418,14 +500,18 @@ bool base_to_wthor(const Base *base, WthorBase *wthor)
 	bool ok = true;
 	int i, j;
 
+	const Game *game;
+	Game buffer;
+
 	j = wthor->n_games;
 	wthor->n_games = j + base->n_games;
 	wthor->game = (WthorGame*) realloc(wthor->game, wthor->n_games * sizeof (WthorGame));
 	if (wthor->game) {
 		for (i = 0; i < base->n_games; ++i, ++j) {
-			game_to_wthor(base->game + i, wthor->game + j);
-			wthor->game[j].black = wthor_player_get(wthor, base->game[i].name[BLACK]); 
-			wthor->game[j].white = wthor_player_get(wthor, base->game[i].name[WHITE]); 
+			game = base_get_game(base, i, &buffer);
+			game_to_wthor(game, wthor->game + j);
+			wthor->game[j].black = wthor_player_get(wthor, game->name[BLACK]); 
+			wthor->game[j].white = wthor_player_get(wthor, game->name[WHITE]); 
 		}
 	} else {
 		warn("Cannot allocate wthor games\n");
@@ -506,98 +592,347 @@ int pv_check(const Board *init_board, Line *pv, Search *search)
 	return game_analyze(&game, search, board_count_empties(init_board), false);
 }
 
+/** Batch of jobs spread over a pool of searches. */
+typedef struct Batch {
+	Search *search;                           /**< pool of searches */
+	int n_search;                             /**< pool size */
+	int n_jobs;                               /**< number of jobs */
+	int next;                                 /**< next job to run */
+	int n_reported;                           /**< number of jobs reported, in order */
+	bool *done;                               /**< finished jobs */
+	void (*run)(struct Batch*, Search*, const int);   /**< run a job */
+	void (*report)(struct Batch*, const int); /**< report a finished job */
+	void *data;                               /**< job specific data */
+	void (*observer)(Result*);                /**< job specific observer (NULL: the search observer) */
+	long long time;                           /**< starting time */
+	Lock lock;                                /**< lock */
+} Batch;
+
+/** A worker of a batch */
+typedef struct BatchWorker {
+	Batch *batch;                             /**< batch */
+	Search *search;                           /**< search used by this worker */
+} BatchWorker;
+
 /**
- * @brief Test Search with a wthor base.
+ * Observer of the searches of the running batch (batches are run one at a
+ * time), printing under the batch lock, as the reports do.
+ */
+static struct {
+	Batch *batch;                             /**< running batch */
+	void (*observer)(Result*);                /**< observer of the default search */
+} batch_output;
+
+/**
+ * @brief Print a search result of a batch, without mixing the outputs of
+ * several workers.
  *
- * @param file Game File.
- * @param search Search.
+ * @param result Search result.
  */
-void wthor_test(const char *file, Search *search)
+static void batch_observer(Result *result)
 {
-	WthorBase base;
-	WthorGame *wthor;
-	Board board;
-	int player;
-	int score;
-	int n_empties;
-	int n_failure;
-	long long n_nodes;
-	long long t;
-	int n_err;
+	lock(batch_output.batch);
+	if (batch_output.batch->observer) batch_output.batch->observer(result);
+	else batch_output.observer(result);
+	unlock(batch_output.batch);
+}
 
-	if (wthor_load(&base, file)) {
+/**
+ * @brief Print the throughput of a batch.
+ *
+ * @param batch Batch.
+ * @param n Number of jobs done.
+ * @param f Output stream.
+ */
+static void batch_print_rate(const Batch *batch, const int n, FILE *f)
+{
+	const long long t = real_clock() - batch->time;
 
-		if (search->options.verbosity == 1) {
-			if (search->options.header) puts(search->options.header);
-			if (search->options.separator) puts(search->options.separator);
+	fprintf(f, "%.0f games/hour", t > 0 ? 3600000.0 * n / t : 0.0);
+}
+
+/**
+ * @brief Run the jobs of a batch until none is left.
+ *
+ * Jobs are taken in order, but may finish in any order. Finished jobs are
+ * reported in their original order by whichever worker completes the oldest
+ * pending one.
+ *
+ * @param data Batch worker.
+ * @return NULL.
+ */
+static void* batch_work(void *data)
+{
+	BatchWorker *worker = (BatchWorker*) data;
+	Batch *batch = worker->batch;
+	int i;
+
+	for (;;) {
+		lock(batch);
+		i = batch->next++;
+		unlock(batch);
+		if (i >= batch->n_jobs) break;
+
+		batch->run(batch, worker->search, i);
+
+		lock(batch);
+		batch->done[i] = true;
+		while (batch->n_reported < batch->n_jobs && batch->done[batch->n_reported]) {
+			batch->report(batch, batch->n_reported++);
 		}
+		unlock(batch);
+	}
 
-		n_failure = 0;
-		n_nodes = 0;
-		t = 0;
+	return NULL;
+}
 
-		foreach_wthorgame(wthor, base) {
-			wthorgame_get_board(wthor, base.header.depth, &board, &player);
-			n_empties = board_count_empties(&board);
-			if (n_empties != base.header.depth && !board_is_game_over(&board)) {
-				warn("Incomplete or Illegal game: %d empties\n", n_empties);
-				wthor_print_game(&base, wthor - base.game, stderr);
-				continue;
-			}
+/**
+ * @brief Run a batch of jobs.
+ *
+ * With the "batch-searches" option set to 1, all jobs are run by the given
+ * search. Otherwise, a pool of searches is created, sharing the available
+ * tasks and hash table memory, each search being run by its own thread.
+ *
+ * @param batch Batch, with its job functions & data set.
+ * @param search Default search.
+ * @param n_jobs Number of jobs.
+ */
+static void batch_run(Batch *batch, Search *search, const int n_jobs)
+{
+	const int n_task = options.n_task;
+	const int hash_table_size = options.hash_table_size;
+	BatchWorker worker[MAX_THREADS];
+	Thread thread[MAX_THREADS];
+	int i, n_bits;
+
+	batch->n_jobs = n_jobs;
+	batch->next = batch->n_reported = 0;
+	batch->done = (bool*) calloc(n_jobs + 1, sizeof (bool));
+	if (batch->done == NULL) fatal_error("Cannot allocate batch flags\n");
+	lock_init(batch);
+	batch->time = real_clock();
+	batch_output.batch = batch;
+	batch_output.observer = search->observer;
+
+	batch->n_search = MIN(options.n_search, n_jobs);
+	if (batch->n_search <= 1) {
+		batch->n_search = 1;
+		batch->search = NULL;
+		worker->batch = batch;
+		worker->search = search;
+		search->observer = batch_observer;
+		batch_work(worker);
+		search->observer = batch_output.observer;
 
-			if (player == WHITE) score = 64 - 2 * wthor->theoric_score;
-			else score = 2 * wthor->theoric_score - 64;
-			if (abs(score) > 64) {
-				warn("Impossible theoric score:\n");
-				wthor_print_game(&base, wthor - base.game, stderr);
-				continue;
-			}
+	} else {
+		batch->search = (Search*) mm_malloc(batch->n_search * sizeof (Search));
+		if (batch->search == NULL) fatal_error("Cannot allocate a pool of %d searches\n", batch->n_search);
+
+		// split the tasks & the hash table memory among the searches
+		for (n_bits = 0; (1 << n_bits) < batch->n_search; ++n_bits) ;
+		options.n_task = MAX(1, n_task / batch->n_search);
+		options.hash_table_size = MAX(10, hash_table_size - n_bits);
+		info("<batch: %d searches of %d tasks and 2^%d hash entries>\n", batch->n_search, options.n_task, options.hash_table_size);
+
+		for (i = 0; i < batch->n_search; ++i) {
+			search_init(batch->search + i);
+			batch->search[i].id = i + 1;
+			batch->search[i].options.verbosity = 0;
+			batch->search[i].observer = batch_observer;
+			worker[i].batch = batch;
+			worker[i].search = batch->search + i;
+		}
+		options.n_task = n_task;
+		options.hash_table_size = hash_table_size;
 
-			search_cleanup(search);
-			search_set_board(search, &board, player);
-			search_set_level(search, 60, base.header.depth);
-			search_run(search);
-			if (search->options.verbosity) putchar('\n');
-			n_nodes += search->result->n_nodes;
-			t += search->result->time;
-			if (score != search->result->score) {
-				warn("Wrong theoric score: %+d (Wthor) instead of %+d (Edax)\n", score, search->result->score);
-				wthor_print_game(&base, wthor - base.game, stderr);
-				++n_failure;
-				assert(false); // stop here when debug is on
-			}
+		for (i = 0; i < batch->n_search; ++i) thread_create(thread + i, batch_work, worker + i);
+		for (i = 0; i < batch->n_search; ++i) thread_join(thread[i]);
 
-			if (options.pv_check) {
-				Line pv;
-				line_copy(&pv, &search->result->pv, 0);
-				n_err = pv_check(&board, &pv, search);
-				if (n_err) {
-					char s[80];
-					warn("Wrong pv:\n");
-					board_print(&board, player, stderr);
-					fprintf(stderr, "setboard %s\nplay ", board_to_string(&board, player, s));
-					line_print(&pv, 200, " ", stderr);
-					putc('\n', stderr); putc('\n', stderr);
-					assert(false); // stop here when debug is on
-				}
-			}
+		for (i = 0; i < batch->n_search; ++i) search_free(batch->search + i);
+		mm_free(batch->search);
+	}
 
-			if (search->options.verbosity == 0) {
-				printf("%s  game: %4d, error: %2d ; ", file, (int)(wthor - base.game) + 1, n_failure);
-				printf("%lld n, ", n_nodes); time_print(t, false, stdout); putchar('\r');
-				fflush(stdout);
-			}
+	lock_free(batch);
+	free(batch->done);
+}
+
+/** Result of a wthor game test. */
+typedef struct WthorTestResult {
+	Board board;                              /**< tested position */
+	int player;                               /**< player to move */
+	int score;                                /**< theoric score */
+	int edax_score;                           /**< score found by Edax */
+	int n_err;                                /**< pv errors */
+	int status;                               /**< 0: ok, 1: illegal game, 2: impossible score */
+	unsigned long long n_nodes;               /**< node count */
+	long long time;                           /**< search time */
+	Line pv;                                  /**< pv */
+} WthorTestResult;
+
+/** Data of a wthor test batch. */
+typedef struct WthorTest {
+	WthorBase base;                           /**< wthor base */
+	const char *file;                         /**< wthor file */
+	WthorTestResult *result;                  /**< result, for each game */
+	int level;                                /**< search level */
+	int n_failure;                            /**< number of wrong scores */
+	unsigned long long n_nodes;               /**< total node count */
+	long long time;                           /**< total search time */
+	int verbosity;                            /**< output verbosity */
+	unsigned long long (*histogram)[65];      /**< score histogram (wthor_eval) */
+} WthorTest;
+
+/**
+ * @brief Search a wthor game position.
+ *
+ * @param batch Batch.
+ * @param search Search.
+ * @param i Game index.
+ */
+static void wthor_test_run(Batch *batch, Search *search, const int i)
+{
+	WthorTest *test = (WthorTest*) batch->data;
+	WthorGame *wthor = test->base.game + i;
+	WthorTestResult *r = test->result + i;
+
+	r->status = 0;
+	wthorgame_get_board(wthor, test->base.header.depth, &r->board, &r->player);
+	if (board_count_empties(&r->board) != test->base.header.depth && !board_is_game_over(&r->board)) {
+		r->status = 1;
+		return;
+	}
+
+	if (r->player == WHITE) r->score = 64 - 2 * wthor->theoric_score;
+	else r->score = 2 * wthor->theoric_score - 64;
+	if (abs(r->score) > 64) {
+		r->status = 2;
+		return;
+	}
+
+	search_cleanup(search);
+	search_set_board(search, &r->board, r->player);
+	search_set_level(search, test->level, test->base.header.depth);
+	search_run(search);
+	if (search->options.verbosity) putchar('\n');
+	r->edax_score = search->result->score;
+	r->n_nodes = search->result->n_nodes;
+	r->time = search->result->time;
+
+	r->n_err = 0;
+	if (test->histogram == NULL && options.pv_check) {
+		line_copy(&r->pv, &search->result->pv, 0);
+		r->n_err = pv_check(&r->board, &r->pv, search);
+	}
+}
+
+/**
+ * @brief Report a wthor game test.
+ *
+ * @param batch Batch.
+ * @param i Game index.
+ */
+static void wthor_test_report(Batch *batch, const int i)
+{
+	WthorTest *test = (WthorTest*) batch->data;
+	WthorTestResult *r = test->result + i;
+
+	if (r->status == 1) {
+		warn("Incomplete or Illegal game: %d empties\n", board_count_empties(&r->board));
+		wthor_print_game(&test->base, i, stderr);
+		return;
+	} else if (r->status == 2) {
+		warn("Impossible theoric score:\n");
+		wthor_print_game(&test->base, i, stderr);
+		return;
+	}
+
+	test->n_nodes += r->n_nodes;
+	test->time += r->time;
+	if (r->score != r->edax_score) {
+		warn("Wrong theoric score: %+d (Wthor) instead of %+d (Edax)\n", r->score, r->edax_score);
+		wthor_print_game(&test->base, i, stderr);
+		++test->n_failure;
+		assert(false); // stop here when debug is on
+	}
+
+	if (r->n_err) {
+		char s[80];
+		warn("Wrong pv:\n");
+		board_print(&r->board, r->player, stderr);
+		fprintf(stderr, "setboard %s\nplay ", board_to_string(&r->board, r->player, s));
+		line_print(&r->pv, 200, " ", stderr);
+		putc('\n', stderr); putc('\n', stderr);
+		assert(false); // stop here when debug is on
+	}
+
+	if (test->verbosity == 0) {
+		printf("%s  game: %4d, error: %2d ; ", test->file, i + 1, test->n_failure);
+		printf("%lld n, ", test->n_nodes); time_print(test->time, false, stdout); putchar(' ');
+		batch_print_rate(batch, i + 1, stdout); putchar('\r');
+		fflush(stdout);
+	}
+}
+
+/**
+ * @brief Test Search with a wthor base.
+ *
+ * @param file Game File.
+ * @param search Search.
+ */
+void wthor_test(const char *file, Search *search)
+{
+	WthorTest test;
+	Batch batch;
+
+	if (wthor_map(&test.base, file)) {
+		test.file = file;
+		test.level = 60;
+		test.n_failure = 0;
+		test.n_nodes = 0;
+		test.time = 0;
+		test.verbosity = options.n_search > 1 ? 0 : search->options.verbosity;
+		test.histogram = NULL;
+		test.result = (WthorTestResult*) malloc((test.base.n_games + 1) * sizeof (WthorTestResult));
+		if (test.result == NULL) fatal_error("Cannot allocate wthor test results\n");
+
+		if (test.verbosity == 1) {
+			if (search->options.header) puts(search->options.header);
+			if (search->options.separator) puts(search->options.separator);
 		}
-		if (search->options.verbosity == 1) {
+
+		batch.run = wthor_test_run;
+		batch.report = wthor_test_report;
+		batch.observer = NULL;
+		batch.data = &test;
+		batch_run(&batch, search, test.base.n_games);
+
+		if (test.verbosity == 1) {
 			if (search->options.separator) puts(search->options.separator);
 		}
 		putchar('\n');
+		printf("%d games, %d errors, %d searches: ", test.base.n_games, test.n_failure, batch.n_search);
+		batch_print_rate(&batch, test.base.n_games, stdout); putchar('\n');
 
-		wthor_free(&base);
+		free(test.result);
+		wthor_free(&test.base);
 	}
 	return;
 }
 
+/**
+ * @brief Report a wthor game evaluation.
+ *
+ * @param batch Batch.
+ * @param i Game index.
+ */
+static void wthor_eval_report(Batch *batch, const int i)
+{
+	WthorTest *test = (WthorTest*) batch->data;
+	WthorTestResult *r = test->result + i;
+
+	if (r->status == 0) ++test->histogram[r->edax_score + 64][(r->score + 64) / 2];
+}
+
 /**
  * @brief Test Eval with a wthor base.
  *
@@ -609,34 +944,30 @@ void wthor_test(const char *file, Search *search)
  */
 void wthor_eval(const char *file, Search *search, unsigned long long histogram[129][65])
 {
-	WthorBase base;
-	WthorGame *wthor;
-	Board board;
-	int player;
-	int score;
-	int n_empties;
-
-	if (wthor_load(&base, file)) {
-		foreach_wthorgame(wthor, base) {
-			wthorgame_get_board(wthor, base.header.depth, &board, &player);
-			n_empties = board_count_empties(&board);
-			if (n_empties != base.header.depth && !board_is_game_over(&board)) {
-				continue;
-			}
-
-			if (player == WHITE) score = 64 - 2 * wthor->theoric_score;
-			else score = 2 * wthor->theoric_score - 64;
-			if (abs(score) > 64) {
-				continue;
-			}
-
-			search_cleanup(search);
-			search_set_board(search, &board, player);
-			search_set_level(search, options.level, base.header.depth);
-			search_run(search);
-			++histogram[search->result->score + 64][(score + 64) / 2];
-		}
-		wthor_free(&base);
+	WthorTest test;
+	Batch batch;
+
+	if (wthor_map(&test.base, file)) {
+		test.file = file;
+		test.level = options.level;
+		test.n_failure = 0;
+		test.n_nodes = 0;
+		test.time = 0;
+		test.verbosity = 0;
+		test.histogram = histogram;
+		test.result = (WthorTestResult*) malloc((test.base.n_games + 1) * sizeof (WthorTestResult));
+		if (test.result == NULL) fatal_error("Cannot allocate wthor test results\n");
+
+		batch.run = wthor_test_run;
+		batch.report = wthor_eval_report;
+		batch.observer = NULL;
+		batch.data = &test;
+		batch_run(&batch, search, test.base.n_games);
+		printf("%d games, %d searches: ", test.base.n_games, batch.n_search);
+		batch_print_rate(&batch, test.base.n_games, stdout); putchar('\n');
+
+		free(test.result);
+		wthor_free(&test.base);
 	}
 	return;
 }
@@ -673,6 +1004,8 @@ void base_init(Base *base)
 	base->size = 0;
 	base->n_games = 0;
 	base->game = NULL;
+	base->wthor = NULL;
+	file_map_init(&base->map);
 }
 
 /**
@@ -682,10 +1015,60 @@ void base_init(Base *base)
  */
 void base_free(Base *base)
 {
-	free(base->game);
+	if (base->map.data) file_unmap(&base->map);
+	else free(base->game);
 	base_init(base);
 }
 
+/**
+ * @brief Get a game from a game database.
+ *
+ * Games of a mapped wthor base are converted on the fly into the buffer;
+ * other games are returned in place.
+ *
+ * @param base Game base.
+ * @param i Game index.
+ * @param buffer Game buffer, used by converted games.
+ * @return The game.
+ */
+const Game* base_get_game(const Base *base, const int i, Game *buffer)
+{
+	assert(0 <= i && i < base->n_games);
+
+	if (base->wthor) {
+		wthor_to_game(base->wthor + i, buffer);
+		return buffer;
+	}
+	return base->game + i;
+}
+
+/**
+ * @brief Copy the games of a mapped database into memory.
+ *
+ * @param base Game base.
+ * @return true in case of success.
+ */
+static bool base_unmap(Base *base)
+{
+	Game *ptr, buffer;
+	int i, size = 16384;
+
+	while (size <= base->n_games) size *= 2;
+	ptr = (Game*) malloc(size * sizeof (Game));
+	if (ptr == NULL) {
+		error("cannot allocate base game");
+		return false;
+	}
+	for (i = 0; i < base->n_games; ++i) ptr[i] = *base_get_game(base, i, &buffer);
+
+	file_unmap(&base->map);
+	base->wthor = NULL;
+	base->game = ptr;
+	base->size = size;
+
+	return true;
+}
+
 /**
  * @brief Add a game to a game database.
  *
@@ -694,6 +1077,8 @@ void base_free(Base *base)
  */
 void base_append(Base *base, const Game *game)
 {
+	if (base->map.data && !base_unmap(base)) return;
+
 	if (base->n_games == base->size) {
 		Game *ptr;
 		int size = base->size;
@@ -778,6 +1163,52 @@ bool base_load(Base *base, const char *file)
 	return base->n_games > 0;
 }
 
+/**
+ * @brief Map a game database.
+ *
+ * Games of the fixed-record formats (.wtb & .edx) are read in place from a
+ * memory mapping of the file, and are neither copied nor required to be
+ * resident in memory, so that bases larger than RAM can be streamed through
+ * with base_get_game(). Other formats, or a non empty base, are loaded with
+ * base_load(). As with wthor_map(), a file whose size does not match its
+ * header, or is not made of whole records, is refused.
+ *
+ * @param base Game base.
+ * @param file Game filename.
+ */
+bool base_map(Base *base, const char *file)
+{
+	char ext[8];
+	int l;
+
+	l = strlen(file); strcpy(ext, file + l - 4); string_to_lowercase(ext);
+	if (base->n_games > 0 || (strcmp(ext, ".wtb") != 0 && strcmp(ext, ".edx") != 0)) return base_load(base, file);
+
+	base_free(base);
+	if (!file_map(&base->map, file)) return base_load(base, file);
+
+	if (strcmp(ext, ".wtb") == 0) {
+		WthorHeader header;
+		if (!wthor_map_header(&header, file, base->map.size)) {
+			file_unmap(&base->map);
+			return false;
+		}
+		base->wthor = (const WthorGame*) ((char*) base->map.data + WTHOR_HEADER_SIZE);
+		base->n_games = header.n_games;
+	} else {
+		if (base->map.size % sizeof (Game)) {
+			warn("%s: the size of the file is not a multiple of a game record (%d bytes)\n", file, (int) sizeof (Game));
+			file_unmap(&base->map);
+			return false;
+		}
+		base->game = (Game*) base->map.data;
+		base->n_games = base->map.size / sizeof (Game);
+	}
+	info("%d games mapped from %s\n", base->n_games, file);
+
+	return base->n_games > 0;
+}
+
 /**
  * @brief Save a game database.
  *
@@ -792,6 +1223,7 @@ void base_save(const Base *base, const char *file)
 	int i, l;
 	WthorBase wbase;
 	Base old;
+	Game game;
 
 	l = strlen(file); strcpy(ext, file + l - 4); string_to_lowercase(ext);
 	if (strcmp(ext, ".txt") == 0) save = game_export_text;
@@ -813,7 +1245,7 @@ void base_save(const Base *base, const char *file)
 	base_init(&old);
 	base_load(&old, file);
 	for (i = 0; i < base->n_games; ++i) {
-		base_append(&old, base->game + i);
+		base_append(&old, base_get_game(base, i, &game));
 	}
 
 	f = fopen(file, "w");
@@ -841,13 +1273,14 @@ void base_to_problem(Base *base, const int n_empties, const char *problem)
 {
 	int i;
 	Board board;
+	Game game;
 	char s[80];
 	FILE *f;
 
 	f = fopen(problem, "w");
 
 	for (i = 0; i < base->n_games; ++i) {
-		if (game_get_board(base->game + i, 60 - n_empties, &board)) {
+		if (game_get_board(base_get_game(base, i, &game), 60 - n_empties, &board)) {
 			board_to_string(&board, n_empties & 1, s);
 			fprintf(f, "%s\n", s);
 		}
@@ -867,12 +1300,13 @@ void base_to_FEN(Base *base, const int n_empties, const char *problem)
 {
 	int i;
 	Board board;
+	Game game;
 	FILE *f;
 
 	f = fopen(problem, "w");
 
 	for (i = 0; i < base->n_games; ++i) {
-		if (game_get_board(base->game + i, 60 - n_empties, &board)) {
+		if (game_get_board(base_get_game(base, i, &game), 60 - n_empties, &board)) {
 			board_print_FEN(&board, n_empties & 1, f);
 			putc('\n', f);
 		}
@@ -881,32 +1315,74 @@ void base_to_FEN(Base *base, const int n_empties, const char *problem)
 	fclose(f);
 }
 
+/** Result of a game analysis. */
+typedef struct BaseAnalysisResult {
+	Game game;                                /**< analyzed (corrected) game */
+	int n_error;                              /**< number of errors found (-1 if not analyzed) */
+	bool failed;                              /**< correction failed */
+} BaseAnalysisResult;
+
+/** Data of a base analysis batch. */
+typedef struct BaseAnalysis {
+	Base *base;                               /**< game base */
+	BaseAnalysisResult *result;               /**< result, for each game */
+	int n_empties;                            /**< number of empties */
+	bool apply_correction;                    /**< correct bad moves */
+	bool *completed;                          /**< completed games (base_complete) */
+	int n_completed;                          /**< number of completed games (base_complete) */
+} BaseAnalysis;
+
 /**
- * @brief Base analysis.
+ * @brief Analyze a game of a base.
  *
- * @param base Game base.
+ * The game is analyzed on a copy, so that the original game can still be
+ * reported in order.
+ *
+ * @param batch Batch.
  * @param search Search engine.
- * @param n_empties Number of empties.
- * @param apply_correction Correct bad moves from the games.
+ * @param i Game index.
  */
-void base_analyze(Base *base, Search *search, const int n_empties, const bool apply_correction)
+static void base_analyze_run(Batch *batch, Search *search, const int i)
 {
-	int i;
-	int n_error;
+	BaseAnalysis *analysis = (BaseAnalysis*) batch->data;
+	BaseAnalysisResult *r = analysis->result + i;
 
-	for (i = 0; i < base->n_games; ++i) {
-		if (game_score(base->game + i) == 0) continue;
+	r->n_error = -1;
+	r->failed = false;
+	r->game = analysis->base->game[i];
+	if (game_score(&r->game) == 0) return;
+
+	r->n_error = game_analyze(&r->game, search, analysis->n_empties, analysis->apply_correction);
+	if (r->n_error && analysis->apply_correction) {
+		r->failed = (game_analyze(&r->game, search, analysis->n_empties, false) != 0);
+	}
+}
+
+/**
+ * @brief Report a game analysis.
+ *
+ * @param batch Batch.
+ * @param i Game index.
+ */
+static void base_analyze_report(Batch *batch, const int i)
+{
+	BaseAnalysis *analysis = (BaseAnalysis*) batch->data;
+	BaseAnalysisResult *r = analysis->result + i;
+	Base *base = analysis->base;
+
+	if (r->n_error >= 0) {
 		game_export_text(base->game + i, stdout);
-		n_error = game_analyze(base->game + i, search, n_empties, apply_correction);
-		if (n_error) {
-			printf("Game #%d contains %d errors", i, n_error);
-			if (apply_correction) {
-				if (game_analyze(base->game + i, search, n_empties, false)) printf("... correction failed! ***BUG DETECTED!***\n");
+		if (r->n_error) {
+			printf("Game #%d contains %d errors", i, r->n_error);
+			if (analysis->apply_correction) {
+				if (r->failed) printf("... correction failed! ***BUG DETECTED!***\n");
 				else printf("... corrected!\n");
+				base->game[i] = r->game;
 			} else putchar('\n');
 		}
-		printf("%d/%d %.1f %% done.\r", i + 1, base->n_games, 100.0 * (i + 1) / base->n_games); fflush(stdout);
 	}
+	printf("%d/%d %.1f %% done, ", i + 1, base->n_games, 100.0 * (i + 1) / base->n_games);
+	batch_print_rate(batch, i + 1, stdout); putchar('\r'); fflush(stdout);
 }
 
 /**
@@ -914,21 +1390,131 @@ void base_analyze(Base *base, Search *search, const int n_empties, const bool ap
  *
  * @param base Game base.
  * @param search Search engine.
+ * @param n_empties Number of empties.
+ * @param apply_correction Correct bad moves from the games.
+ */
+void base_analyze(Base *base, Search *search, const int n_empties, const bool apply_correction)
+{
+	BaseAnalysis analysis;
+	Batch batch;
+
+	analysis.base = base;
+	analysis.n_empties = n_empties;
+	analysis.apply_correction = apply_correction;
+	analysis.result = (BaseAnalysisResult*) malloc((base->n_games + 1) * sizeof (BaseAnalysisResult));
+	if (analysis.result == NULL) fatal_error("Cannot allocate base analysis results\n");
+
+	batch.run = base_analyze_run;
+	batch.report = base_analyze_report;
+	batch.observer = NULL;
+	batch.data = &analysis;
+	batch_run(&batch, search, base->n_games);
+
+	printf("\n%d games analyzed by %d searches: ", base->n_games, batch.n_search);
+	batch_print_rate(&batch, base->n_games, stdout); putchar('\n');
+
+	free(analysis.result);
+}
+
+/**
+ * @brief Complete a game of a base.
+ *
+ * @param batch Batch.
+ * @param search Search engine.
+ * @param i Game index.
+ */
+static void base_complete_run(Batch *batch, Search *search, const int i)
+{
+	BaseAnalysis *analysis = (BaseAnalysis*) batch->data;
+
+	analysis->completed[i] = (game_complete(analysis->base->game + i, search) > 0);
+}
+
+/**
+ * @brief Print a search result of a game completion, on a new line.
+ *
+ * @param result Search result.
+ */
+static void base_complete_observer(Result *result)
+{
+	putchar('\n');
+	batch_output.observer(result);
+}
+
+/**
+ * @brief Report a game completion.
+ *
+ * @param batch Batch.
+ * @param i Game index.
+ */
+static void base_complete_report(Batch *batch, const int i)
+{
+	BaseAnalysis *analysis = (BaseAnalysis*) batch->data;
+	const int completed = analysis->completed[i];
+
+	analysis->n_completed += completed;
+	if (completed || (i % 1000) == 0) {
+		printf("%d/%d games completed (%.1f %% done, ", analysis->n_completed, i + 1, 100.0 * (i + 1) / analysis->base->n_games);
+		batch_print_rate(batch, i + 1, stdout); printf(").\r"); fflush(stdout);
+	}
+}
+
+/**
+ * @brief Base completion.
+ *
+ * @param base Game base.
+ * @param search Search engine.
  */
 void base_complete(Base *base, Search *search)
 {
-	int i, n;
-	int completed;
-
-	for (i = n = 0; i < base->n_games; ++i) {
-		completed = 0;
-		if (game_complete(base->game + i, search) > 0) completed = 1;
-		n += completed;
-		if (completed || (i % 1000) == 0) {
-			printf("%d/%d games completed (%.1f %% done).\r", n, i + 1, 100.0 * (i + 1) / base->n_games); fflush(stdout);
+	BaseAnalysis analysis;
+	Batch batch;
+
+	analysis.base = base;
+	analysis.n_completed = 0;
+	analysis.completed = (bool*) malloc((base->n_games + 1) * sizeof (bool));
+	if (analysis.completed == NULL) fatal_error("Cannot allocate base completion results\n");
+
+	batch.run = base_complete_run;
+	batch.report = base_complete_report;
+	batch.data = &analysis;
+	batch.observer = base_complete_observer;
+	batch_run(&batch, search, base->n_games);
+
+	printf("%d/%d games completed (all done, ", analysis.n_completed, base->n_games);
+	batch_print_rate(&batch, base->n_games, stdout); printf(").          \n");
+
+	free(analysis.completed);
+}
+
+/**
+ * @brief Measure the error of the 8-bit evaluation on a game base.
+ *
+ * Every position of every game is evaluated with both weight sets.
+ *
+ * @param file Game base file.
+ */
+void base_eval_error(const char *file)
+{
+	Base base;
+	EvalError error = {0, 0.0, 0.0, 0.0};
+	Board board;
+	Game buffer;
+	int i, j;
+
+	base_init(&base);
+	if (base_map(&base, file)) {
+		for (i = 0; i < base.n_games; ++i) {
+			const Game *game = base_get_game(&base, i, &buffer);
+			board = game->initial_board;
+			for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
+				if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
+				if (bit_count(~(board.player | board.opponent)) > 0) eval_error_add(&error, &board);
+			}
 		}
+		eval_error_print(&error, file, stdout);
 	}
-	printf("%d/%d games completed (all done).          \n", n, i + 1);
+	base_free(&base);
 }
 
 /**
@@ -944,6 +1530,7 @@ void base_compare(const char *file_1, const char *file_2)
 	Base base_1[1], base_2[2];
 	PositionHash hash;
 	Board board;
+	Game buffer;
 	int i, j;
 	long long n_1, n_2, n_2_only;
 
@@ -953,10 +1540,10 @@ void base_compare(const char *file_1, const char *file_2)
 	n_2 = 0;
 	n_2_only = 0;
 
-	base_load(base_1, file_1);
+	base_map(base_1, file_1);
 	positionhash_init(&hash, options.hash_table_size);
 	for (i = 0; i < base_1->n_games; ++i) {
-		Game *game = base_1->game + i;
+		const Game *game = base_get_game(base_1, i, &buffer);
 		board = game->initial_board;
 		for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
 			if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
@@ -967,9 +1554,9 @@ void base_compare(const char *file_1, const char *file_2)
 	}
 	base_free(base_1);
 
-	base_load(base_2, file_2);
+	base_map(base_2, file_2);
 	for (i = 0; i < base_2->n_games; ++i) {
-		Game *game = base_2->game + i;
+		const Game *game = base_get_game(base_2, i, &buffer);
 		board = game->initial_board;
 		for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
 			if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
@@ -982,7 +1569,7 @@ void base_compare(const char *file_1, const char *file_2)
 	positionhash_delete(&hash);
 	positionhash_init(&hash, options.hash_table_size);
 	for (i = 0; i < base_2->n_games; ++i) {
-		Game *game = base_2->game + i;
+		const Game *game = base_get_game(base_2, i, &buffer);
 		board = game->initial_board;
 		for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
 			if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
@@ -12,6 +12,7 @@
 #define EDAX_BASE_H
 
 #include "game.h"
+#include "util.h"
 #include <stdbool.h>
 
 /* structures */
@@ -43,17 +44,22 @@ typedef struct WthorBase {
 	int n_players;             /** tournament players */
 	WthorGame *game;           /** games */
 	int n_games;               /** n_games */
+	FileMap map;               /** file mapping (when games are mapped) */
 } WthorBase;
 
 typedef struct Base {
-	Game *game;
-	int n_games;
-	int size;
+	Game *game;                /** games (in memory, or mapped .edx records) */
+	const WthorGame *wthor;    /** mapped .wtb records, converted on access */
+	int n_games;               /** game number */
+	int size;                  /** allocated size (0 when mapped) */
+	FileMap map;               /** file mapping (when games are mapped) */
 } Base;
 
 /* function declarations */
 void wthor_init(WthorBase*);
 bool wthor_load(WthorBase*, const char*);
+bool wthor_map(WthorBase*, const char*);
+void wthor_free(WthorBase*);
 bool wthor_save(WthorBase*, const char*);
 void wthor_test(const char*, struct Search*);
 void wthor_eval(const char*, struct Search*, unsigned long long histogram[129][65]);
@@ -65,6 +71,8 @@ void wthor_edaxify(const char*);
 void base_init(Base*);
 void base_free(Base*);
 bool base_load(Base*, const char*);
+bool base_map(Base*, const char*);
+const Game* base_get_game(const Base*, const int, Game*);
 void base_save(const Base*, const char*);
 void base_append(Base*, const Game*);
 void base_to_problem(Base*, const int, const char*);
@@ -73,6 +81,7 @@ void base_analyze(Base*, struct Search*, const int, const bool);
 void base_complete(Base*, struct Search*);
 void base_unique(Base*);
 void base_compare(const char*, const char*);
+void base_eval_error(const char*);
 
 #endif /* EDAX_BASE_H */
 
@@ -6,14 +6,20 @@
  * @version 4.5
  */
 
+#include "bench.h"
 #include "bit.h"
 #include "board.h"
+#include "hash.h"
 #include "move.h"
+#include "obftest.h"
 #include "options.h"
 #include "search.h"
+#include "settings.h"
 #include "util.h"
 
+#include <ctype.h>
 #include <math.h>
+#include <string.h>
 
 /*
  * @brief return a CPU clock tick.
@@ -41,6 +47,34 @@ static unsigned long long click(void)
 #endif
 }
 
+/** a benchmark result (lower is better) */
+typedef struct BenchResult {
+	const char *name;  /**< benchmark name */
+	const char *unit;  /**< measure unit */
+	double value;      /**< measure */
+} BenchResult;
+
+/** results of the benchmarks run, for bench_suite */
+static BenchResult bench_result[32];
+static int bench_n_result = 0;
+
+/*
+ * @brief Record a benchmark result.
+ *
+ * @param name Benchmark name.
+ * @param unit Measure unit.
+ * @param value Measure.
+ */
+static void bench_record(const char *name, const char *unit, const double value)
+{
+	if (bench_n_result < (int) (sizeof bench_result / sizeof bench_result[0])) {
+		bench_result[bench_n_result].name = name;
+		bench_result[bench_n_result].unit = unit;
+		bench_result[bench_n_result].value = value;
+		++bench_n_result;
+	}
+}
+
 /*
  * @brief Move generator performance test.
  */
@@ -54,22 +88,10 @@ static void bench_move_generator(void)
 	volatile int v;
 	const int N_WARMUP = 1000;
 	const int N_REPEAT = 1000000;
-	unsigned long long c, overhead;
+	unsigned long long c;
 	double t, t_mean, t_var, t_min, t_max;
 
 	v = 0;
-	c = -click();
-	for (i = 0; i < N_WARMUP; ++i) {
-		v += i;
-	}
-	c += click();
-
-	c = -click();
-	for (i = 0; i < N_REPEAT; ++i) {
-		v += i;
-	}
-	c += click();
-	overhead = c;
 
 	t_mean = t_var = 0.0;
 	t_max = 0;
@@ -92,7 +114,7 @@ static void bench_move_generator(void)
 		}
 		c += click();
 
-		t = ((double)(c - overhead)) / N_REPEAT;
+		t = ((double) c) / N_REPEAT;
 		t_mean += t;
 		t_var += t * t;
 		if (t < t_min) t_min = t;
@@ -106,6 +128,7 @@ static void bench_move_generator(void)
 	t_var = t_var / x - (t_mean * t_mean);
 
 	printf("board_get_move_flip:  %.2f < %.2f +/- %.2f < %.2f\n", t_min, t_mean, sqrt(t_var), t_max);
+	bench_record("board_get_move_flip", "cycles", t_mean);
 }
 
 /*
@@ -120,23 +143,11 @@ static void bench_count_last_flip(void)
 	volatile int v;
 	const int N_WARMUP = 1000;
 	const int N_REPEAT = 1000000;
-	unsigned long long c, overhead;
+	unsigned long long c;
 	double t, t_mean, t_var, t_min, t_max;
 
 	v = 0;
 
-	c = -click();
-	for (i = 0; i < N_WARMUP; ++i) {
-		v += i;
-	}
-	c += click();
-
-	c = -click();
-	for (i = 0; i < N_REPEAT; ++i) {
-		v += i;
-	}
-	c += click();
-	overhead = c;
 
 	t_mean = t_var = 0.0;
 	t_max = 0;
@@ -159,7 +170,7 @@ static void bench_count_last_flip(void)
 		}
 		c += click();
 
-		t = ((double)(c - overhead)) / N_REPEAT;
+		t = ((double) c) / N_REPEAT;
 		t_mean += t;
 		t_var += t * t;
 		if (t < t_min) t_min = t;
@@ -173,6 +184,7 @@ static void bench_count_last_flip(void)
 	t_var = t_var / x - (t_mean * t_mean);
 
 	printf("count_last_flip:  %.2f < %.2f +/- %.2f < %.2f\n", t_min, t_mean, sqrt(t_var), t_max);
+	bench_record("count_last_flip", "cycles", t_mean);
 }
 
 /*
@@ -187,24 +199,12 @@ static void bench_board_score_1(void)
 	volatile int v;
 	const int N_WARMUP = 1000;
 	const int N_REPEAT = 1000000;
-	unsigned long long c, overhead;
+	unsigned long long c;
 	double t, t_mean, t_var, t_min, t_max;
 
 	board_set(&board, b);
 	v = 0;
 
-	c = -click();
-	for (i = 0; i < N_WARMUP; ++i) {
-		v += i;
-	}
-	c += click();
-
-	c = -click();
-	for (i = 0; i < N_REPEAT; ++i) {
-		v += i;
-	}
-	c += click();
-	overhead = c;
 
 	t_mean = t_var = 0.0;
 	t_max = 0;
@@ -227,7 +227,7 @@ static void bench_board_score_1(void)
 		}
 		c += click();
 
-		t = ((double)(c - overhead)) / N_REPEAT;
+		t = ((double) c) / N_REPEAT;
 		t_mean += t;
 		t_var += t * t;
 		if (t < t_min) t_min = t;
@@ -241,6 +241,7 @@ static void bench_board_score_1(void)
 	t_var = t_var / x - (t_mean * t_mean);
 
 	printf("board_score_1:  %.2f < %.2f +/- %.2f < %.2f\n", t_min, t_mean, sqrt(t_var), t_max);
+	bench_record("board_score_1", "cycles", t_mean);
 }
 
 /*
@@ -255,28 +256,10 @@ static void bench_mobility(void)
 	volatile int v;
 	const int N_WARMUP = 1000;
 	const int N_REPEAT = 1000000;
-	unsigned long long c, overhead;
+	unsigned long long c;
 	double t, t_mean, t_var, t_min, t_max;
 
-	board_set(&board, b);
 	v = 0;
-	c = -click();
-	for (i = 0; i < N_WARMUP; ++i) {
-		board.player &= ~i;
-		board.opponent &= ~i;
-		v += i;
-	}
-	c += click();
-
-	board_set(&board, b);
-	c = -click();
-	for (i = 0; i < N_REPEAT; ++i) {
-		board.player &= ~i;
-		board.opponent &= ~i;
-		v += i;
-	}
-	c += click();
-	overhead = 0;
 
 	t_mean = t_var = 0.0;
 	t_max = 0;
@@ -305,7 +288,7 @@ static void bench_mobility(void)
 		}
 		c += click();
 
-		t = ((double)(c - overhead)) / N_REPEAT / 2;
+		t = ((double) c) / N_REPEAT / 2;
 		t_mean += t;
 		t_var += t * t;
 		if (t < t_min) t_min = t;
@@ -319,6 +302,7 @@ static void bench_mobility(void)
 	t_var = t_var / x - (t_mean * t_mean);
 
 	printf("mobility:  %.2f < %.2f +/- %.2f < %.2f\n", t_min, t_mean, sqrt(t_var), t_max);
+	bench_record("mobility", "cycles", t_mean);
 }
 
 /*
@@ -333,28 +317,10 @@ static void bench_stability(void)
 	volatile int v;
 	const int N_WARMUP = 1000;
 	const int N_REPEAT = 1000000;
-	unsigned long long c, overhead;
+	unsigned long long c;
 	double t, t_mean, t_var, t_min, t_max;
 
-	board_init(&board);
-
 	v = 0;
-	x = A1;
-	c = -click();
-	for (i = 0; i < N_WARMUP; ++i) {
-		board.player &= ~x_to_bit(x);
-		board.opponent &= ~x_to_bit(x);
-	}
-	c += click();
-
-	board_set(&board, b);
-	c = -click();
-	for (i = 0; i < N_REPEAT; ++i) {
-		board.player &= ~x_to_bit(x);
-		board.opponent &= ~x_to_bit(x);
-	}
-	c += click();
-	overhead = c;
 
 	t_mean = t_var = 0.0;
 	t_max = 0;
@@ -381,7 +347,7 @@ static void bench_stability(void)
 		}
 		c += click();
 
-		t = ((double)(c - overhead)) / N_REPEAT;
+		t = ((double) c) / N_REPEAT;
 		t_mean += t;
 		t_var += t * t;
 		if (t < t_min) t_min = t;
@@ -395,6 +361,310 @@ static void bench_stability(void)
 	t_var = t_var / x - (t_mean * t_mean);
 	
 	printf("stability:  %.2f < %.2f +/- %.2f < %.2f\n", t_min, t_mean, sqrt(t_var), t_max);
+	bench_record("stability", "cycles", t_mean);
+}
+
+/*
+ * @brief Evaluation function performance test.
+ *
+ * Measure the feature update after a move (eval_update_leaf) & the weight
+ * accumulation (search_eval_0), with the instruction set they are built for.
+ */
+static void bench_eval(void)
+{
+	const char *update_isa = EVAL_UPDATE_ISA;
+	const char *accumulate_isa = EVAL_ACCUMULATE_ISA;
+	Search search;
+	Board board;
+	Move move;
+	Eval eval;
+	Random r;
+	unsigned long long moves;
+	int i, k, x, n_update;
+	volatile int v;
+	const int N_REPEAT = 100000;
+	unsigned long long c_update, c_accumulate;
+
+	search_init(&search);
+	random_seed(&r, 42);
+	v = 0;
+	c_update = c_accumulate = 0;
+	n_update = 0;
+
+	for (k = 0; k < 32; ++k) {
+		board_rand(&board, 20 + k / 2, &r);
+		search_set_board(&search, &board, BLACK);
+
+		c_accumulate -= click();
+		for (i = 0; i < N_REPEAT; ++i) {
+			v += search_eval_0(&search);
+		}
+		c_accumulate += click();
+
+		moves = board_get_moves(&board);
+		foreach_bit (x, moves) {
+			board_get_move_flip(&board, x, &move);
+			c_update -= click();
+			for (i = 0; i < N_REPEAT; ++i) {
+				eval_update_leaf(x, move.flipped, &eval, &search.eval);
+				v += eval.feature.us[i & 31];
+			}
+			c_update += click();
+			++n_update;
+		}
+	}
+	search_free(&search);
+
+	printf("eval_update (%s):  %.2f\n", update_isa, n_update ? ((double) c_update) / ((double) n_update * N_REPEAT) : 0.0);
+	printf("search_eval_0 (%s):  %.2f\n", accumulate_isa, ((double) c_accumulate) / (32.0 * N_REPEAT));
+	bench_record("eval_update", "cycles", n_update ? ((double) c_update) / ((double) n_update * N_REPEAT) : 0.0);
+	bench_record("search_eval_0", "cycles", ((double) c_accumulate) / (32.0 * N_REPEAT));
+}
+
+/*
+ * @brief Depth-2 midgame evaluation performance test.
+ *
+ * Compare search_eval_2 with & without the batched evaluation of the leaves.
+ */
+static void bench_search_eval_2(void)
+{
+	Search search;
+	Board board[64];
+	Random r;
+	int i, k, b;
+	volatile int v;
+	const int N_REPEAT = 10000;
+	const bool eval_batch = options.eval_batch;
+	unsigned long long c;
+	double t[2];
+
+	search_init(&search);
+	random_seed(&r, 42);
+	for (k = 0; k < 64; ++k) board_rand(board + k, 20 + k / 4, &r);
+	v = 0;
+
+	for (b = 0; b < 2; ++b) {
+		options.eval_batch = b;
+		c = 0;
+		for (k = 0; k < 64; ++k) {
+			search_set_board(&search, board + k, BLACK);
+			c -= click();
+			for (i = 0; i < N_REPEAT; ++i) {
+				v += search_eval_2(&search, SCORE_MIN, SCORE_MAX, board_get_moves(&search.board));
+			}
+			c += click();
+		}
+		t[b] = ((double) c) / (64 * N_REPEAT);
+	}
+	options.eval_batch = eval_batch;
+	search_free(&search);
+
+	printf("search_eval_2: %.2f (unbatched) -> %.2f (batched): x%.2f\n", t[0], t[1], t[0] / t[1]);
+	bench_record("search_eval_2", "cycles", t[options.eval_batch]);
+}
+
+/*
+ * @brief Hash table performance test.
+ *
+ * Store, then probe, random positions in a 64K entries table.
+ */
+static void bench_hash(void)
+{
+	HashTable hash_table = { NULL, NULL, NULL, 0, 0, 0, 0, 0 };
+	HashStoreData store;
+	HashData data;
+	Board board[1024];
+	unsigned long long hash_code[1024];
+	Random r;
+	int i, k;
+	volatile int v;
+	const int N = 1024;
+	const int N_REPEAT = 1000;
+	unsigned long long c_store, c_get;
+
+	hash_init(&hash_table, 1 << 16);
+	random_seed(&r, 42);
+	for (k = 0; k < N; ++k) {
+		board_rand(board + k, 10 + k % 40, &r);
+		hash_code[k] = board_get_hash_code(board + k);
+	}
+	store.data.wl.c.depth = 20;
+	store.data.wl.c.selectivity = NO_SELECTIVITY;
+	store.data.wl.c.cost = 10;
+	store.data.move[0] = store.data.move[1] = NOMOVE;
+	store.alpha = -2;
+	store.beta = 2;
+	v = 0;
+
+	c_store = c_get = 0;
+	for (i = 0; i < N_REPEAT; ++i) {
+		c_store -= click();
+		for (k = 0; k < N; ++k) {
+			store.score = (k & 7) - 4;
+			hash_store(&hash_table, board + k, hash_code[k], &store);
+		}
+		c_store += click();
+
+		c_get -= click();
+		for (k = 0; k < N; ++k) {
+			v += hash_get(&hash_table, board + k, hash_code[k], &data);
+		}
+		c_get += click();
+	}
+	hash_free(&hash_table);
+
+	printf("hash_store:  %.2f\n", ((double) c_store) / ((double) N * N_REPEAT));
+	printf("hash_get:  %.2f\n", ((double) c_get) / ((double) N * N_REPEAT));
+	bench_record("hash_store", "cycles", ((double) c_store) / ((double) N * N_REPEAT));
+	bench_record("hash_get", "cycles", ((double) c_get) / ((double) N * N_REPEAT));
+}
+
+/*
+ * @brief Small endgame solver performance test.
+ *
+ * Time search_solve_4 on 4 empties, & search_shallow on DEPTH_TO_SHALLOW_SEARCH
+ * empties, random positions, with null windows around several scores.
+ */
+static void bench_endgame(void)
+{
+	Search search;
+	Board board, board0;
+	Random r;
+	unsigned int parity0;
+	int i, k, n[2];
+	volatile int v;
+	const int N_REPEAT[2] = { 10000, 100 };
+	const int n_empties[2] = { 4, DEPTH_TO_SHALLOW_SEARCH };
+	unsigned long long c[2];
+
+	search_init(&search);
+	random_seed(&r, 42);
+	v = 0;
+
+	for (k = 0; k < 2; ++k) {
+		c[k] = n[k] = 0;
+		while (n[k] < 64) {
+			board_rand(&board, 60 - n_empties[k], &r);
+			search_set_board(&search, &board, BLACK);
+			if (search.eval.n_empties != n_empties[k]) continue;
+			board0 = search.board;
+			parity0 = search.eval.parity;
+
+			c[k] -= click();
+			for (i = 0; i < N_REPEAT[k]; ++i) {
+				if (k == 0) v += search_solve_4(&search, ((i & 7) - 4) * 2);
+				else {
+					v += search_shallow(&search, ((i & 7) - 4) * 2, false);
+					search.board = board0;
+					search.eval.parity = parity0;
+				}
+			}
+			c[k] += click();
+			++n[k];
+		}
+	}
+	search_free(&search);
+
+	printf("search_solve_4:  %.2f\n", ((double) c[0]) / ((double) n[0] * N_REPEAT[0]));
+	printf("search_shallow (%d empties):  %.2f\n", DEPTH_TO_SHALLOW_SEARCH, ((double) c[1]) / ((double) n[1] * N_REPEAT[1]));
+	bench_record("search_solve_4", "cycles", ((double) c[0]) / ((double) n[0] * N_REPEAT[0]));
+	bench_record("search_shallow", "cycles", ((double) c[1]) / ((double) n[1] * N_REPEAT[1]));
+}
+
+/** kernels timed by bench_kernels, in the order of its results */
+static const char *BENCH_KERNEL_NAME[] = {"get_moves", "flip", "last_flip", "eval_update"};
+
+/** JSON names of the bench_kernels results */
+static const char *BENCH_KERNEL_RECORD[] = {"kernel_get_moves", "kernel_flip", "kernel_last_flip", "kernel_eval_update"};
+
+#ifdef EDAX_BENCH	// exported by each build of a dispatched executable (see dispatch.c)
+	#define	bench_kernels	EDAX_BENCH
+	void bench_kernels(double t[4]) __attribute__((externally_visible));
+#endif
+
+/**
+ * @brief Kernel performance on realistic positions.
+ *
+ * Time, on random positions, board_get_moves, board_get_move_flip on every
+ * legal move, last_flip on every empty square & eval_update on every legal
+ * move. Used to autotune a dispatched executable.
+ *
+ * @param t CPU cycles of each kernel (get_moves, flip, last flip & eval
+ *          update, as in BENCH_KERNEL_NAME), best of 3 runs (output).
+ */
+void bench_kernels(double t[4])
+{
+	Board board[64];
+	Move move;
+	Eval eval[64], next;
+	Random r;
+	unsigned long long moves, empties, c[4];
+	int i, k, n[4], x, run;
+	volatile unsigned long long v;
+	const int N_REPEAT = 1000;
+	double t_run;
+
+	random_seed(&r, 42);
+	for (k = 0; k < 64; ++k) {
+		board_rand(board + k, 10 + (k * 49) / 64, &r);
+		eval[k].n_empties = 0;
+		eval_set(eval + k, board + k);
+	}
+	for (i = 0; i < 4; ++i) t[i] = 1e30;
+	v = 0;
+
+	for (run = 0; run < 3; ++run) {
+		for (i = 0; i < 4; ++i) c[i] = n[i] = 0;
+		for (k = 0; k < 64; ++k) {
+			c[0] -= click();
+			for (i = 0; i < N_REPEAT; ++i) {
+				v += board_get_moves(board + ((k + i) & 63));
+			}
+			c[0] += click();
+			n[0] += 1;
+
+			moves = board_get_moves(board + k);
+			n[1] += bit_count(moves);
+			c[1] -= click();
+			for (i = 0; i < N_REPEAT; ++i) {
+				foreach_bit(x, moves) {
+					v += board_get_move_flip(board + k, x, &move);
+				}
+				moves = board_get_moves(board + k);
+			}
+			c[1] += click();
+
+			empties = ~(board[k].player | board[k].opponent);
+			n[2] += bit_count(empties);
+			c[2] -= click();
+			for (i = 0; i < N_REPEAT; ++i) {
+				foreach_bit(x, empties) {
+					v += last_flip(x, board[k].player & ~x_to_bit(x));
+				}
+				empties = ~(board[k].player | board[k].opponent);
+			}
+			c[2] += click();
+
+			moves = board_get_moves(board + k);
+			foreach_bit(x, moves) {
+				board_get_move_flip(board + k, x, &move);
+				c[3] -= click();
+				for (i = 0; i < N_REPEAT; ++i) {
+					eval_update_leaf(x, move.flipped, &next, eval + k);
+					v += next.feature.us[i & 31];
+				}
+				c[3] += click();
+				++n[3];
+			}
+		}
+		for (i = 0; i < 4; ++i) {
+			if (n[i] && (t_run = ((double) c[i]) / ((double) n[i] * N_REPEAT)) < t[i]) t[i] = t_run;
+		}
+	}
+
+	if (options.verbosity >= 2) {
+		for (i = 0; i < 4; ++i) printf("kernel %s: %.2f\n", BENCH_KERNEL_NAME[i], t[i]);
+	}
 }
 
 /**
@@ -402,12 +672,152 @@ static void bench_stability(void)
  */
 void bench(void)
 {
+	double t[4];
+	int i;
+
+	bench_n_result = 0;
 	printf("The unit of the results is CPU cycles\n");
 	bench_move_generator();
 	bench_count_last_flip();
 	bench_board_score_1();
 	bench_mobility();
 	bench_stability();
+	bench_eval();
+	bench_search_eval_2();
+	bench_hash();
+	bench_endgame();
+	bench_kernels(t);
+	for (i = 0; i < 4; ++i) {
+		printf("%s (random positions): %.2f\n", BENCH_KERNEL_NAME[i], t[i]);
+		bench_record(BENCH_KERNEL_RECORD[i], "cycles", t[i]);
+	}
+	bench_record("flip_last_flip", "cycles", t[1] + t[2]);
+}
+
+/*
+ * @brief Read a baseline result.
+ *
+ * Look for the line of a benchmark in a JSON file written by bench_suite:
+ * the line must hold a "name" key whose whole value is the benchmark name.
+ *
+ * @param f Baseline file.
+ * @param name Benchmark name.
+ * @param value Baseline measure (output).
+ * @param tolerance Tolerance of the benchmark, if given (output).
+ * @return true if the benchmark is found.
+ */
+static bool bench_baseline(FILE *f, const char *name, double *value, double *tolerance)
+{
+	char line[1024];
+	const char *s, *key;
+	const size_t n = strlen(name);
+
+	rewind(f);
+	while (fgets(line, sizeof line, f)) {
+		for (key = line; (key = strstr(key, "\"name\"")) != NULL; key += 6) {
+			if (key > line && key[-1] != '{' && key[-1] != ',' && !isspace((unsigned char) key[-1])) continue;
+			s = parse_skip_spaces(key + 6);
+			if (*s != ':') continue;
+			s = parse_skip_spaces(s + 1);
+			if (*s == '"' && strncmp(s + 1, name, n) == 0 && s[n + 1] == '"') break;
+		}
+		if (key && (s = strstr(line, "\"value\":"))) {
+			*value = strtod(s + 8, NULL);
+			if ((s = strstr(line, "\"tolerance\":"))) *tolerance = strtod(s + 12, NULL);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Run the benchmark suite, save it as JSON & compare it to a baseline.
+ *
+ * The suite is the microbenchmarks of bench(), plus the time & node count to
+ * solve the first positions of an OBF file, & the latency of random stops
+ * of these solvings (that must not exceed STOP_LATENCY_MAX). A result is a regression if it
+ * exceeds its baseline value by more than the tolerance, given in percent,
+ * or by the baseline entry itself ("tolerance" field).
+ *
+ * @param json_file Output JSON file ("-" for stdout), or NULL.
+ * @param baseline_file Baseline JSON file, or NULL.
+ * @param tolerance Default tolerance (%).
+ * @param obf_file OBF file, or NULL.
+ * @param n_obf Number of positions of the OBF file to solve.
+ * @return the number of regressions.
+ */
+int bench_suite(const char *json_file, const char *baseline_file, const double tolerance, const char *obf_file, const int n_obf)
+{
+	Search search;
+	FILE *f;
+	unsigned long long time, n_nodes;
+	long long latency_max;
+	double base, tol, latency_mean;
+	int i, n_stop, n_helped, n_tasks, n_regression = 0;
+
+	bench();
+
+	if (obf_file) {
+		search_init(&search);
+		if (obf_bench(&search, obf_file, n_obf, &time, &n_nodes)) {
+			printf("%s (%d positions): %llu nodes in %llu ms\n", obf_file, n_obf, n_nodes, time);
+			bench_record("obf_time", "ms", (double) time);
+			bench_record("obf_nodes", "nodes", (double) n_nodes);
+		} else warn("bench: cannot read %s\n", obf_file);
+		n_tasks = MAX(search.tasks->n, STOP_TEST_TASKS);
+		if ((n_stop = obf_stop_latency(obf_file, n_obf, n_tasks, STOP_TEST_SEARCHES, &latency_max, &latency_mean, &n_helped)) > 0) {
+			printf("stop latency (%d random stops, %d with split helpers, %d tasks, %d concurrent searches): mean %.1f ms, max %lld ms\n",
+				n_stop, n_helped, n_tasks, STOP_TEST_SEARCHES, latency_mean, latency_max);
+			bench_record("stop_latency_mean", "ms", latency_mean);
+			bench_record("stop_latency_max", "ms", (double) latency_max);
+			if (latency_max > STOP_LATENCY_MAX || n_helped == 0) {
+				printf("stop latency: %lld ms (bound %d ms), %d stops with split helpers, FAILURE\n", latency_max, STOP_LATENCY_MAX, n_helped);
+				++n_regression;
+			}
+		}
+		search_free(&search);
+	}
+
+	if (json_file) {
+		f = (strcmp(json_file, "-") == 0 ? stdout : fopen(json_file, "w"));
+		if (f == NULL) warn("bench: cannot write %s\n", json_file);
+		else {
+			fprintf(f, "{\n\t\"version\": \"" VERSION_STRING "\",\n\t\"eval_update\": \"" EVAL_UPDATE_ISA "\",\n\t\"eval_accumulate\": \"" EVAL_ACCUMULATE_ISA "\",\n\t\"results\": [\n");
+			for (i = 0; i < bench_n_result; ++i) {
+				fprintf(f, "\t\t{ \"name\": \"%s\", \"value\": %.3f, \"unit\": \"%s\" }%s\n",
+					bench_result[i].name, bench_result[i].value, bench_result[i].unit, i + 1 < bench_n_result ? "," : "");
+			}
+			fprintf(f, "\t]\n}\n");
+			if (f != stdout) fclose(f);
+		}
+	}
+
+	if (baseline_file) {
+		f = fopen(baseline_file, "r");
+		if (f == NULL) {
+			warn("bench: cannot read %s\n", baseline_file);
+			return 1;
+		}
+		printf("\n%-20s %12s %12s %8s\n", "benchmark", "baseline", "current", "change");
+		for (i = 0; i < bench_n_result; ++i) {
+			tol = tolerance;
+			if (!bench_baseline(f, bench_result[i].name, &base, &tol)) {
+				printf("%-20s %12s %12.2f\n", bench_result[i].name, "-", bench_result[i].value);
+				continue;
+			}
+			printf("%-20s %12.2f %12.2f %+7.1f%%", bench_result[i].name, base, bench_result[i].value,
+				base > 0 ? 100.0 * (bench_result[i].value - base) / base : 0.0);
+			if (bench_result[i].value > base * (1.0 + tol / 100.0)) {
+				printf(" REGRESSION (> %.1f%%)", tol);
+				++n_regression;
+			}
+			putchar('\n');
+		}
+		fclose(f);
+		printf("%d regression(s)\n", n_regression);
+	}
+
+	return n_regression;
 }
 
 
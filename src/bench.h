@@ -0,0 +1,17 @@
+/**
+ * @file bench.h
+ *
+ * @brief Performance benchmarks.
+ *
+ * @date 1998 - 2023
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#ifndef EDAX_BENCH_H
+#define EDAX_BENCH_H
+
+void bench(void);
+int bench_suite(const char*, const char*, const double, const char*, const int);
+
+#endif /* EDAX_BENCH_H */
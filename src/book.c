@@ -27,6 +27,7 @@
 #include <time.h>
 #include <stdarg.h>
 #include <limits.h>
+#include <string.h>
 
 #define BOOK_DEBUG 0
 static const int BOOK_INFO_RESOLUTION = 100000;
@@ -102,6 +103,132 @@ static inline bool link_is_bad(const Link *link)
 	return link->score == -SCORE_INF;
 }
 
+/** Number of link array capacity classes (4, 8, 16, 32 & 64 links). */
+#define LINK_SLAB_CLASSES 5
+
+/** Maximal number of links of an array. */
+#define LINK_SLAB_MAX (4 << (LINK_SLAB_CLASSES - 1))
+
+/** Size of a link slab block, in links. */
+#define LINK_SLAB_BLOCK 65536
+
+/**
+ * struct LinkSlab
+ * @brief Allocator for the link arrays of the book positions.
+ *
+ * Link arrays are carved from large blocks, with their capacity rounded up to
+ * a power of 2. The capacity is implied by the number of links, so no size is
+ * stored. Freed arrays are kept on per-capacity free lists.
+ */
+typedef struct LinkSlab {
+	Link *free[LINK_SLAB_CLASSES];  /**< free lists, by capacity class */
+	Link **block;                   /**< allocated blocks */
+	int n_blocks;                   /**< number of allocated blocks */
+	int used;                       /**< links used in the last block */
+} LinkSlab;
+
+/**
+ * @brief Capacity class of a link array.
+ *
+ * @param n Number of links (> 0).
+ * @return the smallest class able to hold n links.
+ */
+static inline int link_slab_class(const int n)
+{
+	int c = 0;
+
+	assert(0 < n && n <= LINK_SLAB_MAX);
+	while ((4 << c) < n) ++c;
+	return c;
+}
+
+/**
+ * @brief Capacity of a link array.
+ *
+ * @param n Number of links.
+ * @return the (minimal) capacity of the array holding n links.
+ */
+static inline int link_slab_capacity(const int n)
+{
+	return n ? 4 << link_slab_class(n) : 0;
+}
+
+/**
+ * @brief Initialize a link slab.
+ *
+ * @param slab Link slab.
+ */
+static void link_slab_init(LinkSlab *slab)
+{
+	int c;
+
+	for (c = 0; c < LINK_SLAB_CLASSES; ++c) slab->free[c] = NULL;
+	slab->block = NULL;
+	slab->n_blocks = 0;
+	slab->used = LINK_SLAB_BLOCK;
+}
+
+/**
+ * @brief Allocate a link array.
+ *
+ * @param slab Link slab.
+ * @param n Number of links (> 0).
+ * @return a link array, or NULL if memory is exhausted.
+ */
+static Link* link_slab_alloc(LinkSlab *slab, const int n)
+{
+	const int c = link_slab_class(n);
+	Link *l = slab->free[c];
+
+	if (l) {
+		memcpy(slab->free + c, l, sizeof (Link*));
+	} else {
+		if (slab->used + (4 << c) > LINK_SLAB_BLOCK) {
+			Link **block = (Link**) realloc(slab->block, (slab->n_blocks + 1) * sizeof (Link*));
+			if (block == NULL) return NULL;
+			slab->block = block;
+			block[slab->n_blocks] = (Link*) malloc(LINK_SLAB_BLOCK * sizeof (Link));
+			if (block[slab->n_blocks] == NULL) return NULL;
+			++slab->n_blocks;
+			slab->used = 0;
+		}
+		l = slab->block[slab->n_blocks - 1] + slab->used;
+		slab->used += 4 << c;
+	}
+
+	return l;
+}
+
+/**
+ * @brief Free a link array.
+ *
+ * @param slab Link slab.
+ * @param l Link array.
+ * @param n Number of links of the array.
+ */
+static void link_slab_free(LinkSlab *slab, Link *l, const int n)
+{
+	if (l && n) {
+		const int c = link_slab_class(n);
+		memcpy(l, slab->free + c, sizeof (Link*));
+		slab->free[c] = l;
+	}
+}
+
+/**
+ * @brief Free all the link arrays of a slab.
+ *
+ * @param slab Link slab.
+ */
+static void link_slab_release(LinkSlab *slab)
+{
+	int i;
+
+	for (i = 0; i < slab->n_blocks; ++i) free(slab->block[i]);
+	free(slab->block);
+	link_slab_init(slab);
+}
+
 /**
  * struct Position
  * @brief A position stored in the book.
@@ -121,9 +248,11 @@ typedef struct Position {
 	unsigned char level;       /**< search level */
 	unsigned char done;        /**< done/undone flag */
 	unsigned char todo;        /**< todo flag */
+	unsigned char dirty;       /**< modified since last saved or journaled */
 } Position;
 
 static Position* book_probe(const Book*, const Board*);
+static Position* book_get_position(const Book*, const Board*, Position*);
 static void book_add(Book*, const Position*);
 static void position_print(const Position*, const Board*, FILE*);
 
@@ -266,6 +395,7 @@ static void position_init(Position *position)
 	position->level = 0;
 	position->done = true;
 	position->todo = false;
+	position->dirty = true;
 }
 
 /**
@@ -302,21 +432,22 @@ static void position_merge(Position *dest, const Position *src)
  * @brief Free resources used by a position.
  *
  * @param position Position.
+ * @param book Opening book owning the position's links.
  */
-static void position_free(Position *position)
+static void position_free(Position *position, Book *book)
 {
-	free(position->link);
+	link_slab_free(book->links, position->link, position->n_link);
 }
 
 /**
- * @brief Read a position.
+ * @brief Read a position, without its links.
  *
  * @param position Position to read in.
- * @param f Input stream.
+ * @param f Input stream, left on the position's links.
+ * @return true in case of success.
  */
-static bool position_read(Position *position, FILE *f)
+static bool position_read_fields(Position *position, FILE *f)
 {
-	int i;
 	int r;
 
 	r  = fread(&position->board.player, sizeof (unsigned long long), 1, f);
@@ -337,10 +468,34 @@ static bool position_read(Position *position, FILE *f)
 	if (r != 11) return false;
 
 	position->done = position->todo = false;
+	position->dirty = true;
+
+	return true;
+}
+
+/**
+ * @brief Read a position.
+ *
+ * @param position Position to read in.
+ * @param f Input stream.
+ * @param book Opening book to allocate the position's links from.
+ */
+static bool position_read(Position *position, FILE *f, Book *book)
+{
+	int i;
+
+	if (!position_read_fields(position, f)) return false;
 
+	if (position->n_link > LINK_SLAB_MAX) {
+		error("bad number of links (%d) in an opening book position\n", position->n_link);
+		return false;
+	}
 	if (position->n_link) {
-		position->link = (Link*) malloc(sizeof (Link) * position->n_link);
-		if (position->link == NULL) error("cannot allocate opening book position's moves\n");
+		position->link = link_slab_alloc(book->links, position->n_link);
+		if (position->link == NULL) {
+			error("cannot allocate opening book position's moves\n");
+			return false;
+		}
 		for (i = 0; i < position->n_link; ++i) {
 			if (!link_read(position->link + i, f)) return false;
 		}
@@ -625,9 +780,10 @@ static void position_get_random_move(const Position *position, const Board *boar
  *
  * @param position Position to chose a move from.
  * @param link Link to add.
+ * @param book Opening book owning the position's links.
  * @return true if the link has been added, false if it was already present.
  */
-static bool position_add_link(Position *position, const Link *link)
+static bool position_add_link(Position *position, const Link *link, Book *book)
 {
 	Link *l;
 	int last = position->n_link;
@@ -635,22 +791,28 @@ static bool position_add_link(Position *position, const Link *link)
 	foreach_link (l, position) {
 		if (l->move == link->move) {
 			l->score = link->score; // update the link ?
+			position->dirty = true;
 			return false;
 		}
 	}
 
-	l = (Link*) realloc(position->link, sizeof (Link) * (++position->n_link));
-	if (l == NULL) {
-		--position->n_link;
-		error("cannot allocate opening book position's moves\n");
-		return false;
+	if (link_slab_capacity(last) == last) {
+		l = link_slab_alloc(book->links, last + 1);
+		if (l == NULL) {
+			error("cannot allocate opening book position's moves\n");
+			return false;
+		}
+		if (last) memcpy(l, position->link, last * sizeof (Link));
+		link_slab_free(book->links, position->link, last);
+		position->link = l;
 	}
-	position->link = l;
 	position->link[last] = *link;
+	++position->n_link;
 
 	if (link->score > position->score.value) position->score.value = link->score;
 
 	if (link->move == position->leaf.move) position->leaf = BAD_LINK;
+	position->dirty = true;
 
 	return true;
 }
@@ -695,7 +857,7 @@ static void position_search(Position *position, Book *book)
 	long long time;
 	bool time_per_move;
 
-	if (position->leaf.move != NOMOVE && position_add_link(position, &position->leaf)) {
+	if (position->leaf.move != NOMOVE && position_add_link(position, &position->leaf, book)) {
 		book->need_saving = true;
 		++book->stats.n_links;
 	}
@@ -730,47 +892,83 @@ static void position_search(Position *position, Book *book)
 			position->score.value = position->leaf.score;
 		}
 		book->need_saving = true;
+		position->dirty = true;
 	}
 }
 
 /**
- * @brief Link a position.
+ * @brief Find the children of a position in the book.
  *
- * Find moves that lead to other positions in the book.
+ * Only reads the book, so that positions can be probed concurrently.
  *
- * @param position Position to link.
+ * @param position Position.
  * @param book Opening book.
+ * @param child Output children, indexed by move, NULL if not in the book.
  */
-static void position_link(Position *position, Book *book)
+static void position_probe_children(const Position *position, const Book *book, Position **child)
 {
 	int x;
 	unsigned long long moves = board_get_moves(&position->board);
 	Board next;
-	Link link;
-	Position *child;
 
 	if (moves) {
 		foreach_bit(x, moves) {
 			board_next(&position->board, x, &next);
-			child = book_probe(book, &next);
-			if (child) {
-				link.score = -child->score.value;
-				link.move = x;
-				book->stats.n_links += position_add_link(position, &link);
-			}
+			child[x] = book_probe(book, &next);
 		}
 	} else if (can_move(position->board.opponent, position->board.player)) {// pass ?
 		next.player = position->board.opponent;
 		next.opponent = position->board.player;
-		child = book_probe(book, &next);
-		if (child) {
-			link.score = -child->score.value;
+		child[PASS] = book_probe(book, &next);
+	}
+}
+
+/**
+ * @brief Link a position to its probed children.
+ *
+ * @param position Position to link.
+ * @param book Opening book.
+ * @param child Children, as found by position_probe_children().
+ */
+static void position_add_children(Position *position, Book *book, Position **child)
+{
+	int x;
+	unsigned long long moves = board_get_moves(&position->board);
+	Link link;
+
+	if (moves) {
+		foreach_bit(x, moves) {
+			if (child[x]) {
+				link.score = -child[x]->score.value;
+				link.move = x;
+				book->stats.n_links += position_add_link(position, &link, book);
+			}
+		}
+	} else if (can_move(position->board.opponent, position->board.player)) {// pass ?
+		if (child[PASS]) {
+			link.score = -child[PASS]->score.value;
 			link.move = PASS;
-			book->stats.n_links += position_add_link(position, &link);
+			book->stats.n_links += position_add_link(position, &link, book);
 		}
 	}
 }
 
+/**
+ * @brief Link a position.
+ *
+ * Find moves that lead to other positions in the book.
+ *
+ * @param position Position to link.
+ * @param book Opening book.
+ */
+static void position_link(Position *position, Book *book)
+{
+	Position *child[PASS + 1];
+
+	position_probe_children(position, book, child);
+	position_add_children(position, book, child);
+}
+
 /**
  * @brief Expand a position.
  *
@@ -801,6 +999,76 @@ static void position_expand(Position *position, Book *book)
 	}
 }
 
+/**
+ * @brief Negamax a position from its children.
+ *
+ * The children must have been negamaxed already. Only the position itself is
+ * modified, so that positions of a same layer can be negamaxed concurrently.
+ *
+ * @param position Position to negamax.
+ * @param book Opening book.
+ * @param child Children, in link order.
+ * @return true if the position has changed.
+ */
+static bool position_minimax(Position *position, const Book *book, Position **child)
+{
+	Link *l;
+	const Position old = *position;
+	GameStats stat = {0,0,0,0};
+	const int n_empties = board_count_empties(&position->board);
+	const int search_depth = LEVEL[position->level][n_empties].depth;
+	const int bias = (search_depth & 1) - (n_empties & 1);
+	bool changed = false;
+
+	position->score.value = position->score.lower = position->score.upper = -SCORE_INF;
+
+	if (position->leaf.score > -SCORE_INF) {
+		position->score.value = position->leaf.score;
+		// is solving
+		if (search_depth == n_empties && LEVEL[position->level][n_empties].selectivity == NO_SELECTIVITY) {
+			position->score.lower = position->score.upper = position->score.value;
+			if (position->leaf.score > 0) ++stat.n_wins;
+			else if (position->leaf.score < 0) ++stat.n_losses;
+			else ++stat.n_draws;
+		// is pre-solving
+		} else if (search_depth == n_empties) {
+			position->score.lower = position->score.value - book->options.endcut_error;
+			position->score.upper = position->score.value + book->options.endcut_error;
+		} else { // midgame
+			position->score.lower = position->score.value - book->options.midgame_error - bias;
+			position->score.upper = position->score.value + book->options.midgame_error - bias;
+		}
+		++stat.n_lines;
+	}
+
+	foreach_link(l, position) {
+		const Position *c = *child++;
+		if (l->score != -c->score.value) {
+			l->score = -c->score.value;
+			changed = true;
+		}
+		if (l->score > position->score.value) position->score.value = l->score;
+		if (-c->score.upper > position->score.lower) position->score.lower = -c->score.upper;
+		if (-c->score.lower > position->score.upper) position->score.upper = -c->score.lower;
+
+		stat.n_wins += c->n_losses;
+		stat.n_draws += c->n_draws;
+		stat.n_losses += c->n_wins;
+		stat.n_lines += c->n_lines;
+	}
+
+	position->n_wins = (unsigned int) MIN(UINT_MAX, stat.n_wins);
+	position->n_draws = (unsigned int) MIN(UINT_MAX, stat.n_draws);
+	position->n_losses = (unsigned int) MIN(UINT_MAX, stat.n_losses);
+	position->n_lines = (unsigned int) MIN(UINT_MAX, stat.n_lines);
+
+	changed |= (position->score.value != old.score.value || position->score.lower != old.score.lower || position->score.upper != old.score.upper
+		|| position->n_wins != old.n_wins || position->n_draws != old.n_draws || position->n_losses != old.n_losses || position->n_lines != old.n_lines);
+	if (changed) position->dirty = true;
+
+	return changed;
+}
+
 /**
  * @brief Negamax a position.
  *
@@ -813,65 +1081,22 @@ static int position_negamax(Position *position, Book *book)
 {
 	Link *l;
 	Board target;
-	Position *child;
+	Position *child[MAX_MOVE + 1];
 
 	if (!position->done) {
-		GameStats stat = {0,0,0,0};
-		const int n_empties = board_count_empties(&position->board);
-		const int search_depth = LEVEL[position->level][n_empties].depth;
-		const int bias = (search_depth & 1) - (n_empties & 1);
-
 		position->done = 1;
 
-		position->score.value = position->score.lower = position->score.upper = -SCORE_INF;
-
-		if (position->leaf.score > -SCORE_INF) {
-			position->score.value = position->leaf.score;
-			// is solving
-			if (search_depth == n_empties && LEVEL[position->level][n_empties].selectivity == NO_SELECTIVITY) {
-				position->score.lower = position->score.upper = position->score.value;
-				if (position->leaf.score > 0) ++stat.n_wins;
-				else if (position->leaf.score < 0) ++stat.n_losses;
-				else ++stat.n_draws;
-			// is pre-solving
-			} else if (search_depth == n_empties) {
-				position->score.lower = position->score.value - book->options.endcut_error;
-				position->score.upper = position->score.value + book->options.endcut_error;
-			} else { // midgame
-				position->score.lower = position->score.value - book->options.midgame_error - bias;
-				position->score.upper = position->score.value + book->options.midgame_error - bias;
-			}
-			++stat.n_lines;
-		}
-
 		foreach_link(l, position) {
 			board_next(&position->board, l->move, &target);
-			child = book_probe(book, &target);
-			position_negamax(child, book);
-			if (l->score != -child->score.value) {
-				l->score = -child->score.value;
-				book->need_saving = true;
-			}
-			if (l->score > position->score.value) position->score.value = l->score;
-			if (-child->score.upper > position->score.lower) position->score.lower = -child->score.upper;
-			if (-child->score.lower > position->score.upper) position->score.upper = -child->score.lower;
-
-			stat.n_wins += child->n_losses;
-			stat.n_draws += child->n_draws;
-			stat.n_losses += child->n_wins;
-			stat.n_lines += child->n_lines;
+			child[l - position->link] = book_probe(book, &target);
+			position_negamax(child[l - position->link], book);
 		}
-
-		position->n_wins = (unsigned int) MIN(UINT_MAX, stat.n_wins);
-		position->n_draws = (unsigned int) MIN(UINT_MAX, stat.n_draws);
-		position->n_losses = (unsigned int) MIN(UINT_MAX, stat.n_losses);
-		position->n_lines = (unsigned int) MIN(UINT_MAX, stat.n_lines);
+		if (position_minimax(position, book, child)) book->need_saving = true;
 	}
 
 	return position->score.value;
 }
 
-
 /**
  * @brief Prune a position.
  *
@@ -916,6 +1141,7 @@ static void position_prune(Position *position, Book *book, const int player_devi
 static void position_remove_links(Position *position, Book *book)
 {
 	int i, j;
+	const int n_link = position->n_link;
 	Link *l = position->link;
 	Board target;
 
@@ -928,6 +1154,15 @@ static void position_remove_links(Position *position, Book *book)
 			--i;
 		}
 	}
+
+	// the capacity of the array is implied by its number of links: move it to its new class
+	if (link_slab_capacity(position->n_link) != link_slab_capacity(n_link)) {
+		l = position->n_link ? link_slab_alloc(book->links, position->n_link) : NULL;
+		if (l) memcpy(l, position->link, position->n_link * sizeof (Link));
+		else if (position->n_link) fatal_error("cannot allocate opening book position's moves\n");
+		link_slab_free(book->links, position->link, n_link);
+		position->link = l;
+	}
 }
 
 /**
@@ -1039,13 +1274,13 @@ static void position_enhance(Position *position, Book *book)
  */
 static void board_feed_hash(Board *board, const Book *book, Search *search, const bool is_pv)
 {
-	Position *position;
+	Position buffer, *position;
 	const unsigned long long hash_code = board_get_hash_code(board);
 	MoveList movelist;
 	Move *m;
 	HashStoreData hash_data;
 
-	position = book_probe(book, board);
+	position = book_get_position(book, board, &buffer);
 	if (position) {
 		const int n_empties = board_count_empties(&position->board);
 		const int score = position->score.value;
@@ -1123,12 +1358,12 @@ static void position_fix(Position *position, Book *book)
 
 	if ((position->board.player & position->board.opponent) || 
 	    ((position->board.player | position->board.opponent) & 0x0000001818000000ULL) != 0x0000001818000000ULL) {
-		position_free(position);
+		position_free(position, book);
 		position_init(position);
 		return;
 	}
 	board_unique(&position->board, &board);
-	position_free(position);
+	position_free(position, book);
 	position_init(position);
 	position->board = board;
 	position->level = book->options.level;
@@ -1136,114 +1371,141 @@ static void position_fix(Position *position, Book *book)
 	position_search(position, book);
 }
 
+/** Number of positions per chunk of the position arena (as a power of 2). */
+#define BOOK_CHUNK_SHIFT 12
+
+/** Number of positions per chunk of the position arena. */
+#define BOOK_CHUNK_SIZE (1 << BOOK_CHUNK_SHIFT)
+
+/** Initial (and minimal) size of the position index. */
+#define BOOK_INDEX_SIZE 65536
+
 /**
- * @brief An array with positions.
+ * struct PositionIndex
+ * @brief An entry of the open-addressing position index.
  */
-typedef struct PositionArray {
-	Position *positions;
-	int n;
-	int size;
-} PositionArray;
-
+typedef struct PositionIndex {
+	unsigned int tag;          /**< upper part of the hash code */
+	unsigned int id;           /**< position number + 1 (0 = empty entry) */
+} PositionIndex;
 
 /**
- * @brief Initialize the array.
+ * @brief Get a position from its number.
  *
- * @param a Positions' array.
+ * Positions are stored in fixed-size chunks, so they never move when the
+ * book grows.
+ *
+ * @param book Opening book.
+ * @param i Position number.
+ * @return the position.
  */
-static void position_array_init(PositionArray *a)
+static inline Position* book_position(const Book *book, const int i)
 {
-	a->size = a->n = 0;
-	a->positions = NULL;
+	return book->chunk[i >> BOOK_CHUNK_SHIFT] + (i & (BOOK_CHUNK_SIZE - 1));
 }
 
+#define foreach_position(p, i, b) \
+	for ((i) = 0; (i) < (b)->n_nodes && ((p) = book_position((b), (i))) != NULL; ++(i))
+
 /**
- * @brief Add a position to the array.
+ * @brief Look for a board into the index.
  *
- * @param a Positions' array.
- * @param p Position to add.
- * @return true in case of success.
+ * Linear probing; the hash tag avoids touching positions that cannot match.
+ *
+ * @param book Opening book.
+ * @param board (Unique) board to find.
+ * @param hash_code Board hash code.
+ * @param slot Index entry of the board, or first free entry if not found.
+ * @return the position or NULL.
  */
-static bool position_array_add(PositionArray *a, const Position *p)
+static Position* book_index_find(const Book *book, const Board *board, const unsigned long long hash_code, unsigned int *slot)
 {
-	int i;
-
-	board_check(&p->board);
-	assert(position_is_ok(p));
+	const unsigned int mask = book->n - 1;
+	const unsigned int tag = (unsigned int) (hash_code >> 32);
+	unsigned int i = (unsigned int) hash_code & mask;
+	const PositionIndex *e;
+	Position *p;
 
-	for (i = 0; i < a->n; ++i) if (board_equal(&a->positions[i].board, &p->board)) return false;
-	if (a->n == a->size) {
-		Position *n;
-		a->size += a->size / 2 + 1;
-		n = (Position*) realloc(a->positions, a->size * sizeof (Position));
-		if (n == NULL) {
-			error("cannot add a position to the book\n");
-			a->size = a->n;
-			return false;
+	while ((e = book->index + i)->id) {
+		if (e->tag == tag) {
+			p = book_position(book, e->id - 1);
+			if (board_equal(&p->board, board)) {
+				*slot = i;
+				return p;
+			}
 		}
-		a->positions = n;
+		i = (i + 1) & mask;
 	}
-	a->positions[a->n] = *p;
-	a->positions[a->n].done = true;
-	a->positions[a->n].todo = false;
-	++a->n;
-	return true;
+	*slot = i;
+	return NULL;
 }
 
 /**
- * @brief Remove a position from an array.
+ * @brief Distance of an index entry from its home slot.
  *
- * @param a Positions' array.
- * @param p Position to add.
- * @return true in case of success.
+ * @param book Opening book.
+ * @param i Index entry (not empty).
+ * @return the number of entries skipped to reach entry i.
  */
-static bool position_array_remove(PositionArray *a, const Position *p)
+static int book_index_distance(const Book *book, const unsigned int i)
 {
-	int i, j;
+	const Position *p = book_position(book, book->index[i].id - 1);
 
-	for (i = 0; i < a->n; ++i) {
-		if (board_equal(&a->positions[i].board, &p->board)) {
-			position_free(a->positions + i);
-			for (j = i + 1; j < a->n; ++j) {
-				a->positions[j - 1] = a->positions[j];
-			}
-			--a->n;
-			return true;
-		}
-	}
-	return false;
+	return (i - (unsigned int) board_get_hash_code(&p->board)) & (book->n - 1);
 }
 
 /**
- * @brief Free resources used by a position array.
+ * @brief (Re)build the position index.
  *
- * @param a Positions' array.
+ * @param book Opening book.
+ * @param n New index size (a power of 2).
+ * @return true in case of success.
  */
-static void position_array_free(PositionArray *a)
+static bool book_index_build(Book *book, const int n)
 {
+	PositionIndex *index = (PositionIndex*) calloc(n, sizeof (PositionIndex));
+	unsigned long long hash_code;
+	unsigned int slot;
+	Position *p;
 	int i;
-	for (i = 0; i < a->n; ++i) position_free(a->positions + i);
-	free(a->positions);
+
+	if (index == NULL) {
+		error("cannot allocate the book index\n");
+		return false;
+	}
+	free(book->index);
+	book->index = index;
+	book->n = n;
+
+	foreach_position(p, i, book) {
+		hash_code = board_get_hash_code(&p->board);
+		book_index_find(book, &p->board, hash_code, &slot);
+		index[slot].tag = (unsigned int) (hash_code >> 32);
+		index[slot].id = i + 1;
+	}
+	return true;
 }
 
 /**
- * @brief Find a position in the array.
+ * @brief Allocate an empty book storage.
  *
- * @param a Positions' array.
- * @param board Board to find in the array.
- * @return a position containg the board (or a symetry) or NULL is no position is found.
+ * @param book Opening book.
+ * @param n Index size (a power of 2).
  */
-static Position* position_array_probe(PositionArray *a, const Board *board)
+static void book_alloc(Book *book, const int n)
 {
-	int i;
-	for (i = 0; i < a->n; ++i) if (board_equal(&a->positions[i].board, board)) return a->positions + i;
-	return NULL;
+	book->image = NULL;
+	book->journal = NULL;
+	book->chunk = NULL;
+	book->n_chunks = 0;
+	book->n_nodes = 0;
+	book->n_buckets = BOOK_INDEX_SIZE;
+	book->index = NULL;
+	book->links = (LinkSlab*) malloc(sizeof (LinkSlab));
+	if (book->links == NULL || !book_index_build(book, n)) fatal_error("cannot allocate space to store the positions");
+	link_slab_init(book->links);
 }
 
-#define foreach_position(p, a, b) \
-	for (a = b->array; a < b->array + b->n; ++a) \
-	for (p = a->positions; p < a->positions + a->n; ++p)
-
 /**
  * @brief Set book date.
  *
@@ -1298,40 +1560,86 @@ static double book_get_age(Book *book)
 static Position* book_probe(const Book *book, const Board *board)
 {
 	Board unique;
+	unsigned int slot;
+
 	board_unique(board, &unique);
-	return position_array_probe(book->array + (board_get_hash_code(&unique) & (book->n - 1)), &unique);
+	return book_index_find(book, &unique, board_get_hash_code(&unique), &slot);
 }
 
 /**
  * @brief Add a position to the book.
  *
+ * The position is copied into the book, which takes the ownership of its links.
+ *
  * @param book Opening book.
  * @param p Position to add.
  */
 static void book_add(Book *book, const Position *p)
 {
-	const unsigned long long i = board_get_hash_code(&p->board) & (book->n - 1);
+	const unsigned long long hash_code = board_get_hash_code(&p->board);
+	unsigned int slot;
+	Position *q;
+
+	board_check(&p->board);
+	assert(position_is_ok(p));
 
-	if (position_array_add(book->array + i, p)) {
-		++book->n_nodes;
-		++book->stats.n_nodes;
+	if (book_index_find(book, &p->board, hash_code, &slot)) return;
+
+	// keep the index at most 3/4 full
+	if (4 * (book->n_nodes + 1) > 3 * book->n) {
+		if (!book_index_build(book, 2 * book->n)) return;
+		book_index_find(book, &p->board, hash_code, &slot);
+	}
+
+	if (book->n_nodes == book->n_chunks * BOOK_CHUNK_SIZE) {
+		Position **chunk = (Position**) realloc(book->chunk, (book->n_chunks + 1) * sizeof (Position*));
+		if (chunk == NULL) {
+			error("cannot add a position to the book\n");
+			return;
+		}
+		book->chunk = chunk;
+		chunk[book->n_chunks] = (Position*) malloc(BOOK_CHUNK_SIZE * sizeof (Position));
+		if (chunk[book->n_chunks] == NULL) {
+			error("cannot add a position to the book\n");
+			return;
+		}
+		++book->n_chunks;
 	}
+
+	q = book_position(book, book->n_nodes);
+	*q = *p;
+	q->done = true;
+	q->todo = false;
+	q->dirty = true;
+	book->index[slot].tag = (unsigned int) (hash_code >> 32);
+	book->index[slot].id = ++book->n_nodes;
+	++book->stats.n_nodes;
 }
 
 /**
- * @brief Remove a position from the book.
+ * @brief Remove the positions not marked as done from the book.
+ *
+ * The remaining positions are packed, so pointers to positions are invalidated.
  *
  * @param book Opening book.
- * @param p Position to add.
  */
-static void book_remove(Book *book, const Position *p)
+static void book_remove_undone(Book *book)
 {
-	const unsigned long long i = board_get_hash_code(&p->board) & (book->n - 1);
+	Position *p;
+	int i, n;
 
-	if (position_array_remove(book->array + i, p)) {
-		--book->n_nodes;
-		--book->stats.n_nodes;
+	for (i = n = 0; i < book->n_nodes; ++i) {
+		p = book_position(book, i);
+		if (p->done) {
+			if (i > n) *book_position(book, n) = *p;
+			++n;
+		} else {
+			position_free(p, book);
+			--book->stats.n_nodes;
+		}
 	}
+	book->n_nodes = n;
+	book_index_build(book, book->n);
 }
 
 /**
@@ -1341,42 +1649,587 @@ static void book_remove(Book *book, const Position *p)
  */
 static void book_clean(Book *book)
 {
-	PositionArray *a;
 	Position *p;
+	int i;
+
 	book->stats.n_nodes = book->stats.n_links = book->stats.n_todo = 0;
-	foreach_position(p, a, book) p->done = p->todo = false;
+	foreach_position(p, i, book) p->done = p->todo = false;
 }
 
 /**
- * @brief Find the initial position in the book.
- *
- * Attention: when a position is added to the book, the pointer
- * returned by this position may be wrong. If the root position is updated
- * the contents of the pointed structure may be wrong. So it is needed to
- * recall this function each time as necessary.
+ * @brief Compare two positions by board, for qsort().
  *
- * @param book Opening book.
- * @return the inital position.
+ * @param a First position pointer.
+ * @param b Second position pointer.
+ * @return -1, 0 or 1.
  */
-static Position *book_root(Book *book)
+static int position_compare(const void *a, const void *b)
 {
-	Board board;
+	const Board *b1 = &(*(const Position* const*) a)->board;
+	const Board *b2 = &(*(const Position* const*) b)->board;
 
-	board_init(&board);
-	return book_probe(book, &board);
+	if (board_lesser(b1, b2)) return -1;
+	if (board_lesser(b2, b1)) return 1;
+	return 0;
 }
 
+/** Compiled (read-only) book header tag */
+#define BOOK_IMAGE 0x424d4150
+
+/** Size of the compiled book header, as stored on disk. */
+#define BOOK_IMAGE_HEADER_SIZE 64
+
 /**
- * @brief Initialize the opening book.
- *
- * Create an empty opening book.
- *
- * @param book Opening book.
+ * struct PositionRecord
+ * @brief A position stored in a compiled book.
  */
-void book_init(Book *book)
-{
-	int i;
+typedef struct PositionRecord {
+	Board board;               /**< (unique) board */
+	unsigned int n_wins;       /**< game win count */
+	unsigned int n_draws;      /**< game draw count */
+	unsigned int n_losses;     /**< game loss count */
+	unsigned int n_lines;      /**< unterminated line count */
+	unsigned int link;         /**< first link in the link table */
+	short value, lower, upper; /**< Position value & bounds */
+	Link leaf;                 /**< best remaining move */
+	unsigned char n_link;      /**< linking moves number */
+	unsigned char level;       /**< search level */
+} PositionRecord;
 
+/**
+ * struct BookImage
+ * @brief A compiled book, mapped in memory.
+ *
+ * The file holds the header, the position records sorted by board, the link
+ * table and an open-addressing index (at most half full), each aligned on 8
+ * bytes.
+ */
+typedef struct BookImage {
+	FileMap map;                    /**< file mapping */
+	const PositionRecord *record;   /**< position records */
+	const Link *link;               /**< link table */
+	const PositionIndex *index;     /**< index */
+	int n_nodes;                    /**< number of positions */
+	int n_links;                    /**< number of links */
+	int n;                          /**< index size */
+} BookImage;
+
+/**
+ * @brief Round a file offset up to 8 bytes.
+ *
+ * @param offset File offset.
+ * @return Aligned offset.
+ */
+static size_t book_image_align(const size_t offset)
+{
+	return (offset + 7) & ~(size_t) 7;
+}
+
+/**
+ * @brief Get a position from a compiled book record.
+ *
+ * @param image Compiled book.
+ * @param r Position record.
+ * @param position Output position, whose links point into the mapped file.
+ */
+static void book_image_position(const BookImage *image, const PositionRecord *r, Position *position)
+{
+	position->board = r->board;
+	position->leaf = r->leaf;
+	position->link = (Link*) image->link + r->link;
+	position->n_wins = r->n_wins;
+	position->n_draws = r->n_draws;
+	position->n_losses = r->n_losses;
+	position->n_lines = r->n_lines;
+	position->score.value = r->value;
+	position->score.lower = r->lower;
+	position->score.upper = r->upper;
+	position->n_link = r->n_link;
+	position->level = r->level;
+	position->done = true;
+	position->todo = false;
+	position->dirty = false;
+}
+
+/**
+ * @brief Find a position in a compiled book.
+ *
+ * @param image Compiled book.
+ * @param board (Unique) board to find.
+ * @return the position record or NULL.
+ */
+static const PositionRecord* book_image_find(const BookImage *image, const Board *board)
+{
+	const unsigned long long hash_code = board_get_hash_code(board);
+	const unsigned int mask = image->n - 1;
+	const unsigned int tag = (unsigned int) (hash_code >> 32);
+	unsigned int i = (unsigned int) hash_code & mask;
+	const PositionIndex *e;
+	const PositionRecord *r;
+
+	while ((e = image->index + i)->id) {
+		if (e->tag == tag) {
+			r = image->record + e->id - 1;
+			if (board_equal(&r->board, board)) return r;
+		}
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Check the consistency of a compiled book.
+ *
+ * The records & the index are used without further checks once mapped, so
+ * every link range & position number has to lie inside the file.
+ *
+ * @param image Compiled book.
+ * @return true if the compiled book is consistent.
+ */
+static bool book_image_check(const BookImage *image)
+{
+	const PositionRecord *r;
+	int i;
+
+	for (i = 0; i < image->n_nodes; ++i) {
+		r = image->record + i;
+		if (r->n_link > LINK_SLAB_MAX || r->link > (unsigned int) image->n_links || r->n_link > image->n_links - r->link) return false;
+	}
+	for (i = 0; i < image->n; ++i) {
+		if (image->index[i].id > (unsigned int) image->n_nodes) return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Map a compiled book.
+ *
+ * @param file Compiled book file.
+ * @param n_nodes Number of positions.
+ * @param n_links Number of links.
+ * @param n Index size.
+ * @return the mapped book, or NULL in case of failure.
+ */
+static BookImage* book_image_map(const char *file, const int n_nodes, const int n_links, const int n)
+{
+	BookImage *image;
+	size_t offset;
+
+	if (n <= 0 || (n & (n - 1)) || n < 2 * n_nodes || n_nodes < 0 || n_links < 0) return NULL;
+
+	image = (BookImage*) malloc(sizeof (BookImage));
+	if (image == NULL) return NULL;
+	if (!file_map(&image->map, file)) {
+		free(image);
+		return NULL;
+	}
+
+	image->n_nodes = n_nodes;
+	image->n_links = n_links;
+	image->n = n;
+	offset = BOOK_IMAGE_HEADER_SIZE;
+	image->record = (const PositionRecord*) ((const char*) image->map.data + offset);
+	offset += (size_t) image->n_nodes * sizeof (PositionRecord);
+	image->link = (const Link*) ((const char*) image->map.data + offset);
+	offset = book_image_align(offset + (size_t) n_links * sizeof (Link));
+	image->index = (const PositionIndex*) ((const char*) image->map.data + offset);
+	offset += (size_t) n * sizeof (PositionIndex);
+
+	if (offset != image->map.size || !book_image_check(image)) {
+		file_unmap(&image->map);
+		free(image);
+		return NULL;
+	}
+
+	return image;
+}
+
+/**
+ * @brief Release a compiled book.
+ *
+ * @param book Opening book.
+ */
+static void book_image_free(Book *book)
+{
+	if (book->image) {
+		file_unmap(&book->image->map);
+		free(book->image);
+		book->image = NULL;
+	}
+}
+
+/**
+ * @brief Convert a compiled book back to an in-memory book.
+ *
+ * Compiled books are read-only; this is done before any operation that
+ * modifies or walks through the whole book.
+ *
+ * @param book Opening book.
+ */
+static void book_unmap(Book *book)
+{
+	BookImage *image = book->image;
+	Position p;
+	int i, n;
+
+	if (image) {
+		info("<unmapping compiled book: %d positions>\n", image->n_nodes);
+		book->n_nodes = 0; // until the positions are added back
+		for (n = BOOK_INDEX_SIZE; n < 2 * image->n_nodes; n <<= 1) ;
+		book_index_build(book, n);
+		for (i = 0; i < image->n_nodes; ++i) {
+			book_image_position(image, image->record + i, &p);
+			if (p.n_link) {
+				Link *l = link_slab_alloc(book->links, p.n_link);
+				if (l == NULL) fatal_error("cannot allocate opening book position's moves\n");
+				memcpy(l, p.link, p.n_link * sizeof (Link));
+				p.link = l;
+			} else p.link = NULL;
+			book_add(book, &p);
+		}
+		book_image_free(book);
+	}
+}
+
+/**
+ * @brief Get a position from the book, compiled or not.
+ *
+ * @param book Opening book.
+ * @param board Board to find.
+ * @param buffer Storage for a position read from a compiled book.
+ * @return the position (read-only) or NULL if the position is not found.
+ */
+static Position* book_get_position(const Book *book, const Board *board, Position *buffer)
+{
+	if (book->image) {
+		const PositionRecord *r;
+		Board unique;
+
+		board_unique(board, &unique);
+		r = book_image_find(book->image, &unique);
+		if (r == NULL) return NULL;
+		book_image_position(book->image, r, buffer);
+		return buffer;
+	}
+
+	return book_probe(book, board);
+}
+
+/** Book journal header tag */
+#define BOOK_JOURNAL 0x4a524e4c
+
+/**
+ * struct BookJournal
+ * @brief Append-only journal of the positions modified since the book was saved.
+ *
+ * The journal starts with a header identifying the saved book it applies to,
+ * followed by whole positions (with their links) as written by position_write.
+ * A position appearing several times is superseded by its last record.
+ */
+typedef struct BookJournal {
+	FILE *f;                        /**< journal stream */
+	char file[FILENAME_MAX + 1];    /**< saved book the journal applies to */
+	int n_records;                  /**< number of positions in the journal */
+} BookJournal;
+
+/**
+ * @brief Stop journaling.
+ *
+ * The journal file is kept on disk, so that loading the book replays it.
+ *
+ * @param book Opening book.
+ */
+static void book_journal_close(Book *book)
+{
+	if (book->journal) {
+		fclose(book->journal->f);
+		free(book->journal);
+		book->journal = NULL;
+	}
+}
+
+/**
+ * @brief Start a new journal, applying to a freshly saved book.
+ *
+ * @param book Opening book.
+ * @param file Saved book file name.
+ */
+static void book_journal_open(Book *book, const char *file)
+{
+	unsigned int header_edax = EDAX, header_journal = BOOK_JOURNAL;
+	unsigned char header_version = VERSION, header_release = RELEASE;
+	char journal_file[FILENAME_MAX + 1];
+	BookJournal *journal;
+	int r;
+
+	file_add_ext(file, ".jnl", journal_file);
+	journal = (BookJournal*) malloc(sizeof (BookJournal));
+	if (journal == NULL) {
+		error("cannot allocate the book journal\n");
+		return;
+	}
+	journal->f = fopen(journal_file, "wb");
+	if (journal->f == NULL) {
+		error("cannot open %s", journal_file);
+		free(journal);
+		return;
+	}
+
+	r = fwrite(&header_edax, sizeof (unsigned int), 1, journal->f);
+	r += fwrite(&header_journal, sizeof (unsigned int), 1, journal->f);
+	r += fwrite(&header_version, 1, 1, journal->f);
+	r += fwrite(&header_release, 1, 1, journal->f);
+	r += fwrite(&book->date, sizeof book->date, 1, journal->f);
+	r += fwrite(&book->n_nodes, sizeof book->n_nodes, 1, journal->f);
+	if (r != 6 || !file_sync(journal->f)) {
+		error("cannot write %s", journal_file);
+		fclose(journal->f);
+		remove(journal_file);
+		free(journal);
+		return;
+	}
+
+	strncpy(journal->file, file, FILENAME_MAX);
+	journal->file[FILENAME_MAX] = '\0';
+	journal->n_records = 0;
+	book->journal = journal;
+}
+
+/**
+ * @brief Replay the journal of a book that has just been loaded.
+ *
+ * A journal not matching the book (older or newer save) is ignored; an
+ * incomplete last record, left by an interrupted checkpoint, is skipped.
+ *
+ * @param book Opening book.
+ * @param file Loaded book file name.
+ */
+static void book_journal_replay(Book *book, const char *file)
+{
+	char journal_file[FILENAME_MAX + 1];
+	unsigned int header_edax, header_journal;
+	unsigned char header_version, header_release;
+	char date[sizeof book->date];
+	int n_nodes, n = 0;
+	Position p, *q;
+	FILE *f;
+	int r;
+
+	file_add_ext(file, ".jnl", journal_file);
+	f = fopen(journal_file, "rb");
+	if (f == NULL) return;
+
+	r = fread(&header_edax, sizeof (unsigned int), 1, f);
+	r += fread(&header_journal, sizeof (unsigned int), 1, f);
+	r += fread(&header_version, 1, 1, f);
+	r += fread(&header_release, 1, 1, f);
+	r += fread(date, sizeof date, 1, f);
+	r += fread(&n_nodes, sizeof n_nodes, 1, f);
+	if (r != 6 || header_edax != EDAX || header_journal != BOOK_JOURNAL || header_version != VERSION
+	 || memcmp(date, &book->date, sizeof date) != 0 || n_nodes != book->n_nodes) {
+		warn("%s does not apply to %s and is ignored\n", journal_file, file);
+	} else {
+		while (position_read(&p, f, book)) {
+			p.done = true;
+			p.todo = false;
+			q = book_probe(book, &p.board);
+			if (q) {
+				link_slab_free(book->links, q->link, q->n_link);
+				*q = p;
+			} else {
+				book_add(book, &p);
+			}
+			++n;
+		}
+		info("%d positions replayed from %s...", n, journal_file);
+	}
+	fclose(f);
+}
+
+/**
+ * @brief Replace a file by a freshly written temporary one.
+ *
+ * @param tmp_file Temporary file name.
+ * @param file File name.
+ * @return true in case of success.
+ */
+static bool book_rename(const char *tmp_file, const char *file)
+{
+	if (rename(tmp_file, file) != 0) {
+		remove(file);
+		if (rename(tmp_file, file) != 0) {
+			error("Cannot rename %s to %s", tmp_file, file);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Order the positions to save.
+ *
+ * Positions are saved grouped by hash bucket (their hash code modulo
+ * book->n_buckets), in their insertion order within a bucket, as the former
+ * bucket arrays did: saving a book does not depend on the index layout.
+ *
+ * @param book Opening book.
+ * @return the position numbers in their saving order, or NULL (insertion order).
+ */
+static int* book_save_order(const Book *book)
+{
+	int *order = (int*) malloc(book->n_nodes * sizeof (int));
+	int *first = (int*) calloc(book->n_buckets + 1, sizeof (int));
+	const Position *p;
+	int i;
+
+	if (order && first) {
+		foreach_position(p, i, book) ++first[(board_get_hash_code(&p->board) & (book->n_buckets - 1)) + 1];
+		for (i = 0; i < book->n_buckets; ++i) first[i + 1] += first[i];
+		foreach_position(p, i, book) order[first[board_get_hash_code(&p->board) & (book->n_buckets - 1)]++] = i;
+	} else {
+		free(order);
+		order = NULL;
+	}
+	free(first);
+
+	return order;
+}
+
+/**
+ * @brief Write an opening book.
+ *
+ * The book is written under a temporary name & then renamed, so that an
+ * interrupted save does not destroy the previous file. A journal applying to
+ * the previous file becomes obsolete and is removed.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ * @return true in case of success.
+ */
+static bool book_write(Book *book, const char *file)
+{
+	unsigned int header_edax = EDAX, header_book = BOOK;
+	unsigned char header_version = VERSION, header_release = RELEASE;
+	char tmp_file[FILENAME_MAX + 1];
+	FILE *f;
+	int r;
+	int k;
+	int *order;
+	Position *p;
+
+	book_unmap(book); // the file may be the mapped one.
+	file_add_ext(file, ".tmp", tmp_file);
+	f = fopen(tmp_file, "wb");
+	if (f == NULL) {
+		error("Cannot open %s", tmp_file);
+		return false;
+	}
+	info("Saving book to %s...", file);
+	book_set_date(book);
+
+	r = fwrite(&header_edax, sizeof (unsigned int), 1, f);
+	r += fwrite(&header_book, sizeof (unsigned int), 1, f);
+	r += fwrite(&header_version, 1, 1, f);
+	r += fwrite(&header_release, 1, 1, f);
+	r += fwrite(&book->date, sizeof book->date, 1, f);
+	r += fwrite(&book->options, sizeof book->options, 1, f);
+	r += fwrite(&book->n_nodes, sizeof book->n_nodes, 1, f);
+
+	k = 0;
+	if (r == 7) {
+		order = book_save_order(book);
+		for (k = 0; k < book->n_nodes; ++k) {
+			if (!position_write(book_position(book, order ? order[k] : k), f)) break;
+		}
+		free(order);
+	}
+	if (fclose(f) != 0 || r != 7 || k < book->n_nodes) {
+		error("\nCannot save book to %s", file);
+		remove(tmp_file);
+		return false;
+	}
+	if (!book_rename(tmp_file, file)) return false;
+
+	if (book->journal && strcmp(book->journal->file, file) == 0) book_journal_close(book);
+	file_add_ext(file, ".jnl", tmp_file);
+	remove(tmp_file);
+	foreach_position(p, k, book) p->dirty = false;
+	info("done\n");
+
+	return true;
+}
+
+/**
+ * @brief Checkpoint a long book job.
+ *
+ * The first checkpoint saves the whole book & starts a journal over it; the
+ * following ones only append the positions modified in between. Once the
+ * journal holds more records than half the book, it is compacted into a new
+ * full save.
+ *
+ * @param book Opening book.
+ * @param file Checkpoint file name.
+ */
+static void book_checkpoint(Book *book, const char *file)
+{
+	BookJournal *journal = book->journal;
+	Position *p;
+	int k, n = 0;
+
+	if (journal && (strcmp(journal->file, file) != 0 || 2 * journal->n_records > book->n_nodes)) {
+		book_journal_close(book);
+		journal = NULL;
+	}
+
+	if (journal == NULL) {
+		if (book_write(book, file)) book_journal_open(book, file);
+		return;
+	}
+
+	foreach_position(p, k, book) {
+		if (p->dirty) {
+			if (!position_write(p, journal->f)) break;
+			p->dirty = false;
+			++n;
+		}
+	}
+	journal->n_records += n;
+	if (k < book->n_nodes || !file_sync(journal->f)) {
+		error("cannot write the journal of %s", file);
+		book_journal_close(book);
+	} else {
+		info("<checkpoint: %d positions journaled>\n", n);
+	}
+}
+
+/**
+ * @brief Find the initial position in the book.
+ *
+ * Attention: when positions are removed from the book, the pointer
+ * returned by this position may be wrong. If the root position is updated
+ * the contents of the pointed structure may be wrong. So it is needed to
+ * recall this function each time as necessary.
+ *
+ * @param book Opening book.
+ * @return the inital position.
+ */
+static Position *book_root(Book *book)
+{
+	Board board;
+
+	board_init(&board);
+	return book_probe(book, &board);
+}
+
+/**
+ * @brief Initialize the opening book.
+ *
+ * Create an empty opening book.
+ *
+ * @param book Opening book.
+ */
+void book_init(Book *book)
+{
 	book_set_date(book);
 
 	book->options.level = 21;
@@ -1384,12 +2237,8 @@ void book_init(Book *book)
 	book->options.midgame_error = 2;
 	book->options.endcut_error = 1;
 
-	book->n = 65536;
-	book->array = (PositionArray*) malloc(book->n * sizeof *book->array);
-	if (book->array == NULL) fatal_error("cannot allocate space to store the positions");
-	for (i = 0; i < book->n; ++i) position_array_init(book->array + i);
+	book_alloc(book, BOOK_INDEX_SIZE);
 
-	book->n_nodes = 0;
 	random_seed(&book->random, real_clock());
 	book->need_saving = false;
 }
@@ -1402,10 +2251,14 @@ void book_init(Book *book)
 void book_free(Book *book)
 {
 	int i;
-	for (i = 0; i < book->n; ++i) {
-		position_array_free(book->array + i);
-	}
-	free(book->array);
+
+	book_image_free(book);
+	book_journal_close(book);
+	for (i = 0; i < book->n_chunks; ++i) free(book->chunk[i]);
+	free(book->chunk);
+	free(book->index);
+	link_slab_release(book->links);
+	free(book->links);
 }
 
 /**
@@ -1445,13 +2298,13 @@ void book_load(Book *book, const char *file)
 		Position p;
 		unsigned int header_edax, header_book;
 		unsigned char header_version, header_release;
-		int i;
+		int n, n_buckets;
 		int r;
 
 		info("Loading book from %s...", file);
 		r = fread(&header_edax, sizeof (unsigned int), 1, f);
 		r += fread(&header_book, sizeof (unsigned int), 1, f);
-		if (r != 2 || header_edax != EDAX || header_book != BOOK) {
+		if (r != 2 || header_edax != EDAX || (header_book != BOOK && header_book != BOOK_IMAGE)) {
 			error("%s is not an edax opening book", file);
 			book_new(book, options.level, 61 - get_book_depth(options.level));
 			return;
@@ -1474,31 +2327,50 @@ void book_load(Book *book, const char *file)
 			return;
 		}
 
-		book->n = 65536;
-		while ((book->n << 4) < book->n_nodes) book->n <<= 1;
-
-		book->array = (PositionArray*) malloc(book->n * sizeof (PositionArray));
-		if (book->array == NULL) {
-			error("cannot allocate space to store the positions");
-			book_new(book, options.level, 61 - get_book_depth(options.level));
+		if (header_book == BOOK_IMAGE) {
+			const int n_nodes = book->n_nodes;
+			int n_links = -1;
+
+			r = fread(&n_links, sizeof n_links, 1, f);
+			r += fread(&n, sizeof n, 1, f);
+			fclose(f);
+			book_alloc(book, BOOK_INDEX_SIZE);
+			if (r == 2) book->image = book_image_map(file, n_nodes, n_links, n);
+			if (book->image == NULL) {
+				error("Cannot map compiled book %s", file);
+				book_free(book);
+				book_new(book, options.level, 61 - get_book_depth(options.level));
+				return;
+			}
+			book->n_nodes = n_nodes;
+			random_seed(&book->random, real_clock());
+			book->need_saving = false;
+			info("mapped\n");
 			return;
 		}
-		for (i = 0; i < book->n; ++i) position_array_init(book->array + i);
 
-		book->n_nodes = 0;
-		while (position_read(&p, f)) {
+		n = BOOK_INDEX_SIZE;
+		while (n < 2 * book->n_nodes) n <<= 1;
+		n_buckets = BOOK_INDEX_SIZE;
+		while ((n_buckets << 4) < book->n_nodes) n_buckets <<= 1;
+		book_alloc(book, n);
+		book->n_buckets = n_buckets;
+
+		while (position_read(&p, f, book)) {
 			book_add(book, &p);
 		}
 
 		if (!feof(f)) {
 			error("error while reading %s", file);
 		}
+		fclose(f);
+
+		book_journal_replay(book, file);
 
 		random_seed(&book->random, real_clock());
 		book->need_saving = false;
 
 		info("done\n");
-		fclose(f);
 	} else {
 		book_new(book, options.level, 60 - get_book_depth(options.level));
 	}
@@ -1518,7 +2390,7 @@ void book_import(Book *book, const char *file)
 {
 	FILE *f = fopen(file, "r");
 	if (f) {
-		PositionArray *a;
+		int k;
 		Position *p, position;
 		int n_empties;
 
@@ -1531,7 +2403,7 @@ void book_import(Book *book, const char *file)
 
 		book->options.n_empties = 60;
 		book->options.level = 0;
-		foreach_position(p, a, book) {
+		foreach_position(p, k, book) {
 			n_empties = board_count_empties(&p->board);
 			if (p->level > book->options.level) book->options.level = p->level;
 			if (n_empties < book->options.n_empties) book->options.n_empties = n_empties;
@@ -1559,8 +2431,9 @@ void book_import(Book *book, const char *file)
 void book_export(Book *book, const char *file)
 {
 	FILE *f;
-	PositionArray *a;
-	Position *p;
+	int k;
+	int *order;
+	book_unmap(book);
 
 	f = fopen(file, "w");
 	if (f == NULL) {
@@ -1569,8 +2442,9 @@ void book_export(Book *book, const char *file)
 	}
 	
 	info("Exporting book to %s...", file);
-	foreach_position(p, a, book) {
-		if (!position_export(p, f)) {
+	order = book_save_order(book);
+	for (k = 0; k < book->n_nodes; ++k) {
+		if (!position_export(book_position(book, order ? order[k] : k), f)) {
 			error("cannot export book to %s", file);
 			goto book_export_end;
 		}
@@ -1578,6 +2452,7 @@ void book_export(Book *book, const char *file)
 	info("done\n");
 
 book_export_end:
+	free(order);
 	fclose(f);
 }
 
@@ -1591,14 +2466,71 @@ book_export_end:
  */
 void book_save(Book *book, const char *file)
 {
-	unsigned int header_edax = EDAX, header_book = BOOK;
+	book_write(book, file);
+}
+
+/**
+ * @brief Compile an opening book.
+ *
+ * Save the book in a read-only format, made to be mapped in memory & probed
+ * directly by book_load. Positions are stored sorted by board, so that
+ * compiled books can also be merged by book_merge_files(). The file is
+ * written under a temporary name & then renamed, so that processes still
+ * mapping the previous version are not disturbed.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ */
+void book_compile(Book *book, const char *file)
+{
+	unsigned int header_edax = EDAX, header_book = BOOK_IMAGE;
 	unsigned char header_version = VERSION, header_release = RELEASE;
-	FILE *f = fopen(file, "wb");
-	int r;
-	PositionArray *a;
+	static const char padding[BOOK_IMAGE_HEADER_SIZE];
+	char tmp_file[FILENAME_MAX + 1];
+	PositionIndex *index;
+	Position **sorted;
+	PositionRecord record;
+	unsigned long long hash_code;
+	unsigned int i;
+	size_t size;
+	FILE *f;
+	int n, n_links, r, k;
 	Position *p;
 
-	info("Saving book to %s...", file);
+	book_unmap(book);
+
+	for (n = 16; n < 2 * book->n_nodes; n <<= 1) ;
+	index = (PositionIndex*) calloc(n, sizeof (PositionIndex));
+	sorted = (Position**) malloc((book->n_nodes + 1) * sizeof (Position*));
+	if (index == NULL || sorted == NULL) {
+		error("cannot allocate the compiled book index\n");
+		free(index);
+		free(sorted);
+		return;
+	}
+	foreach_position(p, k, book) sorted[k] = p;
+	qsort(sorted, book->n_nodes, sizeof (Position*), position_compare);
+
+	n_links = 0;
+	for (k = 0; k < book->n_nodes; ++k) {
+		p = sorted[k];
+		hash_code = board_get_hash_code(&p->board);
+		for (i = (unsigned int) hash_code & (n - 1); index[i].id; i = (i + 1) & (n - 1)) ;
+		index[i].tag = (unsigned int) (hash_code >> 32);
+		index[i].id = k + 1;
+		n_links += p->n_link;
+	}
+
+	file_add_ext(file, ".tmp", tmp_file);
+	f = fopen(tmp_file, "wb");
+	if (f == NULL) {
+		error("cannot open %s", tmp_file);
+		free(index);
+		free(sorted);
+		return;
+	}
+
+	info("Compiling book to %s...", file);
 	book_set_date(book);
 
 	r = fwrite(&header_edax, sizeof (unsigned int), 1, f);
@@ -1608,19 +2540,48 @@ void book_save(Book *book, const char *file)
 	r += fwrite(&book->date, sizeof book->date, 1, f);
 	r += fwrite(&book->options, sizeof book->options, 1, f);
 	r += fwrite(&book->n_nodes, sizeof book->n_nodes, 1, f);
+	r += fwrite(&n_links, sizeof n_links, 1, f);
+	r += fwrite(&n, sizeof n, 1, f);
+	size = 2 * sizeof (unsigned int) + 2 + sizeof book->date + sizeof book->options + 3 * sizeof (int);
+	r += fwrite(padding, BOOK_IMAGE_HEADER_SIZE - size, 1, f);
+
+	memset(&record, 0, sizeof record);
+	record.link = 0;
+	for (k = 0; k < book->n_nodes; ++k) {
+		p = sorted[k];
+		record.board = p->board;
+		record.n_wins = p->n_wins;
+		record.n_draws = p->n_draws;
+		record.n_losses = p->n_losses;
+		record.n_lines = p->n_lines;
+		record.value = p->score.value;
+		record.lower = p->score.lower;
+		record.upper = p->score.upper;
+		record.leaf = p->leaf;
+		record.n_link = p->n_link;
+		record.level = p->level;
+		r += fwrite(&record, sizeof record, 1, f);
+		record.link += p->n_link;
+	}
+	for (k = 0; k < book->n_nodes; ++k) {
+		p = sorted[k];
+		if (p->n_link) r += fwrite(p->link, sizeof (Link) * p->n_link, 1, f) - 1;
+	}
+	size = (size_t) n_links * sizeof (Link);
+	if (book_image_align(size) > size) r += fwrite(padding, book_image_align(size) - size, 1, f);
+	else ++r;
+	r += fwrite(index, sizeof (PositionIndex), n, f);
 
-	if (r == 7) {
-		foreach_position(p, a, book) {
-			if (!position_write(p, f)) {
-				error("\nCannot save book to %s", file);
-				goto book_write_end;
-			}
-		}
-	}
-	info("done\n");
-
-book_write_end:
 	fclose(f);
+	free(index);
+	free(sorted);
+
+	if (r != 11 + book->n_nodes + n) {
+		error("Cannot compile book to %s", file);
+		remove(tmp_file);
+	} else if (book_rename(tmp_file, file)) {
+		info("done\n");
+	}
 }
 
 /**
@@ -1634,54 +2595,547 @@ book_write_end:
  */
 void book_merge(Book *dest, const Book *src)
 {
-	PositionArray *a;
+	int k;
 	const Position *p_src;
-	Position p_dest;
+	Position p_dest, buffer;
+	const BookImage *image = src->image;
+
+	book_unmap(dest);
+	if (image) { // a compiled source is read in place
+		for (k = 0; k < image->n_nodes; ++k) {
+			book_image_position(image, image->record + k, &buffer);
+			if (!book_probe(dest, &buffer.board)) {
+				position_merge(&p_dest, &buffer);
+				book_add(dest, &p_dest);
+			}
+		}
+	} else {
+		foreach_position(p_src, k, src) {
+			if (!book_probe(dest, &p_src->board)) {
+				position_merge(&p_dest, p_src);
+				book_add(dest, &p_dest);
+			}
+		}
+	}
+}
+
+/**
+ * struct BookReader
+ * @brief Sequential reader of a book file sorted by board.
+ */
+typedef struct BookReader {
+	const char *file;          /**< file name */
+	FILE *f;                   /**< stream of a saved book */
+	BookImage *image;          /**< or compiled book */
+	Book header;               /**< book settings (date & options) */
+	int n_nodes;               /**< number of positions */
+	int i;                     /**< number of positions read */
+	Position position;         /**< current position */
+	Link link[MAX_MOVE + 1];   /**< current position's links */
+	bool ok;                   /**< is the current position available? */
+} BookReader;
+
+/**
+ * @brief Read the next position of a book file.
+ *
+ * @param reader Book reader.
+ */
+static void book_reader_next(BookReader *reader)
+{
+	const Board previous = reader->position.board;
+	Position *p = &reader->position;
+	int i;
+
+	reader->ok = false;
+	if (reader->i == reader->n_nodes) return;
+
+	if (reader->image) {
+		book_image_position(reader->image, reader->image->record + reader->i, p);
+	} else {
+		if (!position_read_fields(p, reader->f) || p->n_link > MAX_MOVE + 1) {
+			error("error while reading %s", reader->file);
+			return;
+		}
+		for (i = 0; i < p->n_link; ++i) {
+			if (!link_read(reader->link + i, reader->f)) break;
+		}
+		if (i < p->n_link || !link_read(&p->leaf, reader->f)) {
+			error("error while reading %s", reader->file);
+			return;
+		}
+		p->link = reader->link;
+	}
+
+	if (reader->i > 0 && !board_lesser(&previous, &p->board)) {
+		error("%s is not sorted by board: compile it first", reader->file);
+		return;
+	}
+
+	++reader->i;
+	reader->ok = true;
+}
+
+/**
+ * @brief Close a book file.
+ *
+ * @param reader Book reader.
+ */
+static void book_reader_close(BookReader *reader)
+{
+	if (reader->f) fclose(reader->f);
+	if (reader->image) {
+		file_unmap(&reader->image->map);
+		free(reader->image);
+	}
+}
+
+/**
+ * @brief Open a book file & read its first position.
+ *
+ * @param reader Book reader.
+ * @param file File name.
+ * @return true in case of success.
+ */
+static bool book_reader_open(BookReader *reader, const char *file)
+{
+	unsigned int header_edax, header_book;
+	unsigned char header_version, header_release;
+	int n_links, n;
+	int r;
+
+	reader->file = file;
+	reader->image = NULL;
+	reader->i = 0;
+	reader->ok = false;
+	reader->f = fopen(file, "rb");
+	if (reader->f == NULL) {
+		error("cannot open %s", file);
+		return false;
+	}
+
+	r = fread(&header_edax, sizeof (unsigned int), 1, reader->f);
+	r += fread(&header_book, sizeof (unsigned int), 1, reader->f);
+	r += fread(&header_version, 1, 1, reader->f);
+	r += fread(&header_release, 1, 1, reader->f);
+	r += fread(&reader->header.date, sizeof reader->header.date, 1, reader->f);
+	r += fread(&reader->header.options, sizeof reader->header.options, 1, reader->f);
+	r += fread(&reader->n_nodes, sizeof reader->n_nodes, 1, reader->f);
+	if (r != 7 || header_edax != EDAX || (header_book != BOOK && header_book != BOOK_IMAGE) || header_version != VERSION) {
+		error("%s is not a compatible edax opening book", file);
+		book_reader_close(reader);
+		return false;
+	}
+
+	if (header_book == BOOK_IMAGE) {
+		r = fread(&n_links, sizeof n_links, 1, reader->f);
+		r += fread(&n, sizeof n, 1, reader->f);
+		fclose(reader->f);
+		reader->f = NULL;
+		if (r == 2) reader->image = book_image_map(file, reader->n_nodes, n_links, n);
+		if (reader->image == NULL) {
+			error("Cannot map compiled book %s", file);
+			return false;
+		}
+	}
+
+	book_reader_next(reader);
+	return reader->ok || reader->n_nodes == 0;
+}
+
+/**
+ * @brief Merge book files into a new book file, in a single pass.
+ *
+ * The input books must be compiled, or saved sorted by board (as this
+ * function does), so that they can be merged like sorted lists, keeping a
+ * single position of each book in memory. The result is the same as loading
+ * the first book & merging the other ones into it, in order: the positions
+ * of the first book are copied whole, the positions found only in the other
+ * books are added as with book_merge(). The resulting book needs to be fixed
+ * before usage.
+ *
+ * @param file Output file name.
+ * @param input Input file names.
+ * @param n_inputs Number of input files.
+ */
+void book_merge_files(const char *file, const char **input, const int n_inputs)
+{
+	unsigned int header_edax = EDAX, header_book = BOOK;
+	unsigned char header_version = VERSION, header_release = RELEASE;
+	char tmp_file[FILENAME_MAX + 1];
+	BookReader *reader;
+	Book header;
+	Position merged;
+	const Position *p;
+	long long t, n_read;
+	long offset;
+	int i, best, n, n_nodes = 0, n_duplicates = 0;
+	bool ok = true;
+	FILE *f;
+	int r;
+
+	if (n_inputs < 1 || n_inputs > BOOK_MERGE_MAX) {
+		error("cannot merge %d books (1 to %d)", n_inputs, BOOK_MERGE_MAX);
+		return;
+	}
+	reader = (BookReader*) malloc(n_inputs * sizeof (BookReader));
+	if (reader == NULL) {
+		error("cannot allocate book readers");
+		return;
+	}
+	for (n = 0; n < n_inputs; ++n) {
+		if (!book_reader_open(reader + n, input[n])) break;
+	}
+	if (n < n_inputs) {
+		while (n--) book_reader_close(reader + n);
+		free(reader);
+		return;
+	}
+
+	file_add_ext(file, ".tmp", tmp_file);
+	f = fopen(tmp_file, "wb");
+	if (f == NULL) {
+		error("cannot open %s", tmp_file);
+		for (i = 0; i < n; ++i) book_reader_close(reader + i);
+		free(reader);
+		return;
+	}
 
-	foreach_position(p_src, a, src) {
-		if (!book_probe(dest, &p_src->board)) {
-			position_merge(&p_dest, p_src);
-			book_add(dest, &p_dest);
+	bprint("Merging %d books into %s...\r", n, file);
+	t = -real_clock();
+	book_set_date(&header);
+	header.options = reader[0].header.options;
+	r = fwrite(&header_edax, sizeof (unsigned int), 1, f);
+	r += fwrite(&header_book, sizeof (unsigned int), 1, f);
+	r += fwrite(&header_version, 1, 1, f);
+	r += fwrite(&header_release, 1, 1, f);
+	r += fwrite(&header.date, sizeof header.date, 1, f);
+	r += fwrite(&header.options, sizeof header.options, 1, f);
+	offset = ftell(f);
+	r += fwrite(&n_nodes, sizeof n_nodes, 1, f); // updated at the end
+	ok = (r == 7);
+
+	while (ok) {
+		// smallest board, from the first book having it
+		for (best = -1, i = 0; i < n; ++i) {
+			if (reader[i].ok && (best < 0 || board_lesser(&reader[i].position.board, &reader[best].position.board))) best = i;
+		}
+		if (best < 0) break;
+
+		if (best == 0) {
+			p = &reader[0].position;
+		} else {
+			position_merge(&merged, &reader[best].position);
+			p = &merged;
 		}
+		ok = position_write(p, f);
+		++n_nodes;
+
+		for (i = best + 1; i < n; ++i) {
+			if (reader[i].ok && board_equal(&reader[i].position.board, &p->board)) {
+				++n_duplicates;
+				book_reader_next(reader + i);
+			}
+		}
+		book_reader_next(reader + best);
+
+		if (n_nodes % BOOK_INFO_RESOLUTION == 0) bprint("Merging %d books into %s...%d positions\r", n, file, n_nodes);
+	}
+
+	for (n_read = i = 0; i < n; ++i) {
+		if (reader[i].i < reader[i].n_nodes) ok = false;
+		n_read += reader[i].i;
+		book_reader_close(reader + i);
+	}
+	free(reader);
+
+	if (ok) ok = (fseek(f, offset, SEEK_SET) == 0 && fwrite(&n_nodes, sizeof n_nodes, 1, f) == 1);
+	if (fclose(f) != 0) ok = false;
+	t += real_clock();
+
+	if (!ok) {
+		error("\nCannot merge books into %s", file);
+		remove(tmp_file);
+	} else if (book_rename(tmp_file, file)) {
+		file_add_ext(file, ".jnl", tmp_file);
+		remove(tmp_file);
+		printf("Merged %d books into %s: %lld positions read, %d written, %d duplicates, in ", n, file, n_read, n_nodes, n_duplicates);
+		time_print(t, false, stdout);
+		printf(" (%.0f positions/s)\n", 1000.0 * n_read / (t + 1));
+	}
+}
+
+/** Minimal number of positions given to a thread by book_parallel(). */
+#define BOOK_PARALLEL_GRAIN 256
+
+/** Number of layers of the book: two per number of empties, for passing positions. */
+#define BOOK_N_LAYERS 122
+
+/**
+ * struct BookWorker
+ * @brief A thread working on a slice of the book's positions.
+ */
+typedef struct BookWorker {
+	Book *book;                                  /**< opening book */
+	const int *position;                         /**< position numbers (or NULL for all) */
+	int begin, end;                              /**< slice of the position numbers */
+	void (*run)(struct BookWorker*, const int);  /**< work on a position */
+	void *data;                                  /**< work specific data */
+	bool changed;                                /**< work specific result flag */
+} BookWorker;
+
+/**
+ * @brief Work on a slice of the book's positions.
+ *
+ * @param data Worker.
+ * @return NULL.
+ */
+static void* book_work(void *data)
+{
+	BookWorker *worker = (BookWorker*) data;
+	int i;
+
+	for (i = worker->begin; i < worker->end; ++i) {
+		worker->run(worker, worker->position ? worker->position[i] : i);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Work on positions in parallel.
+ *
+ * The positions are split into as many slices as tasks, each slice being
+ * processed by its own thread. The work function must only modify its own
+ * position.
+ *
+ * @param book Opening book.
+ * @param position Position numbers, or NULL for 0 to n - 1.
+ * @param n Number of positions.
+ * @param run Work function.
+ * @param data Work specific data.
+ * @return true if a worker has set its result flag.
+ */
+static bool book_parallel(Book *book, const int *position, const int n, void (*run)(BookWorker*, const int), void *data)
+{
+	BookWorker worker[MAX_THREADS];
+	Thread thread[MAX_THREADS];
+	const int n_threads = MAX(1, MIN(MIN(options.n_task, MAX_THREADS), n / BOOK_PARALLEL_GRAIN));
+	bool changed = false;
+	int i;
+
+	for (i = 0; i < n_threads; ++i) {
+		worker[i].book = book;
+		worker[i].position = position;
+		worker[i].begin = (int) ((long long) n * i / n_threads);
+		worker[i].end = (int) ((long long) n * (i + 1) / n_threads);
+		worker[i].run = run;
+		worker[i].data = data;
+		worker[i].changed = false;
+	}
+	for (i = 1; i < n_threads; ++i) thread_create(thread + i, book_work, worker + i);
+	book_work(worker);
+	for (i = 1; i < n_threads; ++i) thread_join(thread[i]);
+	for (i = 0; i < n_threads; ++i) changed |= worker[i].changed;
+
+	return changed;
+}
+
+/**
+ * @brief Layer of a position: positions only link to lower layers.
+ *
+ * A passing position links to a position with the same number of empties,
+ * so it is put one layer above.
+ *
+ * @param position Position.
+ * @return the layer.
+ */
+static int position_layer(const Position *position)
+{
+	return 2 * board_count_empties(&position->board) + (board_get_moves(&position->board) == 0);
+}
+
+/**
+ * struct BookGraph
+ * @brief The links of the book, as position numbers.
+ */
+typedef struct BookGraph {
+	int *first;                /**< first child of each position (n_nodes + 1 entries) */
+	int *child;                /**< children position numbers, in link order */
+} BookGraph;
+
+/**
+ * @brief Find the children of a position, as position numbers.
+ *
+ * @param worker Worker, with its book graph; flagged if a child is missing.
+ * @param k Position number.
+ */
+static void book_graph_probe(BookWorker *worker, const int k)
+{
+	const Book *book = worker->book;
+	const BookGraph *graph = (BookGraph*) worker->data;
+	const Position *p = book_position(book, k);
+	int *child = graph->child + graph->first[k];
+	Board target, unique;
+	unsigned int slot;
+	Link *l;
+
+	foreach_link(l, p) {
+		board_next(&p->board, l->move, &target);
+		board_unique(&target, &unique);
+		if (book_index_find(book, &unique, board_get_hash_code(&unique), &slot)) *child++ = book->index[slot].id - 1;
+		else worker->changed = true;
+	}
+}
+
+/**
+ * @brief Negamax a position whose children are done.
+ *
+ * @param worker Worker, with its book graph; flagged if a position has changed.
+ * @param k Position number.
+ */
+static void book_graph_negamax(BookWorker *worker, const int k)
+{
+	const Book *book = worker->book;
+	const BookGraph *graph = (BookGraph*) worker->data;
+	Position *p = book_position(book, k);
+	Position *child[MAX_MOVE + 1];
+	int i;
+
+	if (p->done) {
+		for (i = graph->first[k]; i < graph->first[k + 1]; ++i) {
+			child[i - graph->first[k]] = book_position(book, graph->child[i]);
+		}
+		if (position_minimax(p, book, child)) worker->changed = true;
 	}
 }
 
 /**
  * @brief Negamax a book.
  *
+ * The positions reachable from the root are negamaxed bottom-up, a layer
+ * of positions with the same number of empties at a time, each layer being
+ * shared among the available tasks.
+ *
  * @param book opening book.
  */
 void book_negamax(Book *book)
 {
-	Position *root = book_root(book);
+	BookGraph graph;
+	int layer[BOOK_N_LAYERS + 1], next[BOOK_N_LAYERS];
+	int *order;
+	int i, j, k, c;
+	Position *root, *p;
 
-	if (root) {
-		bprint("Negamaxing book...");
-		book_clean(book);
+	book_unmap(book);
+	root = book_root(book);
+	if (root == NULL) return;
+
+	bprint("Negamaxing book...");
+	book_clean(book);
+
+	graph.first = (int*) malloc((book->n_nodes + 1) * sizeof (int));
+	order = (int*) malloc((book->n_nodes + 1) * sizeof (int));
+	graph.child = NULL;
+	if (graph.first && order) {
+		graph.first[0] = 0;
+		foreach_position(p, k, book) graph.first[k + 1] = graph.first[k] + p->n_link;
+		graph.child = (int*) malloc((graph.first[book->n_nodes] + 1) * sizeof (int));
+	}
+
+	if (graph.child == NULL) { // not enough memory: recursive negamax
 		position_negamax(root, book);
-		bprint("done\n");
+
+	} else if (book_parallel(book, NULL, book->n_nodes, book_graph_probe, &graph)) {
+		error("missing linked positions: the book needs to be fixed\n");
+
+	} else {
+		// sort the positions by layer
+		for (i = 0; i <= BOOK_N_LAYERS; ++i) layer[i] = 0;
+		foreach_position(p, k, book) ++layer[position_layer(p) + 1];
+		for (i = 0; i < BOOK_N_LAYERS; ++i) layer[i + 1] += layer[i];
+		for (i = 0; i < BOOK_N_LAYERS; ++i) next[i] = layer[i];
+		foreach_position(p, k, book) order[next[position_layer(p)]++] = k;
+
+		// mark the positions reachable from the root, top-down
+		root->done = true;
+		for (i = BOOK_N_LAYERS - 1; i >= 0; --i) {
+			for (j = layer[i]; j < layer[i + 1]; ++j) {
+				k = order[j];
+				if (book_position(book, k)->done) {
+					for (c = graph.first[k]; c < graph.first[k + 1]; ++c) {
+						book_position(book, graph.child[c])->done = true;
+					}
+				}
+			}
+		}
+
+		// negamax them, bottom-up
+		for (i = 0; i < BOOK_N_LAYERS; ++i) {
+			if (book_parallel(book, order + layer[i], layer[i + 1] - layer[i], book_graph_negamax, &graph)) book->need_saving = true;
+		}
 	}
+	free(graph.child);
+	free(graph.first);
+	free(order);
+
+	bprint("done\n");
+}
+
+/**
+ * struct BookLinkChunk
+ * @brief Children of a chunk of positions to link.
+ */
+typedef struct BookLinkChunk {
+	int first;                 /**< first position number of the chunk */
+	Position **child;          /**< children, (PASS + 1) per position */
+} BookLinkChunk;
+
+/**
+ * @brief Find the children of a position of a chunk.
+ *
+ * @param worker Worker, with its chunk.
+ * @param i Position number in the chunk.
+ */
+static void book_link_probe(BookWorker *worker, const int i)
+{
+	const BookLinkChunk *chunk = (BookLinkChunk*) worker->data;
+
+	position_probe_children(book_position(worker->book, chunk->first + i), worker->book, chunk->child + i * (PASS + 1));
 }
 
 /**
  * @brief Link a book.
  *
+ * The children of a chunk of positions are probed in parallel, then the links
+ * are added & the missing best moves searched, in the book order.
+ *
  * @param book opening book.
  */
 void book_link(Book *book)
 {
-	PositionArray *a;
+	BookLinkChunk chunk;
+	int k, n;
 	Position *p;
 	int i = 0;
 
+	book_unmap(book);
+	chunk.child = (Position**) malloc(BOOK_CHUNK_SIZE * (PASS + 1) * sizeof (Position*));
+
 	bprint("Linking book...\r");
-	foreach_position(p, a, book) {
-		position_link(p, book);
-		if (p->leaf.move == NOMOVE) {
-			position_search(p, book);
+	for (chunk.first = 0; chunk.first < book->n_nodes; chunk.first += BOOK_CHUNK_SIZE) {
+		n = MIN(BOOK_CHUNK_SIZE, book->n_nodes - chunk.first);
+		if (chunk.child) book_parallel(book, NULL, n, book_link_probe, &chunk);
+		for (k = 0; k < n; ++k) {
+			p = book_position(book, chunk.first + k);
+			if (chunk.child) position_add_children(p, book, chunk.child + k * (PASS + 1));
+			else position_link(p, book);
+			if (p->leaf.move == NOMOVE) {
+				position_search(p, book);
+			}
+			if (++i % BOOK_INFO_RESOLUTION == 0) bprint("Linking book...%d\r", i);
 		}
-		if (++i % BOOK_INFO_RESOLUTION == 0) bprint("Linking book...%d\r", i);
 	}
+	free(chunk.child);
 	bprint("Linking book...%d done\n", i);
 }
 
@@ -1692,12 +3146,13 @@ void book_link(Book *book)
  */
 void book_fix(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	int i = 0;
+	book_unmap(book);
 
 	bprint("Fixing book...\r"); 
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		if (!position_is_ok(p)) {
 			position_fix(p, book);
 			if (++i % BOOK_INFO_RESOLUTION == 0) { bprint("fixing book...%d\r", i);  }
@@ -1715,16 +3170,17 @@ void book_fix(Book *book)
  */
 void book_deepen(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	int i = 0;
 	unsigned long long t = real_clock();
 	char file[FILENAME_MAX + 1];
 	
 	file_add_ext(options.book_file, ".dep", file);
+	book_unmap(book);
 
 	bprint("Deepening book...\r"); 
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		int n_empties = board_count_empties(&p->board);
 		if (LEVEL[p->level][n_empties].depth != LEVEL[book->options.level][n_empties].depth
 		 || LEVEL[p->level][n_empties].selectivity != LEVEL[book->options.level][n_empties].selectivity) { // No! compare depth & selectivity;
@@ -1733,12 +3189,13 @@ void book_deepen(Book *book)
 			if (++i % 10 == 0) {
 				bprint("Deepening book...%d\r", i); 
 			}
-			if (real_clock() - t > HOUR) {
-				book_save(book, file); // save every hour
+			if (real_clock() - t > options.book_checkpoint * 1000ULL) {
+				book_checkpoint(book, file);
 				t = real_clock();
 			}
 		}
 	}
+	book_journal_close(book);
 	bprint("Deepening book...%d done\n", i);
 }
 
@@ -1751,7 +3208,7 @@ void book_deepen(Book *book)
  */
 void book_correct_solved(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	int i = 0;
 	unsigned long long t = real_clock();
@@ -1761,9 +3218,10 @@ void book_correct_solved(Book *book)
 	char s[4];
 	
 	file_add_ext(options.book_file, ".err", file);
+	book_unmap(book);
 
 	bprint("Correcting solved positions...\r"); 
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		int n_empties = board_count_empties(&p->board);
 		if (LEVEL[p->level][n_empties].depth == n_empties && LEVEL[p->level][n_empties].selectivity == NO_SELECTIVITY) { // No! compare depth & selectivity;
 			old_leaf = p->leaf;
@@ -1779,12 +3237,13 @@ void book_correct_solved(Book *book)
 			if (++i % 10 == 0 || p->leaf.score != old_leaf.score) {
 				bprint("Correcting solved positions...%d (%d error found)\r", i, n_error); 
 			}
-			if (real_clock() - t > HOUR) {
-				book_save(book, file); // save every hour
+			if (real_clock() - t > options.book_checkpoint * 1000ULL) {
+				book_checkpoint(book, file);
 				t = real_clock();
 			}
 		}
 	}
+	book_journal_close(book);
 	bprint("Correcting solved positions...%d done (%d error found)\n", i, n_error);
 }
 
@@ -1799,27 +3258,25 @@ void book_correct_solved(Book *book)
  */
 static void book_expand(Book *book, const char *action, const char *tmp_file)
 {
-	PositionArray *a;
 	Position *p;
 	int i = 0, k;
 	unsigned long long t = real_clock();
 
 	bprint("%s...\r", action);
 	
-	for (a = book->array; a < book->array + book->n; ++a)
-	for (k = 0; k < a->n; ++k) { // do not use foreach_positions here! a->positions may change!
-		p = a->positions + k;
+	foreach_position(p, k, book) { // positions added while expanding are appended & never move.
 		if (p->todo) {
 			position_expand(p, book);
 			bprint("%s...%d/%d done: %d positions, %d links\r", action, ++i, book->stats.n_todo, book->stats.n_nodes, book->stats.n_links);
 			if (book->search->options.verbosity >= 2) putchar('\n'); else putchar('\r');
 			
-			if (real_clock() - t > HOUR) {
-				book_save(book, tmp_file); // save every hour
+			if (real_clock() - t > options.book_checkpoint * 1000ULL) {
+				book_checkpoint(book, tmp_file);
 				t = real_clock();
 			}
 		}
 	}
+	book_journal_close(book);
 	bprint("%s...%d/%d done: %d positions, %d links\n", action, i, book->stats.n_todo, book->stats.n_nodes, book->stats.n_links);
 }
 
@@ -1830,11 +3287,12 @@ static void book_expand(Book *book, const char *action, const char *tmp_file)
  */
 void book_sort(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
+	book_unmap(book);
 
 	bprint("Sorting book...");
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		position_sort(p);
 	}
 	bprint("done>\n");
@@ -1850,16 +3308,17 @@ void book_sort(Book *book)
  */
 void book_play(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	int n_diffs;
 	char file[FILENAME_MAX + 1];
+	book_unmap(book);
 
 	file_add_ext(options.book_file, ".play", file);
 	do {
 		n_diffs = 0;
 		book->stats.n_nodes = book->stats.n_links = book->stats.n_todo = 0;
-		foreach_position(p, a, book) {
+		foreach_position(p, k, book) {
 			if (p->n_link == 0 && board_count_empties(&p->board) >= book->options.n_empties && !board_is_game_over(&p->board)) {
 				p->todo = true; ++book->stats.n_todo;
 			} else {
@@ -1888,19 +3347,17 @@ void book_play(Book *book)
  */
 void book_fill(Book *book, const int depth)
 {
-	PositionArray *a;
 	Position *p;
 	int n_diffs, n_empties, k;
 	char file[FILENAME_MAX + 1];
+	book_unmap(book);
 
 	file_add_ext(options.book_file, ".fill", file);
 
 	do {
 		n_diffs = 0;
 		book->stats.n_nodes = book->stats.n_links = 0;
-		for (a = book->array; a < book->array + book->n; ++a)
-		for (k = 0; k < a->n; ++k) { // do not use foreach_positions here! a->positions may change!
-			p = a->positions + k;
+		foreach_position(p, k, book) { // positions added while filling are appended & never move.
 			n_empties = board_count_empties(&p->board);
 			if (n_empties >= book->options.n_empties) {
 				board_fill(&p->board, book, depth);
@@ -1929,7 +3386,10 @@ void book_fill(Book *book, const int depth)
  */
 void book_deviate(Book *book, Board *board, const int relative_error, const int absolute_error)
 {
-	Position *root = book_probe(book, board);
+	Position *root;
+
+	book_unmap(book);
+	root = book_probe(book, board);
 	if (root) {
 		int score;
 		int n_diffs;
@@ -1976,11 +3436,12 @@ void book_deviate(Book *book, Board *board, const int relative_error, const int
  */
 void book_prune(Book *book)
 {
-	PositionArray *a;
 	Position *p;
-	Position *root = book_root(book);
-	int i;
+	Position *root;
+	int k;
 
+	book_unmap(book);
+	root = book_root(book);
 	if (root) {
 		book_clean(book);
 		position_negamax(root, book);
@@ -1992,9 +3453,8 @@ void book_prune(Book *book)
 
 		position_prune(root, book, 0, 2*SCORE_INF, -SCORE_INF, SCORE_INF);
 		bprint("Book prune %d... done\n", book->stats.n_todo);
-		for (a = book->array; a < book->array + book->n; ++a)
-		for (i = 0; i < a->n; ++i) if (!a->positions[i].done) {book_remove(book, a->positions + i); --i;}
-		foreach_position(p, a, book) position_remove_links(p, book);
+		book_remove_undone(book);
+		foreach_position(p, k, book) position_remove_links(p, book);
 		bprint("done\n");
 	}
 }
@@ -2008,11 +3468,12 @@ void book_prune(Book *book)
  */
 void book_subtree(Book *book, const Board *board)
 {
-	PositionArray *a;
 	Position *p;
-	Position *root = book_probe(book, board);
-	int i;
+	Position *root;
+	int k;
 
+	book_unmap(book);
+	root = book_probe(book, board);
 	if (root) {
 		book_clean(book);
 		position_negamax(root, book);
@@ -2021,9 +3482,8 @@ void book_subtree(Book *book, const Board *board)
 		position_prune(root, book, 2*SCORE_INF, 2*SCORE_INF, -SCORE_INF, SCORE_INF);
 		position_print(root, &root->board, stdout);
 		bprint("Book subtree %d... done\n", book->stats.n_todo);
-		for (a = book->array; a < book->array + book->n; ++a)
-		for (i = 0; i < a->n; ++i) if (!a->positions[i].done) {book_remove(book, a->positions + i); --i;}
-		foreach_position(p, a, book) position_remove_links(p, book);
+		book_remove_undone(book);
+		foreach_position(p, k, book) position_remove_links(p, book);
 		bprint("done\n");
 	}
 }
@@ -2039,7 +3499,10 @@ void book_subtree(Book *book, const Board *board)
  */
 void book_enhance(Book *book, Board *board, const int midgame_error, const int endcut_error)
 {
-	Position *root = book_probe(book, board);
+	Position *root;
+
+	book_unmap(book);
+	root = book_probe(book, board);
 	if (root) {
 		int n_diffs;
 		char file[FILENAME_MAX + 1];
@@ -2075,15 +3538,16 @@ void book_enhance(Book *book, Board *board, const int midgame_error, const int e
  */
 void book_info(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	unsigned long long n_links = 0;
 	unsigned long long n_leaves = 0;
 	unsigned long long n_level[61] = {0};
-	int min_array = book->n_nodes, max_array = 0;
+	unsigned long long n_probes = 0;
 	int i;
+	book_unmap(book);
 
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		n_links += p->n_link;
 		if (p->leaf.move != NOMOVE) ++n_leaves;
 		++n_level[p->level];
@@ -2092,9 +3556,8 @@ void book_info(Book *book)
 		}
 	}
 
-	for (a = book->array; a < book->array + book->n; ++a) {
-		if (a->n > max_array) max_array = a->n;
-		if (a->n < min_array) min_array = a->n;
+	for (i = 0; i < book->n; ++i) {
+		if (book->index[i].id) n_probes += book_index_distance(book, i) + 1;
 	}
 
 	bprint("Edax Book %d.%d; ", VERSION, RELEASE);
@@ -2107,8 +3570,8 @@ void book_info(Book *book)
 		}
 	}
 	bprint("Depth: %d\n", 61 - book->options.n_empties);
-	bprint("Memory occupation: %lld\n", (long long) (book->n_nodes * sizeof (Position) + book->n * sizeof (PositionArray) + n_links * sizeof (Link)));
-	bprint("Hash balance: %d < %d < %d\n", min_array, (int) (book->n_nodes / book->n), max_array);
+	bprint("Memory occupation: %lld\n", (long long) (book->n_chunks * BOOK_CHUNK_SIZE * sizeof (Position) + book->n * sizeof (PositionIndex) + book->links->n_blocks * LINK_SLAB_BLOCK * sizeof (Link)));
+	bprint("Hash load: %.1f %%; mean probe length: %.2f\n", 100.0 * book->n_nodes / book->n, book->n_nodes ? (double) n_probes / book->n_nodes : 0.0);
 }
 
 /**
@@ -2120,7 +3583,7 @@ void book_info(Book *book)
 void book_show(Book *book, Board *board)
 {
 	GameStats stat = {0,0,0,0};
-	Position *position = book_probe(book, board);
+	Position buffer, *position = book_get_position(book, board, &buffer);
 	unsigned long long n_games;
 
 	if (position) {
@@ -2145,7 +3608,7 @@ void book_show(Book *book, Board *board)
  */
 bool book_get_moves(Book *book, const Board *board, MoveList *movelist)
 {
-	Position *position = book_probe(book, board);
+	Position buffer, *position = book_get_position(book, board, &buffer);
 	if (position) {
 		position_get_moves(position, board, movelist);
 		return true;
@@ -2164,14 +3627,14 @@ bool book_get_moves(Book *book, const Board *board, MoveList *movelist)
  */
 void book_get_line(Book *book, const Board *board, const Move *move, Line *line)
 {
-	Position *position;
+	Position buffer, *position;
 	Board b;
 	Move m;
 
 	line_push(line, move->x);
 	board_next(board, move->x, &b);
 
-	while ((position = book_probe(book, &b)) != NULL && !board_is_game_over(&position->board)) {
+	while ((position = book_get_position(book, &b, &buffer)) != NULL && !board_is_game_over(&position->board)) {
 		position_get_random_move(position, &b, &m, &book->random, 0);
 		line_push(line, m.x);
 		board_update(&b, &m);
@@ -2192,7 +3655,7 @@ void book_get_line(Book *book, const Board *board, const Move *move, Line *line)
 #else
 bool book_get_random_move(Book *book, const Board *board, Move *move, const int randomness)
 {
-	Position *position = book_probe(book, board);
+	Position buffer, *position = book_get_position(book, board, &buffer);
 	if (position) {
 		position_get_random_move(position, board, move, &book->random, randomness);
 		return true;
@@ -2211,7 +3674,7 @@ bool book_get_random_move(Book *book, const Board *board, Move *move, const int
  */
 void book_get_game_stats(Book *book, const Board *board, GameStats *stat)
 {
-	Position *position;
+	Position buffer, *position;
 
 	assert(book != NULL);
 	assert(board !=NULL);
@@ -2219,7 +3682,7 @@ void book_get_game_stats(Book *book, const Board *board, GameStats *stat)
 	
 	stat->n_wins = stat->n_losses = stat->n_draws = stat->n_lines = 0;
 
-	position = book_probe(book, board);
+	position = book_get_position(book, board, &buffer);
 	if (position) {
 		if (position->n_wins == UINT_MAX || position->n_losses == UINT_MAX || position->n_draws == UINT_MAX || position->n_lines == UINT_MAX) {
 			Board target;
@@ -2255,6 +3718,7 @@ void book_add_board(Book *book, const Board *board)
 	Position position;
 	Position *probe;
 
+	book_unmap(book);
 	if (board_count_empties(board) >= book->options.n_empties - 1) {
 		probe = book_probe(book, board);
 		if (probe) {
@@ -2287,6 +3751,7 @@ void book_add_game(Book *book, const Game *game)
 	int i, n_moves;
 	char file[FILENAME_MAX + 1];
 	const int n_stats = book->stats.n_nodes + book->stats.n_links;
+	book_unmap(book);
 
 	file_add_ext(options.book_file, ".gam", file);
 	
@@ -2324,8 +3789,10 @@ void book_add_game(Book *book, const Game *game)
 void book_add_base(Book *book, const Base *base)
 {
 	int i;
+	Game game;
 	char file[FILENAME_MAX + 1];
 	long long t0, t;
+	book_unmap(book);
 
 	file_add_ext(options.book_file, ".gam", file);
 
@@ -2333,7 +3800,7 @@ void book_add_base(Book *book, const Base *base)
 	bprint("Adding %d games to book...\n", base->n_games);
 	t0 = real_clock();
 	for (i = 0; i < base->n_games; ++i) {
-		book_add_game(book, base->game + i);
+		book_add_game(book, base_get_game(base, i, &game));
 		t = real_clock();
 		if (t - t0 > 1000) {
 		    bprint("Adding games...%d/%d done: %d positions, %d links\r", i + 1, base->n_games, book->stats.n_nodes, book->stats.n_links);
@@ -2412,13 +3879,14 @@ void book_check_game(Book *book, MoveHash *hash, const Game *game, BookCheckGame
 void book_check_base(Book *book, const Base *base)
 {
 	int i;
+	Game game;
 	BookCheckGame stat = {0, 0, 0};
 	MoveHash hash;
 
 	bprint("Checking %d games to book...\n", base->n_games);
 	movehash_init(&hash, options.hash_table_size);
 	for (i = 0; i < base->n_games; ++i) {
-		book_check_game(book, &hash, base->game + i, &stat);
+		book_check_game(book, &hash, base_get_game(base, i, &game), &stat);
 	}
 	movehash_delete(&hash);
     bprint("Positions : %llu missing, %llu good, %llu bad (%.2f%% bad)\n", stat.missing, stat.good, stat.bad, (100.0 * stat.bad)/(stat.bad + stat.good));
@@ -2503,15 +3971,16 @@ void book_extract_skeleton(Book *book, Base *base)
  */
 void book_extract_positions(Book *book, const int n_empties, const int n_positions)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	MoveList movelist;
 	Move *best, *second_best;
 	int i = 0;
 	char s[80];
+	book_unmap(book);
 
 	bprint("Extracting %d positions at %d ...\n", n_positions, n_empties); 
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		if (i == n_positions) break;
 		if (board_count_empties(&p->board) == n_empties) {
 			position_get_moves(p, &p->board, &movelist);
@@ -2539,29 +4008,31 @@ void book_extract_positions(Book *book, const int n_empties, const int n_positio
  */
 void book_stats(Book *book)
 {
-	PositionArray *a;
+	int k;
 	Position *p;
 	int i;
 	unsigned long long n_hash[256];
 	unsigned long long n_pos[61], n_leaf[61], n_link[61], n_terminal[61];
 	unsigned long long n_score[129];
+	book_unmap(book);
 
 	printf("\n\nBook statistics:\n");
 
-	printf("\nHash distribution:\n");
+	printf("\nHash probe distance distribution:\n");
 	for (i = 0; i < 256; ++i) n_hash[i] = 0;
-	for (a = book->array; a < book->array + book->n; ++a) {
-		if (a->n < 256) ++n_hash[a->n];
+	for (k = 0; k < book->n; ++k) if (book->index[k].id) {
+		const int d = book_index_distance(book, k);
+		if (d < 256) ++n_hash[d];
 		else ++n_hash[255];
 	}
-	printf("index    positions\n");
+	printf("distance positions\n");
 	for (i = 0; i < 255; ++i) if (n_hash[i]) printf("%5d %12llu\n", i, n_hash[i]);
 	if (n_hash[i]) printf(">%4d %12llu\n", i - 1, n_hash[i]);
 
 	printf("\nStage distribution:\n");
 	printf("stage    positions        links       leaves      terminal nodes\n");
 	for (i = 0; i < 61; ++i) n_pos[i] = n_leaf[i] = n_link[i] = n_terminal[i] = 0;
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		i = board_count_empties(&p->board);
 		++n_pos[i];
 		if (p->leaf.move != NOMOVE) ++n_leaf[i];
@@ -2573,7 +4044,7 @@ void book_stats(Book *book)
 	printf("\nBest Score Distribution:\n");
 	printf("Score    positions\n");
 	for (i = 0; i < 129; ++i) n_score[i] = 0;
-	foreach_position(p, a, book) {
+	foreach_position(p, k, book) {
 		++n_score[64 + p->score.value];
 	}
 	for (i = 0; i < 129; ++i) if (n_score[i]) printf("%+5d %12llu\n", i - 64, n_score[i]);
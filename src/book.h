@@ -18,6 +18,9 @@
 #include "util.h"
 #include <stdbool.h>
 
+/** Maximal number of books merged by book_merge_files(). */
+#define BOOK_MERGE_MAX 64
+
 /**
  * struct Book
  * @brief The opening book.
@@ -40,10 +43,16 @@ typedef struct Book {
 		int n_links;
 		int n_todo;
 	} stats;
-	struct PositionArray *array;
+	struct PositionIndex *index;    /**< open-addressing index of the positions */
+	struct Position **chunk;        /**< position arena, made of fixed-size chunks */
+	struct LinkSlab *links;         /**< link arrays allocator */
 	struct PositionStack* stack;
-	int n;
-	int n_nodes;
+	int n;                          /**< index size */
+	int n_chunks;                   /**< number of allocated chunks */
+	int n_nodes;                    /**< number of positions */
+	int n_buckets;                  /**< number of hash buckets ordering the saved positions */
+	struct BookImage *image;        /**< compiled book, mapped read-only */
+	struct BookJournal *journal;    /**< change journal of the running book job */
 	bool need_saving;
 	Random random;
 	Search *search;
@@ -66,6 +75,8 @@ void book_free(Book*);
 void book_new(Book*, int, int);
 void book_load(Book*, const char*);
 void book_save(Book*, const char*);
+void book_compile(Book*, const char*);
+void book_merge_files(const char*, const char**, const int);
 void book_import(Book*, const char*);
 void book_export(Book*, const char*);
 void book_merge(Book*, const Book*);
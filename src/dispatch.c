@@ -0,0 +1,247 @@
+/**
+ * @file dispatch.c
+ *
+ * Entry of a dispatched executable.
+ *
+ * The flip, last flip & eval kernels are chosen at compile time from the
+ * target instruction set (see settings.h). A dispatched executable links
+ * together whole builds of Edax (all.c) for several x86-64 levels, each
+ * with its own main renamed (EDAX_MAIN), and runs the best one the CPU
+ * supports. The -autotune option times each kernel of every supported build
+ * on this host & saves the fastest build to DISPATCH_FILE, next to the
+ * executable, read at next starts.
+ * This file must be compiled for the baseline x86-64 only.
+ *
+ * @date 2025
+ * @author Toshihiko Okuhara
+ * @version 4.5
+ */
+
+#if defined(__unix__)
+#define _POSIX_C_SOURCE 200112L	// readlink
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+int edax_main_x86_64_v2(int, char**);
+int edax_main_x86_64_v3(int, char**);
+int edax_main_x86_64_v4(int, char**);
+void edax_bench_x86_64_v2(double*);
+void edax_bench_x86_64_v3(double*);
+void edax_bench_x86_64_v4(double*);
+
+/** autotuned build */
+#define DISPATCH_FILE "dispatch.ini"
+
+/** builds linked in, best first */
+static const struct {
+	const char *name;
+	int (*main)(int, char**);
+	void (*bench)(double*);
+} ISA[] = {
+	{ "x86-64-v4", edax_main_x86_64_v4, edax_bench_x86_64_v4 },
+	{ "x86-64-v3", edax_main_x86_64_v3, edax_bench_x86_64_v3 },
+	{ "x86-64-v2", edax_main_x86_64_v2, edax_bench_x86_64_v2 }
+};
+
+enum { N_ISA = sizeof ISA / sizeof ISA[0] };
+
+/** kernels timed by the builds (see bench_kernels in bench.c) */
+static const char *KERNEL[] = {"get_moves", "flip", "last_flip", "eval_update"};
+
+enum { N_KERNEL = sizeof KERNEL / sizeof KERNEL[0] };
+
+/**
+ * @brief Check if the CPU (and the OS) support an instruction set level.
+ *
+ * @param i ISA index.
+ * @return true if supported.
+ */
+static int isa_supported(const int i)
+{
+	__builtin_cpu_init();
+	switch (i) {
+	case 0:
+		if (!(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+		   && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq")
+		   && __builtin_cpu_supports("avx512cd"))) return 0;
+		// fall through
+	case 1:
+		if (!(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")
+		   && __builtin_cpu_supports("fma"))) return 0;
+		// fall through
+	default:
+		return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+	}
+}
+
+/**
+ * @brief Look for a build by name.
+ *
+ * @param name Build name.
+ * @return build index, or -1 if unknown or not supported.
+ */
+static int isa_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < N_ISA && strcmp(name, ISA[i].name) != 0; ++i) ;
+	if (i == N_ISA) {
+		fprintf(stderr, "Unknown isa: %s\n", name);
+		return -1;
+	}
+	if (!isa_supported(i)) {
+		fprintf(stderr, "%s is not supported by this cpu\n", name);
+		return -1;
+	}
+	return i;
+}
+
+/**
+ * @brief Locate the autotuned build file.
+ *
+ * The file lies next to the executable, found from /proc/self/exe or from
+ * the command line, or in the data directory when the executable directory
+ * is unknown, so that the result does not depend on the current directory.
+ *
+ * @param path Path of the file (output).
+ * @param size Size of the path buffer.
+ * @param argv0 Executable name, as given on the command line.
+ */
+static void isa_path(char *path, const size_t size, const char *argv0)
+{
+	char *slash;
+	long n = -1;
+
+#if defined(__unix__)
+	n = readlink("/proc/self/exe", path, size - 1);
+#endif
+	if (n <= 0 || (size_t) n >= size - 1) {
+		n = argv0 ? strlen(argv0) : 0;
+		if ((size_t) n >= size) n = 0;
+		if (n) memcpy(path, argv0, n);
+	}
+	path[n] = '\0';
+
+	slash = strrchr(path, '/');
+	if (slash == NULL) slash = strrchr(path, '\\');
+	if (slash && (size_t) (slash - path) + sizeof DISPATCH_FILE + 1 < size) strcpy(slash + 1, DISPATCH_FILE);
+	else snprintf(path, size, "data/%s", DISPATCH_FILE);
+}
+
+/**
+ * @brief Read the autotuned build.
+ *
+ * @param file Autotuned build file.
+ * @return build index, or -1 if none.
+ */
+static int isa_load(const char *file)
+{
+	FILE *f = fopen(file, "r");
+	char line[256], name[32];
+	int i = -1;
+
+	if (f == NULL) return -1;
+	while (i < 0 && fgets(line, sizeof line, f)) {
+		if (sscanf(line, " isa = %31s", name) == 1) i = isa_find(name);
+	}
+	fclose(f);
+	return i;
+}
+
+/**
+ * @brief Time the kernels of every supported build & save the fastest.
+ *
+ * Each kernel is timed in every build, and the fastest build of each kernel
+ * is reported. As the kernels are inlined into the search of their build, a
+ * build is run as a whole: the selected one is the build with the least
+ * total time of its kernels, i.e. the one whose own kernels win overall.
+ * The per-kernel timings are saved with the selection, as comments.
+ *
+ * @param file Autotuned build file.
+ * @return fastest build index.
+ */
+static int isa_autotune(const char *file)
+{
+	FILE *f;
+	double t[N_ISA][N_KERNEL], total[N_ISA], t_best = 1e30;
+	int i, k, best = N_ISA - 1, kernel_best[N_KERNEL];
+
+	for (k = 0; k < N_KERNEL; ++k) kernel_best[k] = -1;
+
+	printf("%-12s", "cycles");
+	for (k = 0; k < N_KERNEL; ++k) printf(" %12s", KERNEL[k]);
+	printf(" %12s\n", "total");
+	for (i = 0; i < N_ISA; ++i) {
+		if (!isa_supported(i)) continue;
+		ISA[i].bench(t[i]);
+		total[i] = 0.0;
+		printf("%-12s", ISA[i].name);
+		for (k = 0; k < N_KERNEL; ++k) {
+			printf(" %12.2f", t[i][k]);
+			total[i] += t[i][k];
+			if (kernel_best[k] < 0 || t[i][k] < t[kernel_best[k]][k] * 0.98) kernel_best[k] = i;
+		}
+		printf(" %12.2f\n", total[i]);
+		if (total[i] < t_best * 0.98) {	// prefer the higher level when they are on par
+			t_best = total[i];
+			best = i;
+		}
+	}
+	for (k = 0; k < N_KERNEL; ++k) printf("fastest %s: %s\n", KERNEL[k], ISA[kernel_best[k]].name);
+	printf("fastest build: %s\n", ISA[best].name);
+
+	f = fopen(file, "w");
+	if (f == NULL) fprintf(stderr, "Cannot write %s\n", file);
+	else {
+		fprintf(f, "# fastest build on this host, written by -autotune\n");
+		for (k = 0; k < N_KERNEL; ++k) {
+			fprintf(f, "# %s:", KERNEL[k]);
+			for (i = 0; i < N_ISA; ++i) if (isa_supported(i)) fprintf(f, " %s %.2f", ISA[i].name, t[i][k]);
+			fprintf(f, " -> %s\n", ISA[kernel_best[k]].name);
+		}
+		fprintf(f, "isa = %s\n", ISA[best].name);
+		fclose(f);
+	}
+	return best;
+}
+
+/**
+ * @brief dispatched main function.
+ *
+ * Select the build from the -isa <x86-64-vN> option, from -autotune or its
+ * saved result, or from CPUID. These options are removed from the arguments
+ * passed to the selected build.
+ *
+ * @param argc Number of arguments.
+ * @param argv Command line arguments.
+ */
+int main(int argc, char **argv)
+{
+	int i, j, k = -1, autotune = 0;
+	char file[4096];
+
+	for (i = j = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		while (*arg == '-') ++arg;
+		if (strcmp(arg, "isa") == 0 && argv[i + 1]) k = isa_find(argv[++i]);
+		else if (strcmp(arg, "autotune") == 0) autotune = 1;
+		else argv[j++] = argv[i];
+	}
+	argv[argc = j] = NULL;
+	isa_path(file, sizeof file, argv[0]);
+
+	if (autotune) {
+		k = isa_autotune(file);
+		if (argc == 1) return 0;
+	}
+	if (k < 0) k = isa_load(file);
+	if (k < 0) for (k = 0; k < N_ISA - 1 && !isa_supported(k); ++k) ;	// x86-64-v2 as the last resort
+
+	return ISA[k].main(argc, argv);
+}
@@ -50,7 +50,9 @@
  *   -new <n1> <n2>       create a new empty book with level <n1> and depth <n2>.
  *   -load [file]         load an opening book from a binary opening file.
  *   -merge [file]        merge an opening book with the current opening book.
+ *   -merge-files <out> <files>  merge sorted or compiled book files into <out>.
  *   -save [file]         save an opening book to a binary opening file.
+ *   -compile [file]      save an opening book to a read-only, memory-mapped file.
  *   -import [file]       load an opening book from a portable text file.
  *   -export [file]       save an opening book to a portable text file.
  *   -on                  use the opening book.
@@ -95,6 +97,7 @@
  *
  */
 
+#include "bench.h"
 #include "cassio.h"
 #include "event.h"
 #include "histogram.h"
@@ -115,7 +118,6 @@ static Log edax_log[1];
 extern bool book_verbose;
 
 void version(void);
-void bench(void);
 
 /**
  * @brief default search oberver.
@@ -223,7 +225,9 @@ void help_book(void)
 		"  new <n1> <n2>       create a new empty book with level <n1> and depth <n2>.\n"
 		"  load [file]         load an opening book from a binary opening file.\n"
 		"  merge [file]        merge an opening book with the current opening book.\n"
+		"  merge-files <out> <files>  merge sorted or compiled book files into <out>.\n"
 		"  save [file]         save an opening book to a binary opening file.\n"
+		"  compile [file]      save an opening book to a read-only, memory-mapped file.\n"
 		"  import [file]       load an opening book from a portable text file.\n"
 		"  export [file]       save an opening book to a portable text file.\n"
 		"  on                  use the opening book.\n"
@@ -298,6 +302,7 @@ void ui_loop_edax(UI *ui)
 	int repeat = options.repeat;
 
 	histogram_init(histogram);
+	if (options.repeat > 1) search_recorder_start(&search_recorder);
 
 	// loop forever
 	for (;;) {
@@ -328,6 +333,10 @@ void ui_loop_edax(UI *ui)
 					play_new(play);
 					continue;
 				}
+				if (search_recorder.is_recording) {
+					search_recorder_print(&search_recorder, stdout);
+					search_recorder_stop(&search_recorder);
+				}
 				if (options.auto_quit) {
 					return;
 				}
@@ -667,6 +676,11 @@ void ui_loop_edax(UI *ui)
 					parse_word(book_param, book_file, FILENAME_MAX);
 					book_save(book, book_file);
 
+				// compile an opening book (read-only, mapped format) to the disc
+				} else if (strcmp(book_cmd, "compile") == 0) {
+					parse_word(book_param, book_file, FILENAME_MAX);
+					book_compile(book, book_file);
+
 				// import an opening book (text format)
 				} else if (strcmp(book_cmd, "import") == 0) {
 					book_free(book);
@@ -692,6 +706,19 @@ void ui_loop_edax(UI *ui)
 					book_free(&src);
 					warn("Book needs to be fixed before usage\n");
 
+				// merge opening book files into a new one, without loading them
+				} else if (strcmp(book_cmd, "merge-files") == 0) {
+					char *input[BOOK_MERGE_MAX];
+					int n;
+					book_param = parse_word(book_param, book_file, FILENAME_MAX);
+					for (n = 0; n < BOOK_MERGE_MAX && *(book_param = parse_skip_spaces(book_param)); ++n) {
+						if ((input[n] = (char*) malloc(FILENAME_MAX + 1)) == NULL) break;
+						book_param = parse_word(book_param, input[n], FILENAME_MAX);
+					}
+					book_merge_files(book_file, (const char**) input, n);
+					while (n--) free(input[n]);
+					warn("Book needs to be fixed before usage\n");
+
 				// fix an opening book
 				} else if (strcmp(book_cmd, "fix") == 0) {
 					book_fix(book); // do nothing (or edax is buggy)
@@ -756,7 +783,7 @@ void ui_loop_edax(UI *ui)
 					Base base;
 					parse_word(book_param, book_file, FILENAME_MAX);
 					base_init(&base);
-					base_load(&base, book_file);
+					base_map(&base, book_file);
 					book_add_base(book, &base);
 					base_free(&base);
 
@@ -765,7 +792,7 @@ void ui_loop_edax(UI *ui)
 					Base base;
 					parse_word(book_param, book_file, FILENAME_MAX);
 					base_init(&base);
-					base_load(&base, book_file);
+					base_map(&base, book_file);
 					book_check_base(book, &base);
 					base_free(&base);
 
@@ -837,7 +864,7 @@ void ui_loop_edax(UI *ui)
 					base_param = parse_int(base_param, &n_empties);
 					base_param = parse_word(base_param, problem_file, FILENAME_MAX);
 
-					base_load(&base, base_file);
+					base_map(&base, base_file);
 					base_to_problem(&base, n_empties, problem_file);
 
 				// extract FEN 
@@ -847,7 +874,7 @@ void ui_loop_edax(UI *ui)
 					base_param = parse_int(base_param, &n_empties);
 					base_param = parse_word(base_param, problem_file, FILENAME_MAX);
 
-					base_load(&base, base_file);
+					base_map(&base, base_file);
 					base_to_FEN(&base, n_empties, problem_file);
 	
 				// correct erroneous games
@@ -877,7 +904,7 @@ void ui_loop_edax(UI *ui)
 
 				// convert a base to another format
 				} else if (strcmp(base_cmd, "convert") == 0) {
-					base_load(&base, base_file);
+					base_map(&base, base_file);
 					base_param = parse_word(base_param, base_file, FILENAME_MAX);
 					base_save(&base, base_file);
 
@@ -904,7 +931,7 @@ void ui_loop_edax(UI *ui)
 			} else if (options_read(cmd, param)) {
 				options_bound();
 				// parallel search changes:
-				if (search_count_tasks(&play->search) != options.n_task) {
+				if (play->search.tasks->n != options.n_task) {
 					play_stop_pondering(play);
 					search_set_task_number(&play->search, options.n_task);
 				}
@@ -245,7 +245,7 @@ static int search_solve_3(unsigned long long player, unsigned long long opponent
  * @param alpha Upper score value.
  * @return The final min score, as a disc difference.
  */
-static int search_solve_4(Search *search, int alpha)
+int search_solve_4(Search *search, int alpha)
 {
 	unsigned long long player, opponent, flipped, next_player, next_opponent;
 	int x1, x2, x3, x4, tmp, paritysort, score, bestscore, pol;
@@ -371,7 +371,7 @@ static int search_solve_4(Search *search, int alpha)
  * @param alpha Alpha bound.
  * @return The final score, as a disc difference.
  */
-static int search_shallow(Search *search, const int alpha, bool pass1)
+int search_shallow(Search *search, const int alpha, bool pass1)
 {
 	unsigned long long moves, prioritymoves;
 	int x, prev, score, bestscore;
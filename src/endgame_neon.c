@@ -199,7 +199,7 @@ static int search_solve_3(uint64x2_t OP, int alpha, volatile unsigned long long
  * @return The final min score, as a disc difference.
  */
 
-static int search_solve_4(Search *search, int alpha)
+int search_solve_4(Search *search, int alpha)
 {
 	uint64x2_t	OP, flipped;
 	uint8x16_t	empties_series;	// B15:4th, B11:3rd, B7:2nd, B3:1st, lower 3 bytes for 3 empties
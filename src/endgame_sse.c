@@ -208,7 +208,7 @@ static int vectorcall search_solve_3(__m128i OP, int alpha, volatile unsigned lo
 	#define	v3_empties(empties,i,shuf,sort3)	v3_empties_0(_mm_shufflelo_epi16((empties), (shuf)), (sort3))
 #endif
 
-static int search_solve_4(Search *search, int alpha)
+int search_solve_4(Search *search, int alpha)
 {
 	__m128i	OP, flipped;
 	__m128i	empties_series;	// (AVX) B15:4th, B11:3rd, B7:2nd, B3:1st, lower 3 bytes for 3 empties
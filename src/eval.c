@@ -18,7 +18,9 @@
 #include "util.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <sys/stat.h>
 
 #if !defined(VECTOR_EVAL_UPDATE) && !defined(hasSSE2) && !defined(__ARM_NEON)
 
@@ -477,6 +479,31 @@ static int EVAL_LOADED = 0;
 /** eval weights */
 Eval_weight (*EVAL_WEIGHT)[EVAL_N_PLY - 2];	// for 2..53
 
+/** quantized eval weights (NULL if unused) */
+Eval_weight_8 (*EVAL_WEIGHT_8)[EVAL_N_PLY - 2];
+
+/** mapping of the unpacked weights cache (if used) */
+static FileMap EVAL_CACHE_MAP;
+
+/** unpacked weights cache tag & format */
+#define EVAL_CACHE 0x45564243
+#define EVAL_CACHE_FORMAT 1
+
+/** header of the unpacked weights cache, followed by the weights of all plies */
+typedef struct EvalCacheHeader {
+	unsigned int edax;           /**< EDAX */
+	unsigned int tag;            /**< EVAL_CACHE */
+	unsigned int format;         /**< EVAL_CACHE_FORMAT */
+	unsigned int size;           /**< size of the weights */
+	unsigned int version;        /**< evaluation function version */
+	unsigned int release;        /**< evaluation function release */
+	unsigned int build;          /**< evaluation function build */
+	unsigned int padding;
+	long long source_size;       /**< size of the evaluation file */
+	long long source_time;       /**< modification time of the evaluation file */
+	long long reserved[2];       /**< 64 bytes in all */
+} EvalCacheHeader;
+
 /** opponent feature */
 static unsigned short *OPPONENT_FEATURE;
 
@@ -553,16 +580,14 @@ static int set_eval_packing(short *pe, int *T, const int *kd, int l, int k, int
 }
 
 /**
- * @brief Load the evaluation function features' weights.
+ * @brief Unpack the evaluation function features' weights.
  *
- * The weights are stored in a global variable, because, once loaded from the
- * file, they stay constant during the lifetime of the program. As loading
- * the weights is time & resource consuming, a counter variable check that
- * the weights are effectively loaded only once.
+ * Read the packed weights & unpack them for all the plies & their symetries.
  *
  * @param file File name of the evaluation function data.
+ * @param header Cache header, to fill with the weights' version.
  */
-void eval_open(const char* file)
+static void eval_unpack(const char* file, EvalCacheHeader *header)
 {
 	unsigned int edax_header, eval_header;
 	unsigned int version, release, build;
@@ -580,23 +605,12 @@ void eval_open(const char* file)
 	static const int kd_C10[] = { 19683, 6561, 2187, 729, 81, 243, 27, 9, 3, 1 };
 	static const int kd_C9[] = { 1, 9, 3, 81, 27, 243, 2187, 729, 6561 };
 
-	if (EVAL_LOADED++) return;
-
-	// the following is assumed:
-	//	-(unsigned) int are 32 bits
-	if (sizeof (int) != 4) fatal_error("int size is not compatible with Edax.\n");
-	//	-(unsigned) short are 16 bits
-	if (sizeof (short) != 2) fatal_error("short size is not compatible with Edax.\n");
-
 	// create unpacking tables
-	OPPONENT_FEATURE = (unsigned short *) malloc(59049 * sizeof(unsigned short));	// 3^10
 	P = (SymetryPacking (*)[2]) malloc(2 * sizeof(*P));
 	T = (int *) malloc(2 * 59049 * sizeof(*T));
-	if ((OPPONENT_FEATURE == NULL) || (P == NULL) || (T == NULL))
+	if ((P == NULL) || (T == NULL))
 		fatal_error("Cannot allocate temporary table variable.\n");
 
-	set_opponent_feature(OPPONENT_FEATURE, 0, 10);
-
 	set_eval_packing((*P)[0].EVAL_S8, T, kd_S10 + 2, 0, 0, 0, 8);	/* 8 squares : 6561 -> 3321 */
 	for (j = 0; j < 6561; ++j)
 		(*P)[1].EVAL_S8[j] = (*P)[0].EVAL_S8[OPPONENT_FEATURE[j + 26244]];	// 1100000000(3)
@@ -701,16 +715,167 @@ void eval_open(const char* file)
 	free(w);
 	free(P);
 
+	header->version = version;
+	header->release = release;
+	header->build = build;
+}
+
+/**
+ * @brief Get the cache file name of an evaluation file.
+ *
+ * @param file File name of the evaluation function data.
+ * @param cache_file Output cache file name.
+ */
+static void eval_cache_file(const char *file, char *cache_file)
+{
+	if (strlen(file) + 5 > FILENAME_MAX) *cache_file = '\0';
+	else file_add_ext(file, ".bin", cache_file);
+}
+
+/**
+ * @brief Map the unpacked weights cache.
+ *
+ * The cache is only used if it was built by this version of Edax from the
+ * current evaluation file, as identified by its size & modification time.
+ *
+ * @param file File name of the evaluation function data.
+ * @param header Expected cache header, completed with the weights' version.
+ * @return true if the cache is mapped.
+ */
+static bool eval_map_cache(const char *file, EvalCacheHeader *header)
+{
+	char cache_file[FILENAME_MAX + 1];
+	const EvalCacheHeader *cache;
+
+	eval_cache_file(file, cache_file);
+	if (*cache_file == '\0' || !file_map(&EVAL_CACHE_MAP, cache_file)) return false;
+
+	cache = (const EvalCacheHeader*) EVAL_CACHE_MAP.data;
+	if (EVAL_CACHE_MAP.size != sizeof (EvalCacheHeader) + sizeof (*EVAL_WEIGHT)
+	 || cache->edax != header->edax || cache->tag != header->tag || cache->format != header->format || cache->size != header->size
+	 || cache->source_size != header->source_size || cache->source_time != header->source_time) {
+		file_unmap(&EVAL_CACHE_MAP);
+		return false;
+	}
+
+	header->version = cache->version;
+	header->release = cache->release;
+	header->build = cache->build;
+	EVAL_WEIGHT = (Eval_weight(*)[EVAL_N_PLY - 2]) ((char*) EVAL_CACHE_MAP.data + sizeof (EvalCacheHeader));
+
+	return true;
+}
+
+/**
+ * @brief Save the unpacked weights cache.
+ *
+ * The file is written under a temporary name & then renamed, so that other
+ * processes never map a partial cache. Failing to save the cache is not an
+ * error: the evaluation file will just be unpacked again on the next start.
+ *
+ * @param file File name of the evaluation function data.
+ * @param header Cache header.
+ */
+static void eval_save_cache(const char *file, const EvalCacheHeader *header)
+{
+	char cache_file[FILENAME_MAX + 1], tmp_file[FILENAME_MAX + 1];
+	FILE *f;
+	bool ok;
+
+	eval_cache_file(file, cache_file);
+	if (*cache_file == '\0' || strlen(cache_file) + 5 > FILENAME_MAX) return;
+	file_add_ext(cache_file, ".tmp", tmp_file);
+
+	f = fopen(tmp_file, "wb");
+	if (f == NULL) {
+		info("<Cannot write evaluation weights cache %s>\n", tmp_file);
+		return;
+	}
+	ok = (fwrite(header, sizeof (EvalCacheHeader), 1, f) == 1 && fwrite(*EVAL_WEIGHT, sizeof (*EVAL_WEIGHT), 1, f) == 1);
+	if (fclose(f) != 0) ok = false;
+
+	if (ok) {
+		remove(cache_file);
+		ok = (rename(tmp_file, cache_file) == 0);
+	}
+	if (ok) info("<Evaluation weights cache %s saved>\n", cache_file);
+	else {
+		info("<Cannot write evaluation weights cache %s>\n", cache_file);
+		remove(tmp_file);
+	}
+}
+
+/**
+ * @brief Free the 16-bit weights.
+ */
+static void eval_free_weights(void)
+{
+	if (EVAL_CACHE_MAP.data) file_unmap(&EVAL_CACHE_MAP);
+	else free(EVAL_WEIGHT);
+	EVAL_WEIGHT = NULL;
+}
+
+/**
+ * @brief Load the evaluation function features' weights.
+ *
+ * The weights are stored in a global variable, because, once loaded from the
+ * file, they stay constant during the lifetime of the program. As loading
+ * the weights is time & resource consuming, a counter variable check that
+ * the weights are effectively loaded only once.
+ *
+ * The unpacked weights are also cached into a file next to the evaluation
+ * file (with a .bin extension added). The cache is mapped in memory on the
+ * next starts, so that they are faster, and that the weights are shared by
+ * all the Edax processes of a computer. The cache is rebuilt when the
+ * evaluation file changes.
+ *
+ * @param file File name of the evaluation function data.
+ */
+void eval_open(const char* file)
+{
+	EvalCacheHeader header;
+	struct stat st;
+
+	if (EVAL_LOADED++) return;
+
+	// the following is assumed:
+	//	-(unsigned) int are 32 bits
+	if (sizeof (int) != 4) fatal_error("int size is not compatible with Edax.\n");
+	//	-(unsigned) short are 16 bits
+	if (sizeof (short) != 2) fatal_error("short size is not compatible with Edax.\n");
+
+	OPPONENT_FEATURE = (unsigned short *) malloc(59049 * sizeof(unsigned short));	// 3^10
+	if (OPPONENT_FEATURE == NULL) fatal_error("Cannot allocate temporary table variable.\n");
+	set_opponent_feature(OPPONENT_FEATURE, 0, 10);
+
+	memset(&header, 0, sizeof header);
+	header.edax = EDAX;
+	header.tag = EVAL_CACHE;
+	header.format = EVAL_CACHE_FORMAT;
+	header.size = sizeof (*EVAL_WEIGHT);
+	if (stat(file, &st) == 0) {
+		header.source_size = (long long) st.st_size;
+		header.source_time = (long long) st.st_mtime;
+	}
+
+	if (options.eval_cache && eval_map_cache(file, &header)) {
+		info("<Evaluation weights mapped from cache>\n");
+	} else {
+		eval_unpack(file, &header);
+		if (options.eval_cache) eval_save_cache(file, &header);
+	}
+
 	/*if (version == 3 && release == 2 && build == 5)*/ {
 		EVAL_A = -0.10026799, EVAL_B = 0.31027733, EVAL_C = -0.57772603;
 		EVAL_a = 0.07585621, EVAL_b = 1.16492647, EVAL_c = 5.4171698;
 	}
 
-	info("<Evaluation function weights version %u.%u.%u loaded>\n", version, release, build);
+	info("<Evaluation function weights version %u.%u.%u loaded>\n", header.version, header.release, header.build);
 
-	// f = fopen("eval.bin", "wb");
-	// fwrite(*EVAL_WEIGHT, sizeof(Eval_weight), EVAL_N_PLY, f);
-	// fclose(f);
+	if (options.eval_int8) {
+		eval_quantize();
+		eval_free_weights();
+	}
 }
 
 /**
@@ -718,9 +883,67 @@ void eval_open(const char* file)
  */
 void eval_close(void)
 {
+	if (--EVAL_LOADED > 0) return;
+
 	free(OPPONENT_FEATURE);
-	free(EVAL_WEIGHT);
-	EVAL_WEIGHT = NULL;
+	eval_free_weights();
+	free(EVAL_WEIGHT_8);
+	EVAL_WEIGHT_8 = NULL;
+}
+
+/**
+ * @brief Quantize the evaluation weights to 8 bits.
+ *
+ * Each feature table of each ply gets its own scale: the smallest integer
+ * that brings its weights into [-127, 127]. The constant S0 is kept whole.
+ * The quantized weights are used by the evaluation once they are built.
+ */
+void eval_quantize(void)
+{
+	/** tables in memory order: size & lane of the AVX2 gathers */
+	static const struct {
+		int size;
+		int row, lane;
+	} T[] = {
+		{ 19683, 0, 0 }, { 59049, 0, 4 },	// C9, C10
+		{ 59049, 1, 0 }, { 59049, 1, 4 },	// S100, S101
+		{ 6561, 2, 0 }, { 6561, 2, 4 }, { 6561, 5, 0 }, { 6561, 5, 4 },	// S8x4
+		{ 2187, 3, 0 }, { 729, 3, 4 }, { 243, 4, 0 }, { 81, 4, 4 }	// S7654
+	};
+	const Eval_weight *w;
+	Eval_weight_8 *q;
+	const short *src;
+	signed char *dest;
+	int ply, t, i, m, scale, v;
+
+	if (EVAL_WEIGHT == NULL || EVAL_WEIGHT_8 != NULL) return;
+
+	EVAL_WEIGHT_8 = (Eval_weight_8(*)[EVAL_N_PLY - 2]) malloc(sizeof(*EVAL_WEIGHT_8));
+	if (EVAL_WEIGHT_8 == NULL) fatal_error("Cannot allocate quantized evaluation weights.\n");
+
+	for (ply = 0; ply < EVAL_N_PLY - 2; ++ply) {
+		w = *EVAL_WEIGHT + ply;
+		q = *EVAL_WEIGHT_8 + ply;
+		q->S0 = w->S0;
+		src = w->C9;
+		dest = q->C9;
+		for (t = 0; t < (int) (sizeof T / sizeof T[0]); ++t) {
+			for (m = i = 0; i < T[t].size; ++i) {
+				if (abs(src[i]) > m) m = abs(src[i]);
+			}
+			scale = (m + 126) / 127;
+			if (scale == 0) scale = 1;
+			for (i = 0; i < T[t].size; ++i) {
+				v = src[i] >= 0 ? (src[i] + scale / 2) / scale : -((scale / 2 - src[i]) / scale);
+				dest[i] = (signed char) MIN(MAX(v, -127), 127);
+			}
+			for (i = 0; i < 4; ++i) q->scale[T[t].row][T[t].lane + i] = scale;
+			src += T[t].size;
+			dest += T[t].size;
+		}
+	}
+
+	info("<Evaluation function weights quantized to 8 bits>\n");
 }
 
 #ifdef ANDROID
@@ -54,14 +54,28 @@ typedef struct Eval_weight {
 	short	S7654[2187+729+243+81];
 } Eval_weight;
 
+/** quantized weights: w = scale * q */
+typedef struct Eval_weight_8 {
+	int	scale[6][8];	// per-table scales, laid out as the lanes of the AVX2 gathers
+	int	S0;		// also acts as guard for VGATHERDD access
+	signed char	C9[19683];
+	signed char	C10[59049];
+	signed char	S100[59049];
+	signed char	S101[59049];
+	signed char	S8x4[6561*4];
+	signed char	S7654[2187+729+243+81];
+} Eval_weight_8;
+
 /** number of plies */
 enum { EVAL_N_PLY = 54 };	// decreased from 60 in 4.5.1
 
 extern Eval_weight (*EVAL_WEIGHT)[EVAL_N_PLY - 2];	// for 2..53
+extern Eval_weight_8 (*EVAL_WEIGHT_8)[EVAL_N_PLY - 2];	// quantized, if used
 
 /* function declaration */
 void eval_open(const char*);
 void eval_close(void);
+void eval_quantize(void);
 // void eval_init(Eval*);
 // void eval_free(Eval*);
 void eval_set(Eval*, const struct Board*);
@@ -80,5 +94,23 @@ void eval_update(int, unsigned long long, Eval*);
 void eval_update_leaf(int, unsigned long long, Eval*, const Eval*);
 #endif
 
+/** instruction sets of the eval kernels (eval_update_sse & accumlate_eval), for reports */
+#if defined(__AVX2__)
+	#define	EVAL_UPDATE_ISA	"AVX2"
+#elif defined(hasSSE2) || defined(USE_MSVC_X86)
+	#define	EVAL_UPDATE_ISA	"SSE2"
+#elif defined(__ARM_NEON)
+	#define	EVAL_UPDATE_ISA	"NEON"
+#else
+	#define	EVAL_UPDATE_ISA	"C"
+#endif
+#if defined(__AVX512F__)
+	#define	EVAL_ACCUMULATE_ISA	"AVX-512"
+#elif defined(__AVX2__) && !defined(__bdver4__) && !defined(__znver1__) && !defined(__znver2__)
+	#define	EVAL_ACCUMULATE_ISA	"AVX2"
+#else
+	#define	EVAL_ACCUMULATE_ISA	"C"
+#endif
+
 #endif
 
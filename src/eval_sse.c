@@ -29,7 +29,7 @@ extern const EVAL_FEATURE_V EVAL_FEATURE_all_opponent;
 
 void eval_update_sse(int x, unsigned long long f, Eval *eval_out, const Eval *eval_in)
 {
-  #ifdef __AVX2__
+  #if defined(__AVX2__)
 	__m256i	f0 = eval_in->feature.v16[0];
 	__m256i	f1 = eval_in->feature.v16[1];
 	__m256i	f2 = eval_in->feature.v16[2];
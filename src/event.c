@@ -124,15 +124,13 @@ void event_add_message(Event *event, char *message)
 
 
 /**
- * @brief Wait input.
+ * @brief Wait for a message.
  *
  * @param event Event.
- * @param cmd Command.
- * @param param Command's parameters.
+ * @return the message, as an unparsed line (to be freed by the caller).
  */
-void event_wait(Event *event, char **cmd, char **param)
+char* event_wait_message(Event *event)
 {
-	int n;
 	char *message;
 
 	lock(event);
@@ -141,6 +139,23 @@ void event_wait(Event *event, char **cmd, char **param)
 	}
 	unlock(event);
 
+	return message;
+}
+
+/**
+ * @brief Wait input.
+ *
+ * @param event Event.
+ * @param cmd Command.
+ * @param param Command's parameters.
+ */
+void event_wait(Event *event, char **cmd, char **param)
+{
+	int n;
+	char *message;
+
+	message = event_wait_message(event);
+
 	free(*cmd);
 	free(*param);
 
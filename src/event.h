@@ -33,6 +33,7 @@ void event_clear_messages(Event*);
 void event_add_message(Event*, char*);
 char *event_peek_message(Event*);
 bool event_exist(Event*);
+char* event_wait_message(Event*);
 void event_wait(Event*, char**, char**);
 void event_wait_enter(Event*);
 
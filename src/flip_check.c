@@ -0,0 +1,238 @@
+/**
+ * @file flip_check.c
+ *
+ * Differential check of the flip & last flip kernels.
+ *
+ * All the kernels available for the target instruction set (see
+ * flip_check_kernel.c) are linked side by side & compared to flip_slow(), on
+ * every pattern of each line (edge, column, row & diagonal) through every
+ * square, & on random boards. Any divergence is reported, with the speed of
+ * each kernel. Build & run it with `make flip-check` (compiled with
+ * -fwhole-program, that drops the unused parts of util.c & flip_slow.c).
+ *
+ * @date 2025
+ * @author Toshihiko Okuhara
+ * @version 4.5
+ */
+
+#undef NDEBUG	// for flip_slow
+
+#include "util.c"
+#include "bit.c"
+#include "flip_slow.c"
+#include "flip_check.h"
+
+#define	FLIP_CHECK_KERNEL(n)	const FlipKernel *flip_check_kernel_ ## n(void);
+FLIP_CHECK_KERNEL(0) FLIP_CHECK_KERNEL(1) FLIP_CHECK_KERNEL(2) FLIP_CHECK_KERNEL(3) FLIP_CHECK_KERNEL(4)
+FLIP_CHECK_KERNEL(5) FLIP_CHECK_KERNEL(6) FLIP_CHECK_KERNEL(7) FLIP_CHECK_KERNEL(8) FLIP_CHECK_KERNEL(9)
+FLIP_CHECK_KERNEL(10) FLIP_CHECK_KERNEL(11) FLIP_CHECK_KERNEL(12) FLIP_CHECK_KERNEL(13) FLIP_CHECK_KERNEL(14)
+FLIP_CHECK_KERNEL(15) FLIP_CHECK_KERNEL(16) FLIP_CHECK_KERNEL(17) FLIP_CHECK_KERNEL(18) FLIP_CHECK_KERNEL(19)
+FLIP_CHECK_KERNEL(20) FLIP_CHECK_KERNEL(21) FLIP_CHECK_KERNEL(22) FLIP_CHECK_KERNEL(23) FLIP_CHECK_KERNEL(24)
+FLIP_CHECK_KERNEL(25) FLIP_CHECK_KERNEL(26) FLIP_CHECK_KERNEL(27) FLIP_CHECK_KERNEL(28) FLIP_CHECK_KERNEL(29)
+FLIP_CHECK_KERNEL(30) FLIP_CHECK_KERNEL(31) FLIP_CHECK_KERNEL(32) FLIP_CHECK_KERNEL(33)
+
+static const FlipKernel *(*const KERNEL[FLIP_CHECK_N_KERNEL])(void) = {
+	flip_check_kernel_0, flip_check_kernel_1, flip_check_kernel_2, flip_check_kernel_3, flip_check_kernel_4,
+	flip_check_kernel_5, flip_check_kernel_6, flip_check_kernel_7, flip_check_kernel_8, flip_check_kernel_9,
+	flip_check_kernel_10, flip_check_kernel_11, flip_check_kernel_12, flip_check_kernel_13, flip_check_kernel_14,
+	flip_check_kernel_15, flip_check_kernel_16, flip_check_kernel_17, flip_check_kernel_18, flip_check_kernel_19,
+	flip_check_kernel_20, flip_check_kernel_21, flip_check_kernel_22, flip_check_kernel_23, flip_check_kernel_24,
+	flip_check_kernel_25, flip_check_kernel_26, flip_check_kernel_27, flip_check_kernel_28, flip_check_kernel_29,
+	flip_check_kernel_30, flip_check_kernel_31, flip_check_kernel_32, flip_check_kernel_33
+};
+
+/** number of random boards */
+#define	N_RANDOM	1000000
+
+/** number of reported divergences per kernel */
+#define	N_REPORT	4
+
+/** the 4 central squares, never played (& NULL in some flip tables) */
+#define	CENTER	0x0000001818000000ULL
+
+/**
+ * @brief Get a random move.
+ *
+ * @param r Random generator.
+ * @return a square, out of the 4 central ones.
+ */
+static int random_move(Random *r)
+{
+	int x;
+
+	do {
+		x = random_get(r) & 63;
+	} while (CENTER & x_to_bit(x));
+	return x;
+}
+
+/**
+ * @brief Get the squares of the lines through a square.
+ *
+ * @param x Square.
+ * @param line Squares of each line (output), x excluded.
+ * @param n Number of squares of each line (output).
+ */
+static void get_lines(const int x, int line[4][8], int n[4])
+{
+	static const int dx[4] = { 1, 0, 1, 1 }, dy[4] = { 0, 1, 1, -1 };
+	int d, i, j;
+
+	for (d = 0; d < 4; ++d) {
+		n[d] = 0;
+		for (i = (x & 7) - dx[d], j = (x >> 3) - dy[d]; 0 <= i && i < 8 && 0 <= j && j < 8; i -= dx[d], j -= dy[d]) ;
+		for (i += dx[d], j += dy[d]; 0 <= i && i < 8 && 0 <= j && j < 8; i += dx[d], j += dy[d]) {
+			if (j * 8 + i != x) line[d][n[d]++] = j * 8 + i;
+		}
+	}
+}
+
+/**
+ * @brief Report a divergence.
+ *
+ * @param kernel Kernel.
+ * @param x Move.
+ * @param P Player's discs.
+ * @param O Opponent's discs.
+ * @param got Kernel result.
+ * @param expected flip_slow result.
+ * @param n_error Divergence count (updated).
+ */
+static void report(const FlipKernel *kernel, const int x, const unsigned long long P, const unsigned long long O, const long long got, const long long expected, int *n_error)
+{
+	if ((*n_error)++ < N_REPORT) {
+		printf("%s: x = %d, P = 0x%016llx, O = 0x%016llx: 0x%llx instead of 0x%llx\n",
+			kernel->name, x, P, O, (unsigned long long) got, (unsigned long long) expected);
+	}
+}
+
+/**
+ * @brief Check a kernel.
+ *
+ * @param kernel Kernel.
+ * @param r Random generator.
+ * @return the number of divergences.
+ */
+static int check(const FlipKernel *kernel, Random *r)
+{
+	int x, d, i, k, n_pattern, line[4][8], n[4], n_error = 0;
+	unsigned long long P, O, f, bit;
+
+	for (x = A1; x <= H8; ++x) {
+		bit = x_to_bit(x);
+		if (CENTER & bit) continue;
+		get_lines(x, line, n);
+		for (d = 0; d < 4; ++d) {
+			// every empty/player/opponent pattern of the line
+			if (kernel->flip) {
+				for (n_pattern = 1, i = 0; i < n[d]; ++i) n_pattern *= 3;
+				for (k = 0; k < n_pattern; ++k) {
+					P = O = 0;
+					for (i = 0, f = k; i < n[d]; ++i, f /= 3) {
+						if (f % 3 == 1) P |= x_to_bit(line[d][i]);
+						else if (f % 3 == 2) O |= x_to_bit(line[d][i]);
+					}
+					if (kernel->flip(x, P, O) != flip_slow(P, O, x))
+						report(kernel, x, P, O, kernel->flip(x, P, O), flip_slow(P, O, x), &n_error);
+				}
+			}
+			// every player/opponent pattern of the line, on a full board
+			if (kernel->last_flip) {
+				for (k = 0; k < (1 << n[d]); ++k) {
+					P = random_get(r) & ~bit;
+					for (i = 0; i < n[d]; ++i) {
+						if ((k >> i) & 1) P |= x_to_bit(line[d][i]);
+						else P &= ~x_to_bit(line[d][i]);
+					}
+					O = ~(P | bit);
+					if (kernel->last_flip(x, P) != 2 * bit_count(flip_slow(P, O, x)))
+						report(kernel, x, P, O, kernel->last_flip(x, P), 2 * bit_count(flip_slow(P, O, x)), &n_error);
+				}
+			}
+		}
+	}
+
+	// random boards
+	for (k = 0; k < N_RANDOM; ++k) {
+		x = random_move(r);
+		bit = x_to_bit(x);
+		P = random_get(r) & ~bit;
+		if (kernel->flip) {
+			O = random_get(r) & ~(P | bit);
+			if (k & 1) O |= ~(P | bit) & random_get(r);	// denser board
+			if (kernel->flip(x, P, O) != flip_slow(P, O, x))
+				report(kernel, x, P, O, kernel->flip(x, P, O), flip_slow(P, O, x), &n_error);
+		}
+		if (kernel->last_flip) {
+			O = ~(P | bit);
+			if (kernel->last_flip(x, P) != 2 * bit_count(flip_slow(P, O, x)))
+				report(kernel, x, P, O, kernel->last_flip(x, P), 2 * bit_count(flip_slow(P, O, x)), &n_error);
+		}
+	}
+
+	return n_error;
+}
+
+/**
+ * @brief Time a kernel.
+ *
+ * @param kernel Kernel.
+ * @return the time of a call, in ns.
+ */
+static double speed(const FlipKernel *kernel)
+{
+	enum { N = 4096, N_REPEAT = 1000 };
+	static unsigned long long P[N], O[N];
+	static int X[N];
+	volatile unsigned long long v = 0;
+	unsigned long long s;
+	long long t;
+	Random r;
+	int i, k;
+
+	random_seed(&r, 42);
+	for (i = 0; i < N; ++i) {
+		X[i] = random_move(&r);
+		P[i] = random_get(&r) & ~x_to_bit(X[i]);
+		O[i] = kernel->flip ? random_get(&r) & ~(P[i] | x_to_bit(X[i])) : ~(P[i] | x_to_bit(X[i]));
+	}
+
+	t = -real_clock();
+	for (k = 0; k < N_REPEAT; ++k) {
+		s = 0;
+		if (kernel->flip) for (i = 0; i < N; ++i) s += kernel->flip(X[i], P[i], O[i]);
+		else for (i = 0; i < N; ++i) s += kernel->last_flip(X[i], P[i]);
+		v += s;
+	}
+	t += real_clock();
+
+	return 1e6 * t / ((double) N * N_REPEAT);
+}
+
+/**
+ * @brief flip_check main function.
+ *
+ * @return EXIT_FAILURE if any kernel diverges.
+ */
+int main(void)
+{
+	const FlipKernel *kernel;
+	Random r;
+	int i, n_error, n_kernel = 0, n_failed = 0;
+
+	bit_init();
+	random_seed(&r, 0x5eed);
+
+	printf("%-30s %10s %12s\n", "kernel", "errors", "ns/call");
+	for (i = 0; i < FLIP_CHECK_N_KERNEL; ++i) {
+		kernel = KERNEL[i]();
+		if (kernel == NULL) continue;	// not available for this instruction set
+		++n_kernel;
+		n_error = check(kernel, &r);
+		if (n_error) ++n_failed;
+		printf("%-30s %10d %12.2f\n", kernel->name, n_error, speed(kernel));
+	}
+	printf("%d kernels checked, %d diverging\n", n_kernel, n_failed);
+
+	return n_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
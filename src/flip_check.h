@@ -0,0 +1,24 @@
+/**
+ * @file flip_check.h
+ *
+ * Flip & last flip kernels checked by flip_check.c.
+ *
+ * @date 2025
+ * @author Toshihiko Okuhara
+ * @version 4.5
+ */
+
+#ifndef EDAX_FLIP_CHECK_H
+#define EDAX_FLIP_CHECK_H
+
+/** number of kernels in flip_check_kernel.c */
+#define	FLIP_CHECK_N_KERNEL	34
+
+/** a flip or a last flip kernel, with the interface of board.h's Flip & last_flip */
+typedef struct FlipKernel {
+	const char *name;                                                            /**< kernel name */
+	unsigned long long (*flip)(int, unsigned long long, unsigned long long);     /**< Flip(x, P, O), or NULL */
+	int (*last_flip)(int, unsigned long long);                                   /**< last_flip(x, P), or NULL */
+} FlipKernel;
+
+#endif /* EDAX_FLIP_CHECK_H */
@@ -0,0 +1,225 @@
+/**
+ * @file flip_check_kernel.c
+ *
+ * One flip or last flip kernel, wrapped for flip_check.c.
+ *
+ * This file is compiled once per kernel, with -DKERNEL=<n> & -fwhole-program,
+ * so that the kernels, which share function & table names, can be linked side
+ * by side. Each object exports flip_check_kernel_<n>(), that returns NULL if
+ * the kernel needs an instruction set the compilation flags do not enable,
+ * & has its own X_TO_BIT table.
+ * flip_carry_32.c (MSVC) & flip_carry_sse_32.c (x86 with MMX) are not covered.
+ *
+ * @date 2025
+ * @author Toshihiko Okuhara
+ * @version 4.5
+ */
+
+#include "bit.h"
+#include "flip_check.h"
+
+/** this object's copy, set by flip_check_kernel_<n>() */
+unsigned long long X_TO_BIT[66];
+
+#if KERNEL == 0
+	#include "flip_carry_64.c"
+	#define	NAME	"flip_carry_64"
+	#define	FLIP(x,P,O)	flip[x]((P), (O))
+#elif KERNEL == 1
+	#include "flip_kindergarten.c"
+	#define	NAME	"flip_kindergarten"
+	#define	FLIP(x,P,O)	flip[x]((P), (O))
+#elif KERNEL == 2
+	#include "flip_bitscan.c"
+	#define	NAME	"flip_bitscan"
+	#define	FLIP(x,P,O)	flip[x]((P), (O))
+#elif KERNEL == 3
+	#include "flip_roxane.c"
+	#define	NAME	"flip_roxane"
+	#define	FLIP(x,P,O)	flip[x]((P), (O))
+#elif KERNEL == 4 && defined(__SSE2__)
+	#include "flip_sse.c"
+	#define	NAME	"flip_sse"
+	#define	FLIP(x,P,O)	((unsigned long long) _mm_cvtsi128_si64(mm_flip[x](_mm_set_epi64x((O), (P)))))
+#elif KERNEL == 5 && defined(__SSE2__)
+	#include "flip_sse_acepck.c"
+	#define	NAME	"flip_sse_acepck"
+	#define	MM_FLIP
+#elif KERNEL == 6 && defined(__SSE2__) && defined(HAS_CPU_64)
+	#include "flip_sse_bitscan.c"
+	#define	NAME	"flip_sse_bitscan"
+	#define	FLIP(x,P,O)	flip((P), (O), (x))
+#elif KERNEL == 7 && defined(__SSE2__) && defined(HAS_CPU_64)
+	#include "flip_sse_bswap.c"
+	#define	NAME	"flip_sse_bswap"
+	#define	FLIP(x,P,O)	Flip((x), (P), (O))
+#elif KERNEL == 8 && defined(__BMI2__)
+	#include "flip_bmi2.c"
+	#define	NAME	"flip_bmi2"
+	#define	FLIP(x,P,O)	flip((x), (P), (O))
+#elif KERNEL == 9 && defined(__AVX2__)
+	#include "flip_avx_ppfill.c"
+	#define	NAME	"flip_avx_ppfill"
+	#define	MM_FLIP
+#elif KERNEL == 10 && defined(__AVX2__)
+	#include "flip_avx_ppseq.c"
+	#define	NAME	"flip_avx_ppseq"
+	#define	MM_FLIP
+#elif KERNEL == 11 && defined(__AVX2__)
+	#include "flip_avx_lzcnt.c"
+	#define	NAME	"flip_avx_lzcnt"
+	#define	MM_FLIP
+#elif KERNEL == 12 && defined(__AVX2__)
+	#include "flip_avx_cvtps.c"
+	#define	NAME	"flip_avx_cvtps"
+	#define	MM_FLIP
+#elif KERNEL == 13 && defined(__AVX2__)
+	#include "flip_avx_acepck.c"
+	#define	NAME	"flip_avx_acepck"
+	#define	MM_FLIP
+#elif KERNEL == 14 && defined(__AVX2__)
+	#include "flip_avx_shuf_max.c"
+	#define	NAME	"flip_avx_shuf_max"
+	static inline unsigned long long flip_shuf_max(int x, unsigned long long P, unsigned long long O) {
+		__m256i f = mm_Flip(_mm_set_epi64x(O, P), x);
+		__m128i f2 = _mm_or_si128(_mm256_castsi256_si128(f), _mm256_extracti128_si256(f, 1));
+		return _mm_cvtsi128_si64(_mm_or_si128(f2, _mm_shuffle_epi32(f2, 0x4e)));
+	}
+	#define	FLIP(x,P,O)	flip_shuf_max((x), (P), (O))
+#elif KERNEL == 15 && (defined(__AVX512VL__) || defined(__AVX10_1__))
+	#include "flip_avx512cd.c"
+	#define	NAME	"flip_avx512cd"
+	#define	MM_FLIP
+#elif KERNEL == 16 && defined(__ARM_NEON) && defined(__aarch64__)
+	#include "flip_neon_rbit.c"
+	#define	NAME	"flip_neon_rbit"
+	#define	NEON_FLIP
+#elif KERNEL == 17 && defined(__ARM_NEON)
+	#include "flip_neon_lzcnt.c"
+	#define	NAME	"flip_neon_lzcnt"
+	#define	NEON_FLIP
+#elif KERNEL == 18 && defined(__ARM_NEON)
+	#include "flip_neon_ppfill.c"
+	#define	NAME	"flip_neon_ppfill"
+	#define	NEON_FLIP
+#elif KERNEL == 19 && defined(__ARM_NEON)
+	#define	flip_neon	flip
+	#include "flip_neon_bitscan.c"
+	#define	NAME	"flip_neon_bitscan"
+	#define	FLIP(x,P,O)	flip[x]((P), (O))
+#elif KERNEL == 20 && defined(__ARM_FEATURE_SVE)
+	#include "flip_sve_lzcnt.c"
+	#define	NAME	"flip_sve_lzcnt"
+	#define	FLIP(x,P,O)	Flip((x), (P), (O))
+
+#elif KERNEL == 21
+	#include "count_last_flip_carry_64.c"
+	#define	NAME	"count_last_flip_carry_64"
+	#define	LAST_FLIP(x,P)	count_last_flip[x](P)
+#elif KERNEL == 22
+	#include "count_last_flip_kindergarten.c"
+	#define	NAME	"count_last_flip_kindergarten"
+	#define	LAST_FLIP(x,P)	count_last_flip[x](P)
+#elif KERNEL == 23
+	#include "count_last_flip_bitscan.c"
+	#define	NAME	"count_last_flip_bitscan"
+	#define	LAST_FLIP(x,P)	count_last_flip[x](P)
+#elif KERNEL == 24
+	#include "count_last_flip_32.c"
+	#define	NAME	"count_last_flip_32"
+	#define	LAST_FLIP(x,P)	count_last_flip[x](P)
+#elif KERNEL == 25
+	#include "count_last_flip_plain.c"
+	#define	NAME	"count_last_flip_plain"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 26 && defined(__SSE2__)
+  #ifdef __AVX2__
+	#include "flip_avx_ppfill.c"	// lrmask
+  #endif
+	#include "count_last_flip_sse.c"
+	#define	NAME	"count_last_flip_sse"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 27 && defined(__BMI__) && defined(__LZCNT__) && defined(HAS_CPU_64)
+	#include "count_last_flip_bmi.c"
+	#define	NAME	"count_last_flip_bmi"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 28 && defined(__BMI2__)
+	#include "count_last_flip_bmi2.c"
+	#define	NAME	"count_last_flip_bmi2"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 29 && defined(__LZCNT__)
+	#include "count_last_flip_lzcnt.c"
+	#define	NAME	"count_last_flip_lzcnt"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 30 && defined(__AVX2__)
+	#include "flip_avx_ppfill.c"	// lrmask
+	#include "count_last_flip_avx_ppfill.c"
+	#define	NAME	"count_last_flip_avx_ppfill"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 31 && (defined(__AVX512VL__) || defined(__AVX10_1__))
+	#include "flip_avx_ppfill.c"	// lrmask
+	#include "count_last_flip_avx512cd.c"
+	#define	NAME	"count_last_flip_avx512cd"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 32 && defined(__ARM_NEON)
+	#include "count_last_flip_neon.c"
+	#define	NAME	"count_last_flip_neon"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#elif KERNEL == 33 && defined(__ARM_FEATURE_SVE)
+	#include "count_last_flip_sve_lzcnt.c"
+	#define	NAME	"count_last_flip_sve_lzcnt"
+	#define	LAST_FLIP(x,P)	last_flip((x), (P))
+#endif
+
+// mm_Flip returns a partially reduced flip, as in board.h
+#if defined(MM_FLIP)
+	static inline unsigned long long mm_flip_reduce(int x, unsigned long long P, unsigned long long O) {
+		__m128i f = mm_Flip(_mm_set_epi64x(O, P), x);
+		return _mm_cvtsi128_si64(_mm_or_si128(f, _mm_shuffle_epi32(f, 0x4e)));
+	}
+	#define	FLIP(x,P,O)	mm_flip_reduce((x), (P), (O))
+#elif defined(NEON_FLIP)
+	#define	FLIP(x,P,O)	vgetq_lane_u64(mm_Flip(vcombine_u64(vcreate_u64(P), vcreate_u64(O)), (x)), 0)
+#endif
+
+#ifdef FLIP
+static unsigned long long kernel_flip(int x, unsigned long long P, unsigned long long O)
+{
+	return FLIP(x, P, O);
+}
+#else
+	#define	kernel_flip	NULL
+#endif
+
+#ifdef LAST_FLIP
+static int kernel_last_flip(int x, unsigned long long P)
+{
+	return LAST_FLIP(x, P);
+}
+#else
+	#define	kernel_last_flip	NULL
+#endif
+
+#define	KERNEL_ENTRY_(n)	flip_check_kernel_ ## n
+#define	KERNEL_ENTRY(n)	KERNEL_ENTRY_(n)
+
+const FlipKernel *KERNEL_ENTRY(KERNEL)(void) __attribute__((externally_visible));
+
+/**
+ * @brief Get the kernel.
+ *
+ * @return the kernel, or NULL if not available.
+ */
+const FlipKernel *KERNEL_ENTRY(KERNEL)(void)
+{
+#ifdef NAME
+	static const FlipKernel kernel = { NAME, kernel_flip, kernel_last_flip };
+	int x;
+
+	for (x = 0; x < 64; ++x) X_TO_BIT[x] = 1ULL << x;
+	X_TO_BIT[64] = X_TO_BIT[65] = 0;	// passing move & nomove
+	return &kernel;
+#else
+	return NULL;
+#endif
+}
@@ -1667,7 +1667,7 @@ int game_complete(Game *game, Search *search)
 			game->move[i] = search->result->move;
 		}
 		if (search->result->score != 0) {
-			putchar('\n'); search->observer(search->result);
+			search->observer(search->result);
 		}
 	}
 
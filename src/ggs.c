@@ -141,6 +141,25 @@ typedef struct GGSEvent {
 	Lock lock;                  /**< lock */
 } GGSEvent;
 
+/** maximal number of games played at once */
+#define GGS_MAX_GAMES 8
+
+/* a game played by Edax */
+typedef struct GGSGame {
+	char *id;                   /**< board id, or NULL for a free slot */
+	Play *play;                 /**< game state */
+	TaskStack *tasks;           /**< own task stack of the play search, replaced by the shared one */
+	struct GGSGame *follow;     /**< game thinking on the same position, whose move is played */
+	int turn;                   /**< Edax's color */
+	int is_rand;                /**< is game rand ? */
+	int time;                   /**< Edax's remaining time in ms */
+	int extra_time;             /**< Edax's extra time in ms */
+	long long real_time;        /**< thinking time */
+	Thread thread;              /**< thinking thread */
+	volatile bool is_thinking;  /**< Edax is thinking on this game */
+	volatile bool has_move;     /**< the move is found, & not sent yet */
+} GGSGame;
+
 /* GGSClient structure */
 typedef struct GGSClient {
 	GGSBoard board[1];          /**< ggs board */
@@ -150,7 +169,7 @@ typedef struct GGSClient {
 	GGSAdmin admin[1];          /**< ggs admin */
 	GGSEvent event;             /**< ggs event */
 	const char *me;             /**< Edax's name on GGS */
-	bool is_playing;            /**< is Edax playing ? */
+	int n_playing;              /**< number of matches played by Edax */
 	long long last_refresh;     /**< date of last refresh */
 	struct {
 		char *cmd;              /**< command */
@@ -161,6 +180,7 @@ typedef struct GGSClient {
 		char *cmd;              /**< command */              
 		long long delay;        /**< delay */
 	} once[1];		            /**< command issued once after some delay */
+	GGSGame game[GGS_MAX_GAMES]; /**< games played at once */
 } GGSClient;
 
 static Log ggs_log[1];
@@ -1080,7 +1100,7 @@ static void ggs_client_refresh(GGSClient *client)
 {
 	/* send "tell /os continue" every minute */
 	if (real_clock() - client->last_refresh > 60000) { // 60 sec.
-		if (client->is_playing) ggs_client_send(client, "tell /os open 0\n" );
+		if (client->n_playing) ggs_client_send(client, "tell /os open 0\n" );
 		else ggs_client_send(client, "tell /os open %d\n", options.ggs_open);
 		ggs_client_send(client, "tell /os continue\n");
 		client->last_refresh = real_clock();
@@ -1132,64 +1152,203 @@ static void ui_login(UI *ui)
 }
 
 /**
- * @brief ui_ggs_ponder
+ * @brief ggs_game_get
  *
- * Ponder, ie search during opponent time.
+ * Find a game played by Edax, or a free slot for a new one.
+ * The first two games use the two plays of the user interface, the others are
+ * allocated when needed. All the game searches share the task stack of the
+ * first play.
  *
  * @param ui User Interface.
- * @param turn Edax's color.
+ * @param id Board id.
+ * @return The game, or NULL if too many games are played.
  */
-static void ui_ggs_ponder(UI *ui, int turn) {
-	Play *play;
+static GGSGame* ggs_game_get(UI *ui, const char *id)
+{
+	GGSGame *game = ui->ggs->game, *free_game = NULL;
+	const int n_task = options.n_task;
+	int i;
 
-	if (search_count_tasks(&ui->play->search) == options.n_task) {
-		play = ui->play;
-	} else  {
-		play = ui->play + turn;
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		if (game[i].id && strcmp(game[i].id, id) == 0) return game + i;
+		if (game[i].id == NULL && free_game == NULL) free_game = game + i;
+	}
+	if (free_game == NULL) return NULL;
+
+	i = free_game - game;
+	if (free_game->play == NULL) {
+		free_game->play = (Play*) malloc(sizeof (Play));
+		if (free_game->play == NULL) fatal_error("ggs_game_get: cannot allocate a play\n");
+		options.n_task = 1;
+		play_init(free_game->play, &ui->book);
+		free_game->play->search.id = i + 1;
+		options.n_task = n_task;
+	}
+	if (i > 0 && free_game->tasks == NULL) {
+		free_game->tasks = free_game->play->search.tasks;
+		free_game->play->search.tasks = ui->play->search.tasks;
+		free_game->play->search.allow_node_splitting = ui->play->search.allow_node_splitting;
 	}
+	free_game->id = string_duplicate(id);
+	free_game->follow = NULL;
+	free_game->is_thinking = free_game->has_move = false;
+	info("<game %s played in slot %d>\n", id, i);
 
-	play_ponder(play);
+	return free_game;
 }
 
 /**
- * @brief ui_ggs_play
+ * @brief ggs_balance_tasks
+ *
+ * Share the helper tasks among the games, by clock urgency.
  *
- * Search the best move.
+ * Each running search uses its own thread, the helpers are the tasks left. The
+ * thinking games share them in proportion to their urgency, i.e. the inverse
+ * of the time available per remaining move. The pondering games only get the
+ * helpers left when no game is thinking.
  *
  * @param ui User Interface.
- * @param turn Edax's color.
  */
-static void ui_ggs_play(UI *ui, int turn) {
-	long long real_time = -time_clock();
-	int remaining_time = ui->ggs->board->clock[turn].ini_time;
-	int extra_time = ui->ggs->board->clock[turn].ext_time;
-	Play *play;
-	Result *result;
-	char move[4], line[32];
-	static const char * const search_state_array[6] = {"running", "interrupted", "stop pondering", "out of time", "stopped on user demand", "completed"};
-	char search_state[32];
+static void ggs_balance_tasks(UI *ui)
+{
+	GGSGame *game = ui->ggs->game;
+	double urgency[GGS_MAX_GAMES], sum = 0.0;
+	int i, k, n, n_root = 0, n_helper, n_left, limit[GGS_MAX_GAMES];
+
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		urgency[i] = 0.0;
+		limit[i] = 0;
+		if (game[i].id == NULL) continue;
+		if (game[i].is_thinking && !game[i].has_move) {
+			n = MAX(1, board_count_empties(&game[i].play->board) / 2); // moves left to play
+			urgency[i] = 1.0 / MAX(game[i].time / n, 100);
+			sum += urgency[i];
+			++n_root;
+		} else if (game[i].play->state == IS_PONDERING) {
+			++n_root;
+		}
+	}
+	if (n_root == 0) return;
 
-	if (ui->is_same_play) {
-		play = ui->play;
-		if (search_count_tasks(&ui->play->search) < options.n_task) {
-			printf("<use a single %d tasks search while a single game is played>\n", options.n_task);
-			play_stop_pondering(ui->play);
-			search_set_task_number(&ui->play[0].search, options.n_task);
-			play_stop_pondering(ui->play + 1);
-			search_set_task_number(&ui->play[1].search, 0);
+	n_helper = n_left = MAX(0, ui->play->search.tasks->n - n_root);
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		if (urgency[i] > 0.0) n_left -= (limit[i] = (int) (n_helper * urgency[i] / sum));
+	}
+	// the remaining helpers, to the most urgent games or to the pondering ones
+	while (n_left > 0) {
+		for (k = -1, i = 0; i < GGS_MAX_GAMES; ++i) {
+			if (game[i].id == NULL) continue;
+			if (sum > 0.0 ? urgency[i] > 0.0 && (k < 0 || urgency[i] * (limit[k] + 1) > urgency[k] * (limit[i] + 1))
+			              : game[i].play->state == IS_PONDERING && (k < 0 || limit[i] < limit[k])) k = i;
 		}
-	} else {
-		play = ui->play + turn;
-		if (search_count_tasks(&ui->play->search) == options.n_task && options.n_task > 1) {
-			printf("<split single %d tasks search into two %d task searches>\n", options.n_task, options.n_task / 2);
-			play_stop_pondering(ui->play);
-			search_set_task_number(&ui->play[0].search, options.n_task / 2);
-			play_stop_pondering(ui->play + 1);
-			search_set_task_number(&ui->play[1].search, options.n_task / 2);
-			search_share(&ui->play[0].search, &ui->play[1].search);
-			ui_ggs_ponder(ui, turn ^ 1); // ponder opponent move
+		++limit[k]; --n_left;
+	}
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		if (game[i].id) {
+			play_set_tasks_limit(game[i].play, limit[i]);
+			if (urgency[i] > 0.0 || (sum == 0.0 && game[i].play->state == IS_PONDERING)) {
+				info("<game %s: %d helper tasks>\n", game[i].id, limit[i]);
+			}
 		}
 	}
+}
+
+/**
+ * @brief ggs_game_think
+ *
+ * Thinking thread of a game.
+ *
+ * @param v Game.
+ * @return NULL.
+ */
+static void* ggs_game_think(void *v)
+{
+	GGSGame *game = (GGSGame*) v;
+
+	play_go(game->play, false);
+	game->has_move = true;
+
+	return NULL;
+}
+
+static void ui_ggs_play(UI*, GGSGame*);
+
+/**
+ * @brief ggs_game_wait
+ *
+ * Stop thinking & pondering on a game.
+ * The games that followed its search now search by themselves.
+ *
+ * @param ui User Interface.
+ * @param game Game.
+ */
+static void ggs_game_wait(UI *ui, GGSGame *game)
+{
+	GGSGame *other = ui->ggs->game;
+	int i;
+
+	if (game->is_thinking) {
+		if (game->follow == NULL) {
+			play_stop(game->play);
+			thread_join(game->thread);
+		}
+		game->is_thinking = game->has_move = false;
+		game->follow = NULL;
+		for (i = 0; i < GGS_MAX_GAMES; ++i) {
+			if (other[i].follow == game) {
+				other[i].follow = NULL;
+				other[i].is_thinking = false;
+				ui_ggs_play(ui, other + i);
+			}
+		}
+	}
+	play_stop_pondering(game->play);
+}
+
+/**
+ * @brief ggs_game_release
+ *
+ * Free the slot of a game that is over.
+ *
+ * @param ui User Interface.
+ * @param game Game.
+ */
+static void ggs_game_release(UI *ui, GGSGame *game)
+{
+	ggs_game_wait(ui, game);
+	info("<game %s released>\n", game->id);
+	free(game->id);
+	game->id = NULL;
+}
+
+/**
+ * @brief ui_ggs_ponder
+ *
+ * Ponder, ie search during opponent time.
+ *
+ * @param ui User Interface.
+ * @param game Game.
+ */
+static void ui_ggs_ponder(UI *ui, GGSGame *game) {
+	play_ponder(game->play);
+	ggs_balance_tasks(ui);
+}
+
+/**
+ * @brief ui_ggs_play
+ *
+ * Start searching the best move, in a thinking thread.
+ * The move is sent by ui_ggs_send_move() once found. If another game is
+ * already thinking on the same position (synchro games), its move is used.
+ *
+ * @param ui User Interface.
+ * @param game Game.
+ */
+static void ui_ggs_play(UI *ui, GGSGame *game) {
+	GGSGame *other = ui->ggs->game;
+	Play *play = game->play;
+	int remaining_time = game->time;
+	int i;
 
 	// game over detection...
 	if (play_is_game_over(play)) {
@@ -1197,29 +1356,68 @@ static void ui_ggs_play(UI *ui, int turn) {
 		return ;
 	}
 
-	result = &play->result;
-	
+	game->real_time = -time_clock();
+	game->has_move = false;
+	game->is_thinking = true;
+
+	// playing same game... ?
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		if (other + i != game && other[i].id && other[i].is_thinking && other[i].follow == NULL
+		 && other[i].play->player == play->player && board_equal(&other[i].play->board, &play->board)) {
+			printf("<Playing same game as %s>\n", other[i].id);
+			play_stop_pondering(play);
+			game->follow = other + i;
+			return;
+		}
+	}
+
 	if (remaining_time > 60000) remaining_time -= 10000; // keep 10s. for safety.
 	else if (remaining_time > 10000) remaining_time -= 2000; // keep 2s. for safety.
 	if (remaining_time < 1000) remaining_time = 1000; // set time to at list 1ms
-	play_adjust_time(play, remaining_time, extra_time);
+	play_adjust_time(play, remaining_time, game->extra_time);
+
+	ggs_balance_tasks(ui);
+	printf("<ggs: go thinking in game %s>\n", game->id);
+	thread_create(&game->thread, ggs_game_think, game);
+}
 
-	printf("<ggs: go thinking>\n");
-	play_go(play, false);
+/**
+ * @brief ui_ggs_send_move
+ *
+ * Send the move found in a game.
+ *
+ * @param ui User Interface.
+ * @param game Game.
+ */
+static void ui_ggs_send_move(UI *ui, GGSGame *game) {
+	Play *play = game->play;
+	long long real_time = game->real_time + time_clock();
+	Result *result;
+	char move[4], line[32];
+	static const char * const search_state_array[6] = {"running", "interrupted", "stop pondering", "out of time", "stopped on user demand", "completed"};
+	char search_state[32];
 
-	real_time += time_clock();
+	if (game->follow) {
+		play->result = game->follow->play->result;
+		play->search.stop = game->follow->play->search.stop;
+		game->follow = NULL;
+	} else {
+		thread_join(game->thread);
+	}
+	game->is_thinking = game->has_move = false;
 
+	result = &play->result;
 	move_to_string(result->move, play->player, move);
 
-	ggs_client_send(ui->ggs, "tell /os play %s %s/%d/%.2f\n", ui->ggs->board->id, move, result->score, 0.001 * (real_time + 1));
+	ggs_client_send(ui->ggs, "tell /os play %s %s/%d/%.2f\n", game->id, move, result->score, 0.001 * (real_time + 1));
 
 	if (result->book_move) {
-		printf("[%s plays %s in game %s ; score = %d from book]\n", ui->ggs->me, move, ui->ggs->board->id, result->score);
+		printf("[%s plays %s in game %s ; score = %d from book]\n", ui->ggs->me, move, game->id, result->score);
 		ggs_client_send(ui->ggs, "tell .%s -----------------------------------------"
 			"\\%s plays %s in game %s"
 			"\\score == %d from book\n",
 			ui->ggs->me,
-			ui->ggs->me, move, ui->ggs->board->id,
+			ui->ggs->me, move, game->id,
 			result->score
 		);
 	} else if (play->search.eval.n_empties >= 15) { //avoid noisy display
@@ -1231,7 +1429,7 @@ static void ui_ggs_play(UI *ui, int turn) {
 		else bound = "==";
 
 		info("<%s plays %s in game %s ; score = %d at %d@%d%% ; %lld nodes in %.1fs (%.0f nodes/s.)>\n",
-			ui->ggs->me, move, ui->ggs->board->id,
+			ui->ggs->me, move, game->id,
 			result->score, result->depth, selectivity_table[result->selectivity].percent,
 			result->n_nodes, 0.001 * real_time, (result->n_nodes / (0.001 * real_time + 0.001))
 		);
@@ -1246,7 +1444,7 @@ static void ui_ggs_play(UI *ui, int turn) {
 			"\\nodes: %s ; time: search = %.1fs, move = %.1fs; speed: %s."
 			"\\search %s\n",
 			ui->ggs->me,
-			ui->ggs->me, move, ui->ggs->board->id, search_count_tasks(&play->search), search_count_tasks(&play->search) > 1 ? "s ;" : " ;",
+			ui->ggs->me, move, game->id, search_count_tasks(&play->search), search_count_tasks(&play->search) > 1 ? "s ;" : " ;",
 			bound, result->score,
 			result->depth, selectivity_table[result->selectivity].percent,
 			line_to_string(&result->pv, 8, " ", line),
@@ -1256,6 +1454,49 @@ static void ui_ggs_play(UI *ui, int turn) {
 	}
 }
 
+/**
+ * @brief ui_ggs_check_moves
+ *
+ * Send the moves found since the last check.
+ * The games following another one are checked first, as its result is
+ * released once sent.
+ *
+ * @param ui User Interface.
+ */
+static void ui_ggs_check_moves(UI *ui) {
+	GGSGame *game = ui->ggs->game;
+	bool found = false;
+	int i;
+
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		if (game[i].id && game[i].is_thinking && game[i].follow && game[i].follow->has_move) {
+			ui_ggs_send_move(ui, game + i);
+			found = true;
+		}
+	}
+	for (i = 0; i < GGS_MAX_GAMES; ++i) {
+		if (game[i].id && game[i].is_thinking && game[i].follow == NULL && game[i].has_move) {
+			ui_ggs_send_move(ui, game + i);
+			found = true;
+		}
+	}
+	if (found) ggs_balance_tasks(ui);
+}
+
+/**
+ * @brief ui_ggs_get_turn
+ *
+ * Get Edax's color in the current GGS board.
+ *
+ * @param ui User Interface.
+ * @return Edax's color, or EMPTY if Edax does not play this game.
+ */
+static int ui_ggs_get_turn(UI *ui) {
+	if (strcmp(ui->ggs->board->player[0].name, ui->ggs->me) == 0) return BLACK;
+	else if (strcmp(ui->ggs->board->player[1].name, ui->ggs->me) == 0) return WHITE;
+	else return EMPTY;
+}
+
 /**
  * @brief ui_ggs_join
  *
@@ -1268,25 +1509,29 @@ static void ui_ggs_play(UI *ui, int turn) {
 static void ui_ggs_join(UI *ui) {
 	char buffer[258];
 	char s_move[4];
+	GGSGame *game;
 	Play *play;
 	int edax_turn, i;
 	
 	printf("[received GGS_BOARD_JOIN]\n");
 
 	// set correct played game
-	if (strcmp(ui->ggs->board->player[0].name, ui->ggs->me) == 0) {
-		play = ui->play;
-		edax_turn = BLACK;
-	} else if (strcmp(ui->ggs->board->player[1].name, ui->ggs->me) == 0) {
-		play = ui->play + 1;
-		edax_turn = WHITE;
-	} else {
+	edax_turn = ui_ggs_get_turn(ui);
+	if (edax_turn == EMPTY) {
 		warn("Edax is not concerned by this game\n");
 		return ;
 	}
-
-	// non synchro games => play a single match
-	if (!ui->ggs->board->match_type->is_synchro) play = ui->play;
+	game = ggs_game_get(ui, ui->ggs->board->id);
+	if (game == NULL) {
+		warn("Too many games to play %s\n", ui->ggs->board->id);
+		return ;
+	}
+	ggs_game_wait(ui, game);
+	play = game->play;
+	game->turn = edax_turn;
+	game->is_rand = ui->ggs->board->match_type->is_rand;
+	game->time = ui->ggs->board->clock[edax_turn].ini_time;
+	game->extra_time = ui->ggs->board->clock[edax_turn].ext_time;
 
 	// set board
 	sprintf(buffer, "%s %c", ui->ggs->board->board_init, ui->ggs->board->turn_init);
@@ -1298,21 +1543,16 @@ static void ui_ggs_join(UI *ui) {
 			break;
 		}
 	}
-	printf("[%s's turn in game %s]\n", ui->ggs->board->player[play->player].name, ui->ggs->board->id);
+	printf("[%s's turn in game %s]\n", ui->ggs->board->player[play->player].name, game->id);
 	board_print(&play->board, play->player, stdout);
 
-	ui->is_same_play = (ui->ggs->board->move_list_n == 0 || board_equal(&ui->play[0].board, &ui->play[1].board) || !ui->ggs->board->match_type->is_synchro);
-	if (ui->is_same_play) printf("[Playing same game]\n");
-
 	// set time & start thinking
 	if (play->player == edax_turn) {
 		printf("<My turn>\n");
 		ggs_client_send(ui->ggs, "tell .%s =====================================\n", ui->ggs->me);
-		ui_ggs_play(ui, edax_turn);
-		ui_ggs_ponder(ui, edax_turn);
+		ui_ggs_play(ui, game);
 	} else {
 		printf("[Waiting opponent move]\n");
-//		ui_ggs_ponder(ui, edax_turn);
 	}
 }
 
@@ -1325,6 +1565,7 @@ static void ui_ggs_join(UI *ui) {
  */
 static void ui_ggs_update(UI *ui) {
 	char buffer[258], s_move[4];
+	GGSGame *game;
 	Play *play;
 	int edax_turn, turn;
 	Board board;
@@ -1332,17 +1573,19 @@ static void ui_ggs_update(UI *ui) {
 	printf("[received GGS_BOARD_UPDATE]\n");
 
 	// set correct played game
-	if (strcmp(ui->ggs->board->player[0].name, ui->ggs->me) == 0) {
-		play = ui->play;
-		edax_turn = BLACK;
-	} else if (strcmp(ui->ggs->board->player[1].name, ui->ggs->me) == 0) {
-		play = ui->play + 1;
-		edax_turn = WHITE;
-	} else {
+	edax_turn = ui_ggs_get_turn(ui);
+	if (edax_turn == EMPTY) return ;
+	game = ggs_game_get(ui, ui->ggs->board->id);
+	if (game == NULL) {
+		warn("Too many games to play %s\n", ui->ggs->board->id);
 		return ;
 	}
-
-	if (!ui->ggs->board->match_type->is_synchro) play = ui->play;
+	ggs_game_wait(ui, game);
+	play = game->play;
+	game->turn = edax_turn;
+	game->is_rand = ui->ggs->board->match_type->is_rand;
+	game->time = ui->ggs->board->clock[edax_turn].ini_time;
+	game->extra_time = ui->ggs->board->clock[edax_turn].ext_time;
 		
 	// set board as an edax's board
 	sprintf(buffer, "%s %c", ui->ggs->board->board, ui->ggs->board->turn);
@@ -1363,19 +1606,15 @@ static void ui_ggs_update(UI *ui) {
 		play->player = turn;
 	}
 
-	printf("[%s's turn in game %s]\n", ui->ggs->board->player[play->player].name, ui->ggs->board->id);
-
-	// playing same game... ?
-	ui->is_same_play = (!ui->ggs->board->match_type->is_synchro || board_equal(&ui->play[0].board, &ui->play[1].board));
-	if (ui->is_same_play) printf("<Playing same game...>\n");
+	printf("[%s's turn in game %s]\n", ui->ggs->board->player[play->player].name, game->id);
 
 	// set time & start thinking
 	if (play->player == edax_turn) {
 		printf("<My turn>\n");
-		ui_ggs_play(ui, edax_turn);
+		ui_ggs_play(ui, game);
 	} else {
 		printf("<Opponent turn>\n");
-		ui_ggs_ponder(ui, edax_turn);
+		ui_ggs_ponder(ui, game);
 	}
 }
 
@@ -1404,6 +1643,8 @@ void ui_init_ggs(UI *ui) {
 	log_open(ggs_log, options.ggs_log_file);
 
 	ui_login(ui);
+	ui->ggs->game[0].play = ui->play;
+	ui->ggs->game[1].play = ui->play + 1;
 }
 
 /**
@@ -1418,6 +1659,7 @@ void ui_loop_ggs(UI *ui) {
 	char *cmd = NULL, *param = NULL;
 	Text text;
 	GGSClient *const client = ui->ggs;
+	int i;
 
 	ui->mode = 3;
 
@@ -1429,8 +1671,9 @@ void ui_loop_ggs(UI *ui) {
 		if (ui_event_peek(ui, &cmd, &param)) {
 			/* stop the search */
 			if (strcmp(cmd, "stop") == 0) { 
-				if (ui->play[0].state == IS_THINKING) play_stop(ui->play);
-				else if (ui->play[1].state == IS_THINKING) play_stop(ui->play + 1);
+				for (i = 0; i < GGS_MAX_GAMES; ++i) {
+					if (client->game[i].id && client->game[i].play->state == IS_THINKING) play_stop(client->game[i].play);
+				}
 
 			/* repeat a cmd <n> times */			
 			} else if (strcmp(cmd, "loop") == 0) { 
@@ -1457,6 +1700,9 @@ void ui_loop_ggs(UI *ui) {
 			}
 		}
 		
+		/* send the moves found */
+		ui_ggs_check_moves(ui);
+
 		/* stay on line... */
 		ggs_client_refresh(client);
 
@@ -1501,7 +1747,7 @@ void ui_loop_ggs(UI *ui) {
 		} else if (ggs_match_on(client->match_on, &text)) {
 			if (ggs_has_player(client->match_on->player, client->me)) {
 				printf("[received GGS_MATCH_ON]\n");
-				client->is_playing = true;
+				++client->n_playing;
 				ggs_client_send(client, "tell /os open 0\n" );
 			} else {
 				printf("[received GGS_WATCH_ON]\n");
@@ -1512,23 +1758,24 @@ void ui_loop_ggs(UI *ui) {
 			if (ggs_has_player(client->match_off->player, client->me)) {
 				printf("[received GGS_MATCH_OFF]\n");
 
-				if (!client->match_on->match_type->is_rand) {
-					if (client->match_on->match_type->is_synchro) {
-						printf("[store match #1]\n");
-						play_store(ui->play);
-						printf("[store match #2]\n");
-						play_store(ui->play + 1);
-					} else {
-						printf("[store match]\n");
-						play_store(ui->play);
-					}
-					if (ui->book.need_saving) {
-						book_save(&ui->book, options.book_file);
-						ui->book.need_saving = false;
+				for (i = 0; i < GGS_MAX_GAMES; ++i) {
+					GGSGame *game = client->game + i;
+					const size_t n = strlen(client->match_off->id);
+					if (game->id && strncmp(game->id, client->match_off->id, n) == 0 && (game->id[n] == '\0' || game->id[n] == '.')) {
+						ggs_game_wait(ui, game);
+						if (!game->is_rand) {
+							printf("[store game %s]\n", game->id);
+							play_store(game->play);
+						}
+						ggs_game_release(ui, game);
 					}
 				}
+				if (ui->book.need_saving) {
+					book_save(&ui->book, options.book_file);
+					ui->book.need_saving = false;
+				}
 
-				client->is_playing = false;
+				client->n_playing = MAX(0, client->n_playing - 1);
 				ggs_client_send(client, "tell /os open %d\n", options.ggs_open);
 				if (client->loop->i > 0) {
 					info("<loop %d>\n", client->loop->i);
@@ -1596,6 +1843,17 @@ void ui_loop_ggs(UI *ui) {
  * @param ui User Interface.
  */
 void ui_free_ggs(UI *ui) {
+	int i;
+
+	for (i = GGS_MAX_GAMES - 1; i >= 0; --i) {
+		GGSGame *game = ui->ggs->game + i;
+		if (game->id) ggs_game_release(ui, game);
+		if (game->tasks) game->play->search.tasks = game->tasks;
+		if (i > 1 && game->play) {
+			play_free(game->play);
+			free(game->play);
+		}
+	}
 	play_free(ui->play);
 	play_free(ui->play + 1);
 	if (ui->book.need_saving) book_save(&ui->book, options.book_file);
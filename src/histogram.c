@@ -8,6 +8,8 @@
  * @version 4.4
  */
 
+#include "histogram.h"
+#include "search.h"
 #include "util.h"
 
 #include <stdio.h>
@@ -201,3 +203,181 @@ void histogram_to_ppm(const char *file, unsigned long long histogram[129][65])
 	fclose(f);
 }
 
+/** Global search recorder */
+SearchRecorder search_recorder;
+
+/** Width of an empties bucket */
+#define RECORD_BUCKET 10
+
+/**
+ * @brief Start to record the searches.
+ *
+ * @param recorder Search recorder.
+ */
+void search_recorder_start(SearchRecorder *recorder)
+{
+	if (!recorder->has_lock) {
+		spin_init(recorder);
+		recorder->has_lock = true;
+	}
+	search_recorder_stop(recorder);
+	spin_lock(recorder);
+		recorder->record = NULL;
+		recorder->n = recorder->size = 0;
+		recorder->is_recording = true;
+	spin_unlock(recorder);
+}
+
+/**
+ * @brief Record a finished search.
+ *
+ * Does nothing if the recorder is not started. Interrupted ponderings are not
+ * recorded, as they do not reflect the time spent per move.
+ *
+ * @param recorder Search recorder.
+ * @param search Finished search.
+ */
+void search_recorder_add(SearchRecorder *recorder, Search *search)
+{
+	SearchRecord *r;
+
+	if (!recorder->is_recording || search->stop == STOP_PONDERING) return;
+
+	spin_lock(recorder);
+	if (!recorder->is_recording) {	// stopped meanwhile
+		spin_unlock(recorder);
+		return;
+	}
+	if (recorder->n == recorder->size) {
+		recorder->size = MAX(1024, recorder->size * 2);
+		r = (SearchRecord*) realloc(recorder->record, recorder->size * sizeof (SearchRecord));
+		if (r == NULL) {
+			warn("cannot allocate %d search records\n", recorder->size);
+			recorder->size = recorder->n;
+			spin_unlock(recorder);
+			return;
+		}
+		recorder->record = r;
+	}
+	r = recorder->record + recorder->n++;
+	r->n_empties = search->eval.n_empties;
+	r->depth = search->result->depth;
+	r->selectivity = selectivity_table[search->result->selectivity].percent;
+	r->n_extensions = search->time.n_extensions;
+	r->time = search->result->time;
+	r->n_nodes = search->n_nodes + search->child_nodes;
+	r->n_helper_nodes = search->child_nodes;
+	spin_unlock(recorder);
+}
+
+/**
+ * @brief Compare two long long, for qsort().
+ */
+static int compare_ll(const void *a, const void *b)
+{
+	const long long x = *(const long long*) a, y = *(const long long*) b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Get a percentile of a sorted array.
+ *
+ * @param v Sorted array.
+ * @param n Array size.
+ * @param p Percentile.
+ * @return the value of the percentile.
+ */
+static long long percentile(const long long *v, const int n, const int p)
+{
+	return v[(n - 1) * p / 100];
+}
+
+/**
+ * @brief Print the recorded searches.
+ *
+ * For each bucket of empty squares, print the percentiles of the search time
+ * & of the node rate, the mean depth & selectivity reached, the rate of the
+ * searches with extended time, and the share of nodes searched by the helper
+ * tasks (thread utilization).
+ *
+ * @param recorder Search recorder.
+ * @param f Output stream.
+ */
+void search_recorder_print(SearchRecorder *recorder, FILE *f)
+{
+	long long *t, *speed;
+	int b, i, n, n_extended, n_extensions;
+	double depth, selectivity;
+	unsigned long long n_nodes, n_helper_nodes;
+
+	if (!recorder->is_recording) return;
+
+	spin_lock(recorder);
+	if (!recorder->is_recording || recorder->n == 0) {
+		spin_unlock(recorder);
+		return;
+	}
+	t = (long long*) malloc(2 * recorder->n * sizeof (long long));
+	if (t == NULL) {
+		spin_unlock(recorder);
+		warn("cannot allocate search statistics\n");
+		return;
+	}
+	speed = t + recorder->n;
+
+	fprintf(f, "\nSearch records: %d searches\n", recorder->n);
+	fprintf(f, "empties | searches |      time (ms): p50     p90     p99     max |   speed (kN/s): p10     p50     p90 | depth | select | extended | helpers\n");
+	fprintf(f, "--------+----------+-------------------------------------------+-----------------------------------+-------+--------+----------+--------\n");
+	for (b = 0; b <= 60 / RECORD_BUCKET; ++b) {
+		n = n_extended = n_extensions = 0;
+		depth = selectivity = 0.0;
+		n_nodes = n_helper_nodes = 0;
+		for (i = 0; i < recorder->n; ++i) {
+			const SearchRecord *r = recorder->record + i;
+			if ((r->n_empties + RECORD_BUCKET - 1) / RECORD_BUCKET == b) {
+				t[n] = r->time;
+				speed[n] = r->n_nodes / MAX(r->time, 1);
+				depth += r->depth;
+				selectivity += r->selectivity;
+				n_extended += (r->n_extensions > 0);
+				n_extensions += r->n_extensions;
+				n_nodes += r->n_nodes;
+				n_helper_nodes += r->n_helper_nodes;
+				++n;
+			}
+		}
+		if (n == 0) continue;
+
+		qsort(t, n, sizeof (long long), compare_ll);
+		qsort(speed, n, sizeof (long long), compare_ll);
+		if (b == 0) fprintf(f, "      0 ");
+		else fprintf(f, "  %2d-%2d ", (b - 1) * RECORD_BUCKET + 1, b * RECORD_BUCKET);
+		fprintf(f, "| %8d | %23lld %7lld %7lld %7lld ", n, percentile(t, n, 50), percentile(t, n, 90), percentile(t, n, 99), t[n - 1]);
+		fprintf(f, "| %23lld %7lld %7lld ", percentile(speed, n, 10), percentile(speed, n, 50), percentile(speed, n, 90));
+		fprintf(f, "| %5.1f | %5.1f%% | %5.1f%% %2d | %5.1f%%\n", depth / n, selectivity / n, 100.0 * n_extended / n, n_extensions,
+			n_nodes ? 100.0 * n_helper_nodes / n_nodes : 0.0);
+	}
+	spin_unlock(recorder);
+
+	free(t);
+}
+
+/**
+ * @brief Stop to record the searches & free the records.
+ *
+ * The flag is cleared under the lock, so that a search_recorder_add() that
+ * saw the recorder on before cannot write into the freed records. The lock
+ * itself is kept for the next start.
+ *
+ * @param recorder Search recorder.
+ */
+void search_recorder_stop(SearchRecorder *recorder)
+{
+	if (!recorder->is_recording) return;
+	spin_lock(recorder);
+		recorder->is_recording = false;
+		free(recorder->record);
+		recorder->record = NULL;
+		recorder->n = recorder->size = 0;
+	spin_unlock(recorder);
+}
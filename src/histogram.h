@@ -11,11 +11,44 @@
 #ifndef EDAX_HISTOGRAM_H
 #define EDAX_HISTOGRAM_H
 
+#include "util.h"
+
+#include <stdio.h>
+
+/** Record of a single search */
+typedef struct SearchRecord {
+	int n_empties;                /**< number of empty squares */
+	int depth;                    /**< depth reached */
+	int selectivity;              /**< selectivity reached (as a percentage) */
+	int n_extensions;             /**< number of time extensions */
+	long long time;               /**< search time (in ms) */
+	unsigned long long n_nodes;   /**< searched nodes */
+	unsigned long long n_helper_nodes; /**< nodes searched by the helper tasks */
+} SearchRecord;
+
+/** Recorder of the searches */
+typedef struct SearchRecorder {
+	SearchRecord *record;         /**< records */
+	int n;                        /**< number of records */
+	int size;                     /**< allocated number of records */
+	volatile bool is_recording;   /**< recording flag */
+	bool has_lock;                /**< the lock is initialized (it is kept once initialized) */
+	SpinLock spin;                /**< lock */
+} SearchRecorder;
+
+extern SearchRecorder search_recorder;
+struct Search;
+
 /* declaration */
 void histogram_init(unsigned long long h[129][65]);
 void histogram_print(unsigned long long h[129][65]);
 void histogram_stats(unsigned long long h[129][65]);
 void histogram_to_ppm(const char *file, unsigned long long histogram[129][65]);
 
+void search_recorder_start(SearchRecorder*);
+void search_recorder_add(SearchRecorder*, struct Search*);
+void search_recorder_print(SearchRecorder*, FILE*);
+void search_recorder_stop(SearchRecorder*);
+
 #endif
 
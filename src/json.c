@@ -0,0 +1,635 @@
+/**
+ * @file json.c
+ *
+ * Batch analysis server, over JSON-lines.
+ *
+ * Each input line is a request, as a JSON object:
+ *   {"id": 1, "board": "<board string>", "level": 21, "depth": 20, "multipv": 3, "time": 10}
+ * where only "board" (in the format of the setboard command) is mandatory:
+ *   - "id" is any JSON value, re-serialized into the result;
+ *   - "level" overrides the -level option, "depth" limits the searched depth;
+ *   - "multipv" is the number of best moves to search (1 by default);
+ *   - "time" is the time limit (in seconds) of each move search.
+ * The best moves of a request are searched at once, in multi-PV mode.
+ * The requests are searched concurrently by a pool of -batch-searches searches,
+ * sharing the tasks & the hash table (see pool.c), and a result is sent as a single
+ * JSON line when its search completes (i.e. not in the request order):
+ *   {"id": 1, "lines": [{"move": "d3", "score": 2, "depth": 20, "probability": 73, "pv": ["d3", "c3"]}, ...], "nodes": 123456, "time": 789}
+ * or {"id": 1, "error": "<message>"} for an invalid request.
+ * Plain "stop" cancels the pending & running requests, which are all answered
+ * by {"id": 1, "error": "stopped"}; "quit" (or the end of the input) quits once
+ * the pending requests are done.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#include "options.h"
+#include "pool.h"
+#include "search.h"
+#include "util.h"
+#include "ui.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+/** a JSON analysis request */
+typedef struct JsonRequest {
+	char *id;                      /**< request id, as a JSON value */
+	Board board;                   /**< position to analyze */
+	int player;                    /**< player to move */
+	int level;                     /**< search level */
+	int depth;                     /**< maximal search depth, or -1 */
+	int multipv;                   /**< number of best moves to search */
+	long long time;                /**< time limit per move, in ms */
+	int generation;                /**< stop generation of the request */
+	struct JsonRequest *next;      /**< next request in the queue */
+} JsonRequest;
+
+/** a search of the pool */
+typedef struct JsonWorker {
+	Search *search;                /**< search */
+	Thread thread;                 /**< thread */
+	volatile bool is_busy;         /**< true while a request is analyzed */
+} JsonWorker;
+
+/** the server */
+static struct {
+	SearchPool pool;               /**< pool of searches */
+	JsonWorker *worker;            /**< a thread for each search of the pool */
+	int n_worker;                  /**< pool size */
+	JsonRequest *first, *last;     /**< pending requests */
+	volatile int generation;       /**< incremented at each stop */
+	bool quit;                     /**< quit once the pending requests are done */
+	Lock lock;                     /**< lock of the queue */
+	Condition cond;                /**< wake up the searches */
+	SpinLock spin;                 /**< lock of the output */
+} json_server;
+
+/** maximal nesting of a JSON value */
+#define JSON_MAX_DEPTH 32
+
+/** maximal length of an (escaped) error message */
+#define JSON_MAX_MESSAGE 128
+
+/** a growing string */
+typedef struct JsonString {
+	char *s;                       /**< characters (nul terminated) */
+	size_t n;                      /**< length */
+	size_t size;                   /**< allocated size */
+} JsonString;
+
+/**
+ * @brief Append characters to a string.
+ *
+ * @param out String, or NULL to discard the characters.
+ * @param s Characters.
+ * @param n Number of characters.
+ */
+static void json_append(JsonString *out, const char *s, const size_t n)
+{
+	if (out == NULL) return;
+	if (out->n + n + 1 > out->size) {
+		out->size = 2 * (out->n + n + 1) + 64;
+		out->s = (char*) realloc(out->s, out->size);
+		if (out->s == NULL) fatal_error("Cannot allocate a json string\n");
+	}
+	memcpy(out->s + out->n, s, n);
+	out->n += n;
+	out->s[out->n] = '\0';
+}
+
+/**
+ * @brief Append a text as the characters of a JSON string.
+ *
+ * The text is escaped first, then truncated, between two characters, to at
+ * most max escaped characters.
+ *
+ * @param out String.
+ * @param s Text.
+ * @param max Maximal length of the escaped text.
+ */
+static void json_escape(JsonString *out, const char *s, const size_t max)
+{
+	char c[8];
+	size_t n, len = 0;
+
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\') n = sprintf(c, "\\%c", *s);
+		else if ((unsigned char) *s < 0x20) n = sprintf(c, "\\u%04x", (unsigned char) *s);
+		else n = sprintf(c, "%c", *s);
+		if (len + n > max) break;
+		json_append(out, c, n);
+		len += n;
+	}
+}
+
+/**
+ * @brief Scan a JSON value & re-serialize it.
+ *
+ * Strings are copied with their (checked) escapes, control characters are
+ * escaped, and arrays & objects are rewritten on a single line.
+ *
+ * @param s Value.
+ * @param out Re-serialized value (output), or NULL to only scan the value.
+ * @param depth Nesting depth.
+ * @return the end of the value, or NULL if it is not a valid JSON value.
+ */
+static const char* json_scan(const char *s, JsonString *out, const int depth)
+{
+	const char *start = s;
+	char c[8];
+
+	if (depth > JSON_MAX_DEPTH) return NULL;
+
+	if (*s == '"') {
+		json_append(out, s++, 1);
+		for (; *s != '"'; ++s) {
+			if (*s == '\0') return NULL;
+			if (*s == '\\') {
+				if (s[1] == 'u' && isxdigit(s[2]) && isxdigit(s[3]) && isxdigit(s[4]) && isxdigit(s[5])) {
+					json_append(out, s, 6);
+					s += 5;
+				} else if (s[1] && strchr("\"\\/bfnrt", s[1])) {
+					json_append(out, s++, 2);
+				} else return NULL;
+			} else if ((unsigned char) *s < 0x20) {
+				json_append(out, c, sprintf(c, "\\u%04x", (unsigned char) *s));
+			} else {
+				json_append(out, s, 1);
+			}
+		}
+		json_append(out, s++, 1);
+
+	} else if (*s == '[' || *s == '{') {
+		const char close = (*s == '[') ? ']' : '}';
+		json_append(out, s, 1);
+		s = parse_skip_spaces(s + 1);
+		while (*s != close) {
+			if (s != parse_skip_spaces(start + 1)) {
+				if (*s != ',') return NULL;
+				json_append(out, ", ", 2);
+				s = parse_skip_spaces(s + 1);
+			}
+			if (close == '}') {
+				if (*s != '"' || (s = json_scan(s, out, depth + 1)) == NULL) return NULL;
+				s = parse_skip_spaces(s);
+				if (*s != ':') return NULL;
+				json_append(out, ": ", 2);
+				s = parse_skip_spaces(s + 1);
+			}
+			if ((s = json_scan(s, out, depth + 1)) == NULL) return NULL;
+			s = parse_skip_spaces(s);
+		}
+		json_append(out, s++, 1);
+
+	} else if (strncmp(s, "true", 4) == 0 || strncmp(s, "null", 4) == 0 || strncmp(s, "false", 5) == 0) {
+		s += (*s == 'f') ? 5 : 4;
+		if (isalnum(*s)) return NULL;
+		json_append(out, start, s - start);
+
+	} else {
+		if (*s == '-') ++s;
+		if (*s == '0') ++s;
+		else if (isdigit(*s)) while (isdigit(*s)) ++s;
+		else return NULL;
+		if (*s == '.') {
+			if (!isdigit(*++s)) return NULL;
+			while (isdigit(*s)) ++s;
+		}
+		if (*s == 'e' || *s == 'E') {
+			++s;
+			if (*s == '+' || *s == '-') ++s;
+			if (!isdigit(*s)) return NULL;
+			while (isdigit(*s)) ++s;
+		}
+		json_append(out, start, s - start);
+	}
+
+	return s;
+}
+
+/**
+ * @brief Find the value of a key of an object.
+ *
+ * Only the keys of the object itself are looked at, not the keys of the
+ * objects it contains.
+ *
+ * @param line JSON object.
+ * @param key Key.
+ * @return the value, or NULL if the key is absent (or the object invalid).
+ */
+static const char* json_find(const char *line, const char *key)
+{
+	const size_t n = strlen(key);
+	const char *s = parse_skip_spaces(line), *k;
+	bool is_key;
+
+	if (*s != '{') return NULL;
+	s = parse_skip_spaces(s + 1);
+	while (*s == '"') {
+		k = s;
+		if ((s = json_scan(s, NULL, 0)) == NULL) return NULL;
+		is_key = ((size_t) (s - k) == n + 2 && strncmp(k + 1, key, n) == 0);
+		s = parse_skip_spaces(s);
+		if (*s != ':') return NULL;
+		s = parse_skip_spaces(s + 1);
+		if (is_key) return s;
+		if ((s = json_scan(s, NULL, 0)) == NULL) return NULL;
+		s = parse_skip_spaces(s);
+		if (*s != ',') return NULL;
+		s = parse_skip_spaces(s + 1);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Get a value, re-serialized as JSON.
+ *
+ * @param line JSON object.
+ * @param key Key.
+ * @param value Newly allocated value (output), or NULL if the key is absent.
+ * @return false if the value is not a valid JSON value.
+ */
+static bool json_get_value(const char *line, const char *key, char **value)
+{
+	const char *s = json_find(line, key);
+	JsonString out = {NULL, 0, 0};
+
+	*value = NULL;
+	if (s == NULL) return true;
+	if (json_scan(s, &out, 0) == NULL) {
+		free(out.s);
+		return false;
+	}
+	*value = out.s;
+	return true;
+}
+
+/**
+ * @brief Get the text of a string value.
+ *
+ * @param line JSON object.
+ * @param key Key.
+ * @return a newly allocated string, or NULL if the key is absent or not a string.
+ */
+static char* json_get_string(const char *line, const char *key)
+{
+	const char *s = json_find(line, key), *end;
+	char *value;
+
+	if (s == NULL || *s != '"' || (end = json_scan(s, NULL, 0)) == NULL) return NULL;
+	++s; --end;
+	value = (char*) malloc(end - s + 1);
+	if (value) {
+		memcpy(value, s, end - s);
+		value[end - s] = '\0';
+	}
+	return value;
+}
+
+/**
+ * @brief Get a numerical value.
+ *
+ * @param line JSON object.
+ * @param key Key.
+ * @param value Value (output), unchanged if the key is absent.
+ * @return false if the value is not a number.
+ */
+static bool json_get_number(const char *line, const char *key, double *value)
+{
+	const char *s = json_find(line, key);
+	char *end;
+	double x;
+
+	if (s == NULL) return true;
+	x = strtod(s, &end);
+	if (end == s) return false;
+	*value = x;
+	return true;
+}
+
+/**
+ * @brief Send a JSON line.
+ *
+ * @param line JSON line.
+ */
+static void json_send(const char *line)
+{
+	spin_lock(&json_server);
+		puts(line);
+		fflush(stdout);
+	spin_unlock(&json_server);
+}
+
+/**
+ * @brief Report an invalid request.
+ *
+ * @param id Request id (a JSON value), or NULL.
+ * @param message Error message.
+ */
+static void json_fail(const char *id, const char *message)
+{
+	JsonString line = {NULL, 0, 0};
+
+	json_append(&line, "{\"id\": ", 7);
+	if (id) json_append(&line, id, strlen(id));
+	else json_append(&line, "null", 4);
+	json_append(&line, ", \"error\": \"", 12);
+	json_escape(&line, message, JSON_MAX_MESSAGE);
+	json_append(&line, "\"}", 2);
+	json_send(line.s);
+	free(line.s);
+}
+
+/**
+ * @brief Parse a request.
+ *
+ * @param line Input line.
+ * @return a request, or NULL if it is invalid (& reported).
+ */
+static JsonRequest* json_parse_request(const char *line)
+{
+	JsonRequest *request;
+	const char *s;
+	char *board;
+	double level = options.level, depth = options.depth, multipv = 1.0;
+	double time = (options.play_type == EDAX_TIME_PER_MOVE ? options.time : TIME_MAX) * 0.001;
+
+	request = (JsonRequest*) malloc(sizeof (JsonRequest));
+	if (request == NULL) fatal_error("Cannot allocate a json request\n");
+	request->next = NULL;
+	board = NULL;
+
+	if ((s = json_scan(parse_skip_spaces(line), NULL, 0)) == NULL || *parse_skip_spaces(s)) {
+		request->id = NULL;
+		json_fail(NULL, "bad json");
+	} else if (!json_get_value(line, "id", &request->id)) {
+		json_fail(NULL, "bad id");
+	} else if (json_find(line, "board") == NULL) {
+		json_fail(request->id, "missing board");
+	} else if ((board = json_get_string(line, "board")) == NULL) {
+		json_fail(request->id, "bad board");
+	} else if ((request->player = board_set(&request->board, board)) == EMPTY
+		|| (request->board.player & request->board.opponent)) {
+		json_fail(request->id, "bad board");
+	} else if (!json_get_number(line, "level", &level) || !json_get_number(line, "depth", &depth)
+		|| !json_get_number(line, "multipv", &multipv) || !json_get_number(line, "time", &time)) {
+		json_fail(request->id, "bad number");
+	} else {
+		BOUND(level, 0, 60, "level");
+		BOUND(depth, -1, 60, "depth");
+		BOUND(multipv, 1, MAX_MOVE, "multipv");
+		BOUND(time, 0.001, (TIME_MAX * 0.001), "time");
+		request->level = (int) level;
+		request->depth = (int) depth;
+		request->multipv = (int) multipv;
+		request->time = (long long) (time * 1000.0);
+		free(board);
+		return request;
+	}
+
+	free(board);
+	free(request->id);
+	free(request);
+	return NULL;
+}
+
+/**
+ * @brief Print a line of a result.
+ *
+ * @param s Output string.
+ * @param result Search result.
+ * @param move First move of the line.
+ * @param score Score of the line.
+ * @param pv Principal variation of the line.
+ * @return the end of the output string.
+ */
+static char* json_print_line(char *s, const Result *result, const int move, const int score, const Line *pv)
+{
+	char m[4];
+	int k;
+
+	s += sprintf(s, "{\"move\": \"%s\", \"score\": %d, \"depth\": %d, \"probability\": %d, \"pv\": [",
+		move_to_string(move, WHITE, m), score, result->depth, selectivity_table[result->selectivity].percent);
+	for (k = 0; k < pv->n_moves; ++k) {
+		s += sprintf(s, "%s\"%s\"", k ? ", " : "", move_to_string(pv->move[k], WHITE, m));
+	}
+	s += sprintf(s, "]}");
+
+	return s;
+}
+
+/**
+ * @brief Analyze a request & send its result.
+ *
+ * The best moves are searched at once, in multi-PV mode. A request stopped
+ * before or while it is searched gets a "stopped" error, as a pending one,
+ * instead of a partial result.
+ *
+ * @param search Search.
+ * @param request Request.
+ */
+static void json_analyze(Search *search, JsonRequest *request)
+{
+	const long long t0 = real_clock();
+	Result *result = search->result;
+	bool is_stopped = (request->generation != json_server.generation);
+	char *line, *s;
+	int i;
+
+	if (is_stopped) {
+		json_fail(request->id, "stopped");
+		return;
+	}
+
+	search_pool_start(&json_server.pool, search);
+	if (json_server.pool.is_partitioned) search_cleanup(search);
+	search_set_board(search, &request->board, request->player);
+	search_set_level(search, request->level, search->eval.n_empties);
+	if (request->depth >= 0) search->options.depth = MIN(request->depth, search->eval.n_empties);
+	search_set_move_time(search, request->time);
+	search->options.multipv = MIN(request->multipv, MAX(search->movelist.n_moves, 1));
+
+	search_run(search);
+	is_stopped = (search->stop == STOP_ON_DEMAND);
+	search->options.multipv = 1;
+	search_pool_end(&json_server.pool, search);
+
+	if (is_stopped) {
+		json_fail(request->id, "stopped");
+		return;
+	}
+
+	line = (char*) malloc(256 + request->multipv * (128 + 6 * GAME_SIZE) + (request->id ? strlen(request->id) : 4));
+	if (line == NULL) fatal_error("Cannot allocate a json result\n");
+	s = line + sprintf(line, "{\"id\": %s, \"lines\": [", request->id ? request->id : "null");
+
+	spin_lock(result);
+	if (result->n_lines > 1) {
+		for (i = 0; i < result->n_lines; ++i) {
+			if (i) s += sprintf(s, ", ");
+			s = json_print_line(s, result, result->line[i].move, result->line[i].score, &result->line[i].pv);
+		}
+	} else {
+		s = json_print_line(s, result, result->move, result->score, &result->pv);
+	}
+	sprintf(s, "], \"nodes\": %llu, \"time\": %lld}", result->n_nodes, real_clock() - t0);
+	spin_unlock(result);
+
+	json_send(line);
+	free(line);
+}
+
+/**
+ * @brief Analyze the requests of the queue, until the server quits.
+ *
+ * @param v Worker.
+ * @return NULL.
+ */
+static void* json_work(void *v)
+{
+	JsonWorker *worker = (JsonWorker*) v;
+	JsonRequest *request;
+
+	lock(&json_server);
+	for (;;) {
+		while (json_server.first == NULL && !json_server.quit) condition_wait(&json_server);
+		if ((request = json_server.first) == NULL) break;
+		if ((json_server.first = request->next) == NULL) json_server.last = NULL;
+		worker->is_busy = true;
+		unlock(&json_server);
+
+		json_analyze(worker->search, request);
+		free(request->id);
+		free(request);
+
+		lock(&json_server);
+		worker->is_busy = false;
+	}
+	unlock(&json_server);
+
+	return NULL;
+}
+
+/**
+ * @brief Cancel the pending & running requests.
+ */
+static void json_stop(void)
+{
+	JsonRequest *request;
+	int i;
+
+	lock(&json_server);
+		while ((request = json_server.first) != NULL) {
+			json_server.first = request->next;
+			json_fail(request->id, "stopped");
+			free(request->id);
+			free(request);
+		}
+		json_server.last = NULL;
+		++json_server.generation;
+	unlock(&json_server);
+
+	// a search stopped before it starts would run again, so insist until its end.
+	for (i = 0; i < json_server.n_worker; ++i) {
+		while (json_server.worker[i].is_busy) {
+			search_stop_all(json_server.worker[i].search, STOP_ON_DEMAND);
+			relax(1);
+		}
+	}
+}
+
+/**
+ * @brief Initialize the json server.
+ *
+ * @param ui User interface.
+ */
+void ui_init_json(UI *ui)
+{
+	int i;
+
+	(void) ui;
+
+	json_server.n_worker = options.n_search;
+	json_server.worker = (JsonWorker*) malloc(json_server.n_worker * sizeof (JsonWorker));
+	if (json_server.worker == NULL) fatal_error("Cannot allocate %d json workers\n", json_server.n_worker);
+	json_server.first = json_server.last = NULL;
+	json_server.generation = 0;
+	json_server.quit = false;
+	lock_init(&json_server);
+	condition_init(&json_server);
+	spin_init(&json_server);
+
+	search_pool_init(&json_server.pool, json_server.n_worker, options.partition_hash);
+	for (i = 0; i < json_server.n_worker; ++i) {
+		JsonWorker *worker = json_server.worker + i;
+		worker->search = search_pool_get(&json_server.pool, i);
+		worker->search->options.verbosity = 0;
+		worker->is_busy = false;
+		thread_create(&worker->thread, json_work, worker);
+	}
+}
+
+/**
+ * @brief Loop event: read & queue the requests.
+ *
+ * @param ui User interface.
+ */
+void ui_loop_json(UI *ui)
+{
+	JsonRequest *request;
+	char *line, cmd[8];
+
+	for (;;) {
+		line = event_wait_message(&ui->event);
+		parse_word(line, cmd, 5);
+		string_to_lowercase(cmd);
+
+		if (*line == '{') {
+			if ((request = json_parse_request(line)) != NULL) {
+				lock(&json_server);
+					request->generation = json_server.generation;
+					if (json_server.last) json_server.last->next = request;
+					else json_server.first = request;
+					json_server.last = request;
+					condition_signal(&json_server);
+				unlock(&json_server);
+			}
+		} else if (strcmp(cmd, "stop") == 0) {
+			json_stop();
+		} else if (strcmp(cmd, "quit") == 0 || strcmp(cmd, "q") == 0 || strcmp(cmd, "eof") == 0) {
+			free(line);
+			break;
+		} else if (*cmd) {
+			json_fail(NULL, "bad request");
+		}
+		free(line);
+	}
+}
+
+/**
+ * @brief Free the json server, once the pending requests are done.
+ *
+ * @param ui User interface.
+ */
+void ui_free_json(UI *ui)
+{
+	int i;
+
+	(void) ui;
+
+	lock(&json_server);
+		json_server.quit = true;
+		condition_broadcast(&json_server);
+	unlock(&json_server);
+
+	for (i = 0; i < json_server.n_worker; ++i) thread_join(json_server.worker[i].thread);
+	search_pool_free(&json_server.pool);
+	free(json_server.worker);
+
+	spin_free(&json_server);
+	condition_free(&json_server);
+	lock_free(&json_server);
+}
@@ -0,0 +1,500 @@
+/**
+ * @file libedax.c
+ *
+ * Embeddable Edax engine: implementation of the C API of libedax.h.
+ *
+ * The global state of Edax is handled as follows:
+ *   - the evaluation weights (EVAL_WEIGHT), the opening book & the various
+ *     precomputed tables are loaded once by edax_library_init(), & are only
+ *     read by the engines;
+ *   - the global options are set once to quiet library defaults. The
+ *     settings of an engine (tasks, hash tables, level, time) are kept in its
+ *     own Search. The few global options search_init() reads are set under
+ *     the library lock while an engine is created;
+ *   - the statistics are summed atomically.
+ * Each engine owns a Search, with its own task stack & hash tables, so that
+ * several engines can search at the same time.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#include "libedax.h"
+
+#include "board.h"
+#include "book.h"
+#include "eval.h"
+#include "options.h"
+#include "search.h"
+#include "stats.h"
+#include "util.h"
+
+/** an engine */
+struct EdaxEngine {
+	Search search;               /**< search */
+	Board board;                 /**< position to search */
+	int player;                  /**< player to move */
+	int level;                   /**< search level */
+	long long time;              /**< time per move (in ms), 0 for no limit */
+	EdaxCallback callback;       /**< result callback */
+	void *data;                  /**< callback data */
+	Thread thread;               /**< asynchronous search thread */
+	bool launched;               /**< asynchronous search launched */
+	volatile bool is_searching;  /**< search running */
+	struct EdaxEngine *next;     /**< next engine of the library */
+};
+
+/** logs of the protocols (cassio.c & xboard.c) the search refers to, never opened here */
+Log engine_log[1], xboard_log[1];
+
+/**
+ * @brief Usage, required by options.c (no command line here).
+ */
+void usage(void)
+{
+}
+
+/** the library */
+static struct {
+	EdaxEngine *engines;         /**< engines, to find them from their search result */
+	Book book;                   /**< opening book */
+	Search *book_search;         /**< search of the opening book, NULL without book */
+	bool is_init;                /**< initialized library */
+	Lock lock;                   /**< lock */
+} library;
+
+/**
+ * @brief Init a search.
+ *
+ * @param search Search.
+ * @param n_tasks Number of tasks.
+ * @param hash_bits Size of the hash table, in bits.
+ */
+static void library_search_init(Search *search, const int n_tasks, const int hash_bits)
+{
+	int n_task, hash_table_size;
+
+	// search_init() reads its task number & hash table size from the global options
+	lock(&library);
+		n_task = options.n_task;
+		hash_table_size = options.hash_table_size;
+		options.n_task = n_tasks;
+		options.hash_table_size = hash_bits;
+		search_init(search);
+		options.n_task = n_task;
+		options.hash_table_size = hash_table_size;
+	unlock(&library);
+}
+
+/**
+ * @brief Get the version of the API.
+ *
+ * @return EDAX_API_VERSION.
+ */
+int edax_api_version(void)
+{
+	return EDAX_API_VERSION;
+}
+
+/**
+ * @brief Initialize the library.
+ *
+ * To be called once, before any other function.
+ *
+ * @param eval_file Evaluation weights (data/eval.dat).
+ * @param book_file Opening book, or NULL.
+ * @return false if a file cannot be read.
+ */
+bool edax_library_init(const char *eval_file, const char *book_file)
+{
+	FILE *f;
+
+	if (library.is_init) return true;
+
+	if ((f = fopen(eval_file, "rb")) == NULL) return false;
+	fclose(f);
+	if (book_file) {
+		if ((f = fopen(book_file, "rb")) == NULL) return false;
+		fclose(f);
+	}
+
+	// quiet library defaults
+	options.verbosity = 0;
+	options.info = false;
+
+	bit_init();
+	edge_stability_init();
+	statistics_init();
+	eval_open(eval_file);
+	search_global_init();
+	lock_init(&library);
+	library.engines = NULL;
+
+	// the book search is only used to repair a bad book file
+	library.book_search = NULL;
+	if (book_file) {
+		library.book_search = (Search*) mm_malloc(sizeof (Search));
+		if (library.book_search == NULL) fatal_error("Cannot allocate the book search\n");
+		library_search_init(library.book_search, 1, 16);
+		library.book.search = library.book_search;
+		book_load(&library.book, book_file);
+	}
+
+	library.is_init = true;
+
+	return true;
+}
+
+/**
+ * @brief Free the library.
+ *
+ * To be called once all the engines are freed.
+ */
+void edax_library_free(void)
+{
+	if (!library.is_init) return;
+
+	if (library.book_search) {
+		book_free(&library.book);
+		search_free(library.book_search);
+		mm_free(library.book_search);
+		library.book_search = NULL;
+	}
+	eval_close();
+	lock_free(&library);
+	library.is_init = false;
+}
+
+/**
+ * @brief Convert a search result.
+ *
+ * @param result Search result.
+ * @param r Converted result (output).
+ */
+static void result_convert(Result *result, EdaxResult *r)
+{
+	int i;
+
+	spin_lock(result);
+		r->move = result->move;
+		r->score = result->score;
+		r->lower = result->bound[result->move].lower;
+		r->upper = result->bound[result->move].upper;
+		r->depth = result->depth;
+		r->probability = selectivity_table[result->selectivity].percent;
+		r->time = result->time;
+		r->n_nodes = result->n_nodes;
+		r->n_pv = MIN(result->pv.n_moves, EDAX_MAX_PV);
+		for (i = 0; i < r->n_pv; ++i) r->pv[i] = result->pv.move[i];
+	spin_unlock(result);
+	r->done = false;
+}
+
+/**
+ * @brief Search observer: call back the engine of the result.
+ *
+ * @param result Search result.
+ */
+static void library_observer(Result *result)
+{
+	EdaxEngine *engine;
+	EdaxResult r;
+
+	lock(&library);
+		for (engine = library.engines; engine && engine->search.result != result; engine = engine->next) ;
+	unlock(&library);
+
+	if (engine && engine->callback) {
+		result_convert(result, &r);
+		engine->callback(&r, engine->data);
+	}
+}
+
+/**
+ * @brief Create an engine.
+ *
+ * @param n_tasks Number of parallel tasks (<= 0 for the number of cpus).
+ * @param hash_bits Size of the hash table, in bits (<= 0 for the default size).
+ * @return the engine, or NULL.
+ */
+EdaxEngine* edax_engine_new(const int n_tasks, const int hash_bits)
+{
+	EdaxEngine *engine;
+	int n = (n_tasks > 0 ? n_tasks : get_cpu_number());
+	int size = (hash_bits > 0 ? hash_bits : options.hash_table_size);
+	const int max_size = (sizeof (void*) == 4 ? 25 : 30);	// as options_bound()
+
+	if (!library.is_init) return NULL;
+
+	BOUND(n, 1, MAX_THREADS, "n_tasks");
+	BOUND(size, 10, max_size, "hash_bits");
+	engine = (EdaxEngine*) mm_malloc(sizeof (EdaxEngine));
+	if (engine == NULL) return NULL;
+
+	library_search_init(&engine->search, n, size);
+	search_set_observer(&engine->search, library_observer);
+	engine->search.options.verbosity = 0;
+	engine->board.player = engine->board.opponent = 0;
+	engine->player = EMPTY;
+	engine->level = 60;
+	engine->time = 0;
+	engine->callback = NULL;
+	engine->data = NULL;
+	engine->launched = engine->is_searching = false;
+
+	lock(&library);
+		engine->next = library.engines;
+		library.engines = engine;
+	unlock(&library);
+
+	return engine;
+}
+
+/**
+ * @brief Free an engine.
+ *
+ * @param engine Engine.
+ */
+void edax_engine_free(EdaxEngine *engine)
+{
+	EdaxEngine **e;
+
+	if (engine == NULL) return;
+
+	edax_engine_stop(engine);
+	edax_engine_wait(engine, NULL);
+
+	lock(&library);
+		for (e = &library.engines; *e && *e != engine; e = &(*e)->next) ;
+		if (*e) *e = engine->next;
+	unlock(&library);
+
+	search_free(&engine->search);
+	mm_free(engine);
+}
+
+/**
+ * @brief Set the position to search.
+ *
+ * @param engine Engine.
+ * @param board Position: 64 squares from A1 to H8 ('X' or '*' for black, 'O' for white, '-' for empty) & the player to move.
+ * @return false if the position is invalid, or if the engine is searching.
+ */
+bool edax_engine_set_position(EdaxEngine *engine, const char *board)
+{
+	Board b;
+	int player;
+
+	if (engine->is_searching) return false;
+	player = board_set(&b, board);
+	if (player == EMPTY) return false;
+
+	engine->board = b;
+	engine->player = player;
+
+	return true;
+}
+
+/**
+ * @brief Set the search level.
+ *
+ * @param engine Engine.
+ * @param level Level, from 0 to 60 (as the -level option).
+ */
+void edax_engine_set_level(EdaxEngine *engine, const int level)
+{
+	engine->level = level;
+	BOUND(engine->level, 0, 60, "level");
+}
+
+/**
+ * @brief Set the search time.
+ *
+ * @param engine Engine.
+ * @param time Time per move (in ms), or 0 for no limit.
+ */
+void edax_engine_set_time(EdaxEngine *engine, const long long time)
+{
+	engine->time = MAX(time, 0);
+}
+
+/**
+ * @brief Set the result callback.
+ *
+ * The callback receives the result of each iteration & the final result,
+ * from the search thread.
+ *
+ * @param engine Engine.
+ * @param callback Callback, or NULL.
+ * @param data Callback data.
+ */
+void edax_engine_set_callback(EdaxEngine *engine, EdaxCallback callback, void *data)
+{
+	engine->callback = callback;
+	engine->data = data;
+}
+
+/**
+ * @brief Prepare a search.
+ *
+ * @param engine Engine.
+ * @return false if the engine cannot search.
+ */
+static bool engine_prepare(EdaxEngine *engine)
+{
+	Search *search = &engine->search;
+
+	if (engine->is_searching || engine->launched || engine->player == EMPTY || board_is_game_over(&engine->board)) return false;
+
+	search_set_board(search, &engine->board, engine->player);
+	search_set_level(search, engine->level, search->eval.n_empties);
+	if (engine->time > 0) search_set_move_time(search, engine->time);
+	else search_set_game_time(search, TIME_MAX);
+	search->options.verbosity = (engine->callback ? 2 : 0);
+	engine->is_searching = true;
+
+	return true;
+}
+
+/**
+ * @brief Run a search.
+ *
+ * @param v Engine.
+ * @return NULL (unused).
+ */
+static void* engine_run(void *v)
+{
+	EdaxEngine *engine = (EdaxEngine*) v;
+	EdaxResult r;
+
+	search_run(&engine->search);
+	if (engine->callback) {
+		result_convert(engine->search.result, &r);
+		r.done = true;
+		engine->callback(&r, engine->data);
+	}
+	engine->is_searching = false;
+
+	return NULL;
+}
+
+/**
+ * @brief Search synchronously.
+ *
+ * @param engine Engine.
+ * @param result Final result (output).
+ * @return false if the engine cannot search.
+ */
+bool edax_engine_search(EdaxEngine *engine, EdaxResult *result)
+{
+	if (!engine_prepare(engine)) return false;
+	engine_run(engine);
+	result_convert(engine->search.result, result);
+	result->done = true;
+
+	return true;
+}
+
+/**
+ * @brief Start an asynchronous search.
+ *
+ * @param engine Engine.
+ * @return false if the engine cannot search.
+ */
+bool edax_engine_start(EdaxEngine *engine)
+{
+	if (!engine_prepare(engine)) return false;
+	engine->launched = true;
+	thread_create(&engine->thread, engine_run, engine);
+
+	return true;
+}
+
+/**
+ * @brief Wait the end of an asynchronous search.
+ *
+ * @param engine Engine.
+ * @param result Final result (output), or NULL.
+ * @return false if no search was started.
+ */
+bool edax_engine_wait(EdaxEngine *engine, EdaxResult *result)
+{
+	if (!engine->launched) return false;
+	thread_join(engine->thread);
+	engine->launched = false;
+	if (result) {
+		result_convert(engine->search.result, result);
+		result->done = true;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Stop the search.
+ *
+ * Return once the search is over.
+ *
+ * @param engine Engine.
+ */
+void edax_engine_stop(EdaxEngine *engine)
+{
+	// a search stopped before it starts would run again, so insist until its end.
+	while (engine->is_searching) {
+		search_stop_all(&engine->search, STOP_ON_DEMAND);
+		relax(1);
+	}
+}
+
+/**
+ * @brief Check if the engine is searching.
+ *
+ * @param engine Engine.
+ * @return true if a search is running.
+ */
+bool edax_engine_is_searching(const EdaxEngine *engine)
+{
+	return engine->is_searching;
+}
+
+/**
+ * @brief Evaluate the position with the evaluation function.
+ *
+ * @param engine Engine.
+ * @return the evaluation, in discs, for the player to move.
+ */
+int edax_engine_evaluate(EdaxEngine *engine)
+{
+	if (engine->is_searching || engine->player == EMPTY) return 0;
+	search_set_board(&engine->search, &engine->board, engine->player);
+
+	return search_eval_0(&engine->search);
+}
+
+/**
+ * @brief Probe the opening book.
+ *
+ * @param engine Engine.
+ * @param moves Book moves, sorted from the best one (output).
+ * @param n_max Size of the moves array.
+ * @return the number of book moves (0 if the position is out of the book).
+ */
+int edax_engine_book_moves(EdaxEngine *engine, EdaxBookMove *moves, const int n_max)
+{
+	MoveList movelist;
+	Move *move;
+	int n = 0;
+
+	if (library.book_search == NULL || engine->player == EMPTY) return 0;
+	if (!book_get_moves(&library.book, &engine->board, &movelist)) return 0;
+
+	foreach_move(move, movelist) {
+		if (n == n_max) break;
+		moves[n].move = move->x;
+		moves[n].score = move->score;
+		++n;
+	}
+
+	return n;
+}
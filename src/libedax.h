@@ -0,0 +1,95 @@
+/**
+ * @file libedax.h
+ *
+ * Embeddable Edax engine: a reentrant C API.
+ *
+ * The library (built with `make lib`) runs the engine in-process, instead of
+ * driving it through a text protocol. Usage:
+ *   - edax_library_init() once, to load the evaluation weights & the book;
+ *   - edax_engine_new() for each independent engine, with its own tasks &
+ *     hash tables. Several engines may search at the same time;
+ *   - edax_engine_set_position(), edax_engine_set_level(), ...;
+ *   - edax_engine_search() to search synchronously, or edax_engine_start(),
+ *     then edax_engine_wait(). A callback set by edax_engine_set_callback()
+ *     receives the result of each iteration;
+ *   - edax_engine_free() & edax_library_free().
+ * An engine must be used by one thread at a time, except edax_engine_stop(),
+ * that may be called from any thread (but not from the callback).
+ *
+ * This header only uses standard C types, so that it does not depend on the
+ * engine internals.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#ifndef LIBEDAX_H
+#define LIBEDAX_H
+
+#include <stdbool.h>
+
+#if defined(_WIN32)
+	#define EDAX_API __declspec(dllexport)
+#elif defined(__GNUC__)
+	#define EDAX_API __attribute__((visibility("default")))
+#else
+	#define EDAX_API
+#endif
+
+/** version of the API, incremented at each incompatible change */
+#define EDAX_API_VERSION 1
+
+/** pass move (squares are numbered from A1 = 0 to H8 = 63) */
+#define EDAX_PASS 64
+/** no move */
+#define EDAX_NOMOVE 65
+/** maximal length of a principal variation (the length of a game, passes included) */
+#define EDAX_MAX_PV 80
+
+/** an engine */
+typedef struct EdaxEngine EdaxEngine;
+
+/** a search result */
+typedef struct EdaxResult {
+	int move;                    /**< best move: a square, EDAX_PASS or EDAX_NOMOVE */
+	int score;                   /**< best score, in discs */
+	int lower;                   /**< lower bound of the best score */
+	int upper;                   /**< upper bound of the best score */
+	int depth;                   /**< searched depth */
+	int probability;             /**< searched selectivity, as a probability in % (100 for an exact search) */
+	long long time;              /**< searched time, in ms */
+	unsigned long long n_nodes;  /**< searched node count */
+	int n_pv;                    /**< principal variation length, at most EDAX_MAX_PV */
+	int pv[EDAX_MAX_PV];         /**< principal variation */
+	bool done;                   /**< final result of the search */
+} EdaxResult;
+
+/** a move from the opening book */
+typedef struct EdaxBookMove {
+	int move;                    /**< move (a square) */
+	int score;                   /**< book score, in discs */
+} EdaxBookMove;
+
+/** result callback, called from the search thread */
+typedef void (*EdaxCallback)(const EdaxResult *result, void *data);
+
+EDAX_API int edax_api_version(void);
+EDAX_API bool edax_library_init(const char *eval_file, const char *book_file);
+EDAX_API void edax_library_free(void);
+
+EDAX_API EdaxEngine* edax_engine_new(const int n_tasks, const int hash_bits);
+EDAX_API void edax_engine_free(EdaxEngine *engine);
+EDAX_API bool edax_engine_set_position(EdaxEngine *engine, const char *board);
+EDAX_API void edax_engine_set_level(EdaxEngine *engine, const int level);
+EDAX_API void edax_engine_set_time(EdaxEngine *engine, const long long time);
+EDAX_API void edax_engine_set_callback(EdaxEngine *engine, EdaxCallback callback, void *data);
+EDAX_API bool edax_engine_search(EdaxEngine *engine, EdaxResult *result);
+EDAX_API bool edax_engine_start(EdaxEngine *engine);
+EDAX_API bool edax_engine_wait(EdaxEngine *engine, EdaxResult *result);
+EDAX_API void edax_engine_stop(EdaxEngine *engine);
+EDAX_API bool edax_engine_is_searching(const EdaxEngine *engine);
+EDAX_API int edax_engine_evaluate(EdaxEngine *engine);
+EDAX_API int edax_engine_book_moves(EdaxEngine *engine, EdaxBookMove *moves, const int n_max);
+
+#endif /* LIBEDAX_H */
@@ -8,6 +8,8 @@
  * @version 4.5
  */
 
+#include "base.h"
+#include "bench.h"
 #include "board.h"
 #include "cassio.h"
 #include "hash.h"
@@ -15,10 +17,13 @@
 #include "options.h"
 #include "perft.h"
 #include "search.h"
+#include "settings.h"
 #include "stats.h"
+#include "timemodel.h"
 #include "ui.h"
 #include "util.h"
 
+#include <ctype.h>
 #include <locale.h>
 
 /**
@@ -26,6 +31,12 @@
  */
 void version(void)
 {
+	// names indexed by MOVE_GENERATOR & LAST_FLIP_COUNTER (see settings.h)
+	static const char *flip_kernel[] = { "?", "carry_64", "kindergarten", "sse", "bitscan", "roxane", "carry_sse_32",
+		"sse_acepck", "avx_ppfill", "avx512cd", "neon", "sve_lzcnt" };
+	static const char *last_flip_kernel[] = { "?", "carry_64", "kindergarten", "sse", "bitscan", "plain", "32",
+		"bmi2", "avx_ppfill", "avx512cd", "neon", "sve_lzcnt" };
+
 	fprintf(stderr, "Edax version " VERSION_STRING " " __DATE__ " " __TIME__
 #if defined(__linux__)
 		" for Linux"
@@ -34,7 +45,12 @@ void version(void)
 #elif defined(__APPLE__)
 		" for Apple"
 #endif
-		"\ncopyright 1998 - 2018 Richard Delorme, 2014 - 25 Toshihiko Okuhara\n\n");
+#ifdef EDAX_ISA
+		" (" EDAX_ISA ", dispatched)"
+#endif
+		"\ncopyright 1998 - 2018 Richard Delorme, 2014 - 25 Toshihiko Okuhara\n");
+	fprintf(stderr, "kernels: flip %s, last flip %s, eval update " EVAL_UPDATE_ISA ", eval accumulate " EVAL_ACCUMULATE_ISA "\n\n",
+		flip_kernel[MOVE_GENERATOR], last_flip_kernel[LAST_FLIP_COUNTER]);
 }
 
 
@@ -51,12 +67,29 @@ void usage(void)
 		" -xboard xboard/winboard protocol.\n"
 		" -nboard NBoard protocol.\n"
 		" -cassio Cassio protocol.\n"
+		" -json   Batch analysis server, with JSON-lines requests & results.\n"
 		" -solve <problem_file>    Automatic problem solver/checker.\n"
 		" -wtest <wthor_file>      Test edax using WThor's theoric score.\n"
-		" -count <level>           Count positions up to <level>.\n");
+		" -eval-error <file>       Measure the 8-bit eval error on an OBF file or a game base.\n"
+		" -count <level>           Count positions up to <level>.\n"
+		" -bench-json <file>       Run the benchmark suite & save its results as JSON (- for stdout).\n"
+		" -bench-baseline <file>   Compare the benchmark suite to a JSON baseline; exit with 1 on regressions.\n"
+		" -bench-tolerance <%%>    Default regression tolerance (10%%).\n"
+		" -bench-obf <file> <n>    Solve the first n positions of an OBF file in the suite\n"
+		"                          (problem/fforum-20-39.obf 10).\n"
+		" -stop-test <file> [n [tasks [searches]]]\n"
+		"                          Stop concurrent searches (%d) sharing tasks (%d) on the first n\n"
+		"                          positions (10) of an OBF file at random; exit with 1 if a stop\n"
+		"                          takes more than %d ms, or if no stop reaches split helpers.\n",
+		STOP_TEST_SEARCHES, STOP_TEST_TASKS, STOP_LATENCY_MAX);
 	options_usage();
 }
 
+#ifdef EDAX_MAIN	// entry of one instruction set build of a dispatched executable (see dispatch.c)
+	#define	main	EDAX_MAIN
+	int main(int, char**) __attribute__((externally_visible));
+#endif
+
 /**
  * @brief edax main function.
  *
@@ -71,8 +104,19 @@ int main(int argc, char **argv)
 	int i, r, level = 0, size = 8;
 	char *problem_file = NULL;
 	char *wthor_file = NULL;
+	char *eval_error_file = NULL;
 	char *count_type = NULL;
 	int n_bench = 0;
+	char *bench_json_file = NULL;
+	char *bench_baseline_file = NULL;
+	const char *bench_obf_file = "problem/fforum-20-39.obf";
+	int bench_n_obf = 10;
+	double bench_tolerance = 10.0;
+	char *stop_test_file = NULL;
+	int stop_test_n = 10;
+	int stop_test_tasks = STOP_TEST_TASKS;
+	int stop_test_searches = STOP_TEST_SEARCHES;
+	int status = EXIT_SUCCESS;
 
 	// options.n_task default to system cpu number
 	options.n_task = get_cpu_number();
@@ -97,7 +141,21 @@ int main(int argc, char **argv)
 		else if ((r = (options_read(arg, argv[i + 1]))) > 0) i += r - 1;
 		else if (strcmp(arg, "solve") == 0 && argv[i + 1]) problem_file = argv[++i];
 		else if (strcmp(arg, "wtest") == 0 && argv[i + 1]) wthor_file = argv[++i];
+		else if (strcmp(arg, "eval-error") == 0 && argv[i + 1]) eval_error_file = argv[++i];
 		else if (strcmp(arg, "bench") == 0 && argv[i + 1]) n_bench = atoi(argv[++i]);
+		else if (strcmp(arg, "bench-json") == 0 && argv[i + 1]) bench_json_file = argv[++i];
+		else if (strcmp(arg, "bench-baseline") == 0 && argv[i + 1]) bench_baseline_file = argv[++i];
+		else if (strcmp(arg, "bench-tolerance") == 0 && argv[i + 1]) bench_tolerance = atof(argv[++i]);
+		else if (strcmp(arg, "bench-obf") == 0 && argv[i + 1] && argv[i + 2]) {
+			bench_obf_file = argv[++i];
+			bench_n_obf = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "stop-test") == 0 && argv[i + 1]) {
+			stop_test_file = argv[++i];
+			if (argv[i + 1] && isdigit((unsigned char) *argv[i + 1])) stop_test_n = atoi(argv[++i]);
+			if (argv[i + 1] && isdigit((unsigned char) *argv[i + 1])) stop_test_tasks = atoi(argv[++i]);
+			if (argv[i + 1] && isdigit((unsigned char) *argv[i + 1])) stop_test_searches = atoi(argv[++i]);
+		}
 		else if (strcmp(arg, "count") == 0 && argv[i + 1]) {
 			count_type = argv[++i];
 			if (argv[i + 1]) level = string_to_int(argv[++i], 0);
@@ -116,11 +174,46 @@ int main(int argc, char **argv)
 	bit_init();
 	edge_stability_init();
 	statistics_init();
+	if (eval_error_file) options.eval_int8 = false;	// keep the 16-bit weights to compare with
 	eval_open(options.eval_file);
 	search_global_init();
+	time_model_open(options.time_model ? options.time_model_file : NULL, options.time_model_learn);
+
+	// 8-bit eval error
+	if (eval_error_file) {
+		const size_t l = strlen(eval_error_file);
+		eval_quantize();
+		if (l > 4 && strcmp(eval_error_file + l - 4, ".obf") == 0) obf_eval_error(eval_error_file);
+		else base_eval_error(eval_error_file);
+
+	// benchmark suite
+	} else if (bench_json_file || bench_baseline_file) {
+		if (bench_suite(bench_json_file, bench_baseline_file, bench_tolerance, bench_n_obf > 0 ? bench_obf_file : NULL, bench_n_obf))
+			status = EXIT_FAILURE;
+
+	// stop latency test
+	} else if (stop_test_file) {
+		long long latency_max;
+		double latency_mean;
+		int n_stop, n_helped;
+		bool ok;
+
+		BOUND(stop_test_n, 1, 1000, "stop-test positions");
+		BOUND(stop_test_tasks, 1, MAX_THREADS - 1, "stop-test tasks");
+		BOUND(stop_test_searches, 1, MAX_THREADS - 1, "stop-test searches");
+		n_stop = obf_stop_latency(stop_test_file, stop_test_n, stop_test_tasks, stop_test_searches, &latency_max, &latency_mean, &n_helped);
+		if (n_stop == 0) {
+			fprintf(stderr, "stop test: no search stopped on %s\n", stop_test_file);
+			status = EXIT_FAILURE;
+		} else {
+			ok = (latency_max <= STOP_LATENCY_MAX && (stop_test_tasks == 1 || n_helped > 0));
+			printf("stop latency (%d random stops, %d with split helpers, %d tasks, %d concurrent searches): mean %.1f ms, max %lld ms (bound %d ms), %s\n",
+				n_stop, n_helped, stop_test_tasks, stop_test_searches, latency_mean, latency_max, STOP_LATENCY_MAX, ok ? "OK" : "FAILURE");
+			if (!ok) status = EXIT_FAILURE;
+		}
 
 	// solver & tester
-	if (problem_file || wthor_file || n_bench) {
+	} else if (problem_file || wthor_file || n_bench) {
 		Search search;
 		search_init(&search);
 		search.options.header = " depth|score|       time   |  nodes (N)  |   N/s    | principal variation";
@@ -155,10 +248,11 @@ int main(int argc, char **argv)
 
 
 	// free;
+	time_model_close();
 	eval_close();
 	options_free();
 	mm_free(ui);
 
-	return 0;
+	return status;
 }
 
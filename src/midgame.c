@@ -14,6 +14,7 @@
 #include "bit.h"
 #include "options.h"
 #include "stats.h"
+#include "trace.h"
 #include "ybwc.h"
 #include "settings.h"
 
@@ -27,26 +28,66 @@
 #endif
 
 /**
- * @brief evaluate a midgame position with the evaluation function.
+ * @brief Get the weight set of a ply.
+ *
+ * @param ply	60 - n_empties
+ * @return An index into the weight sets.
+ */
+static inline int eval_weight_ply(int ply)
+{
+	if (ply >= EVAL_N_PLY)
+		ply = EVAL_N_PLY - 2 + (ply & 1);
+	ply -= 2;
+	if (ply < 0)
+		ply &= 1;
+	return ply;
+}
+
+/**
+ * @brief evaluate a midgame position with the 16-bit evaluation weights.
  *
  * @param ply	60 - n_empties
  * @param eval	Evaluation function.
  * @return An evaluated score.
  */
-static int accumlate_eval(int ply, Eval *eval)
+static int accumlate_eval_16(int ply, Eval *eval)
 {
 	unsigned short *f = eval->feature.us;
 	const Eval_weight *w;
 	int sum;
 
-	if (ply >= EVAL_N_PLY)
-		ply = EVAL_N_PLY - 2 + (ply & 1);
-	ply -= 2;
-	if (ply < 0)
-		ply &= 1;
-	w = &(*EVAL_WEIGHT)[ply];
+	w = &(*EVAL_WEIGHT)[eval_weight_ply(ply)];
 
-#if defined(__AVX2__) && !defined(__bdver4__) && !defined(__znver1__) && !defined(__znver2__)
+#if defined(__AVX512F__)
+	enum {
+		W_C9 = offsetof(Eval_weight, C9) / sizeof(short) - 1,	// -1 to load the data into hi-word
+		W_C10 = offsetof(Eval_weight, C10) / sizeof(short) - 1,
+		W_S100 = offsetof(Eval_weight, S100) / sizeof(short) - 1,
+		W_S101 = offsetof(Eval_weight, S101) / sizeof(short) - 1,
+		W_S8 = offsetof(Eval_weight, S8x4) / sizeof(short) - 1,
+		W_S7 = offsetof(Eval_weight, S7654) / sizeof(short) - 1
+	};
+
+	// all offsets are relative to w, so that 16 features of different tables are gathered at once
+	__m512i FF = _mm512_add_epi32(_mm512_cvtepu16_epi32(eval->feature.v16[0]),
+		_mm512_set_epi32(W_S101, W_S101, W_S101, W_S101, W_S100, W_S100, W_S100, W_S100,
+			W_C10, W_C10, W_C10, W_C10, W_C9, W_C9, W_C9, W_C9));
+	__m512i DD = _mm512_i32gather_epi32(FF, w, 2);
+	__m512i SS = _mm512_srai_epi32(DD, 16);	// sign extend
+
+	FF = _mm512_add_epi32(_mm512_cvtepu16_epi32(eval->feature.v16[1]),
+		_mm512_set_epi32(W_S7, W_S7, W_S8, W_S8, W_S8, W_S8, W_S8, W_S8,
+			W_S8, W_S8, W_S8, W_S8, W_S8, W_S8, W_S8, W_S8));
+	DD = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xcfff, FF, w, 2);	// f[28..29] are added below
+	SS = _mm512_add_epi32(SS, _mm512_srai_epi32(DD, 16));
+
+	FF = _mm512_add_epi32(_mm512_cvtepu16_epi32(eval->feature.v16[2]), _mm512_set1_epi32(W_S7));
+	DD = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0x3fff, FF, w, 2);	// f[46..47] are unused
+	SS = _mm512_add_epi32(SS, _mm512_srai_epi32(DD, 16));
+
+	sum = _mm512_reduce_add_epi32(SS);
+
+#elif defined(__AVX2__) && !defined(__bdver4__) && !defined(__znver1__) && !defined(__znver2__)
 	enum {
 		W_C9 = offsetof(Eval_weight, C9) / sizeof(short) - 1,	// -1 to load the data into hi-word
 		W_C10 = offsetof(Eval_weight, C10) / sizeof(short) - 1,
@@ -96,6 +137,214 @@ static int accumlate_eval(int ply, Eval *eval)
 	return sum + w->S8x4[f[28]] + w->S8x4[f[29]] + w->S0;
 }
 
+/**
+ * @brief evaluate a midgame position with the 8-bit evaluation weights.
+ *
+ * The weights are gathered as bytes, sign extended & scaled by their table's
+ * scale factor.
+ *
+ * @param ply	60 - n_empties
+ * @param eval	Evaluation function.
+ * @return An evaluated score.
+ */
+static int accumlate_eval_8(int ply, Eval *eval)
+{
+	unsigned short *f = eval->feature.us;
+	const Eval_weight_8 *w;
+	int sum;
+
+	w = &(*EVAL_WEIGHT_8)[eval_weight_ply(ply)];
+
+#if defined(__AVX2__) && !defined(__bdver4__) && !defined(__znver1__) && !defined(__znver2__)
+	enum {
+		W_C9 = offsetof(Eval_weight_8, C9) - 3,	// -3 to load the data into hi-byte
+		W_C10 = offsetof(Eval_weight_8, C10) - 3,
+		W_S100 = offsetof(Eval_weight_8, S100) - 3,
+		W_S101 = offsetof(Eval_weight_8, S101) - 3
+	};
+
+	__m256i FF = _mm256_add_epi32(_mm256_cvtepu16_epi32(eval->feature.v8[0]),
+		_mm256_set_epi32(W_C10, W_C10, W_C10, W_C10, W_C9, W_C9, W_C9, W_C9));
+	__m256i DD = _mm256_i32gather_epi32((int *) w, FF, 1);
+	__m256i SS = _mm256_mullo_epi32(_mm256_srai_epi32(DD, 24), _mm256_loadu_si256((__m256i *) w->scale[0]));
+
+	FF = _mm256_add_epi32(_mm256_cvtepu16_epi32(eval->feature.v8[1]),
+		_mm256_set_epi32(W_S101, W_S101, W_S101, W_S101, W_S100, W_S100, W_S100, W_S100));
+	DD = _mm256_i32gather_epi32((int *) w, FF, 1);
+	SS = _mm256_add_epi32(SS, _mm256_mullo_epi32(_mm256_srai_epi32(DD, 24), _mm256_loadu_si256((__m256i *) w->scale[1])));
+
+	DD = _mm256_i32gather_epi32((int *)(w->S8x4 - 3), _mm256_cvtepu16_epi32(eval->feature.v8[2]), 1);
+	SS = _mm256_add_epi32(SS, _mm256_mullo_epi32(_mm256_srai_epi32(DD, 24), _mm256_loadu_si256((__m256i *) w->scale[2])));
+
+	DD = _mm256_i32gather_epi32((int *)(w->S7654 - 3), _mm256_cvtepu16_epi32(*(__m128i *) &f[30]), 1);
+	SS = _mm256_add_epi32(SS, _mm256_mullo_epi32(_mm256_srai_epi32(DD, 24), _mm256_loadu_si256((__m256i *) w->scale[3])));
+
+	DD = _mm256_i32gather_epi32((int *)(w->S7654 - 3), _mm256_cvtepu16_epi32(*(__m128i *) &f[38]), 1);
+	SS = _mm256_add_epi32(SS, _mm256_mullo_epi32(_mm256_srai_epi32(DD, 24), _mm256_loadu_si256((__m256i *) w->scale[4])));
+	__m128i S = _mm_add_epi32(_mm256_castsi256_si128(SS), _mm256_extracti128_si256(SS, 1));
+
+	__m128i D = _mm_i32gather_epi32((int *)(w->S8x4 - 3), _mm_cvtepu16_epi32(eval->feature.v8[3]), 1);
+	S = _mm_add_epi32(S, _mm_mullo_epi32(_mm_srai_epi32(D, 24), _mm_loadu_si128((__m128i *) w->scale[5])));
+
+	S = _mm_hadd_epi32(S, S);
+	sum = _mm_cvtsi128_si32(S) + _mm_extract_epi32(S, 1);
+
+#else
+	// no byte gather (SSE, NEON): sum each table with scalar loads, then scale it.
+	// A vector version would only pack the same scalar loads, as the 16-bit
+	// path does not vectorize either without a gather.
+	sum = w->scale[0][0] * (w->C9[f[ 0]] + w->C9[f[ 1]] + w->C9[f[ 2]] + w->C9[f[ 3]])
+	  + w->scale[0][4] * (w->C10[f[ 4]] + w->C10[f[ 5]] + w->C10[f[ 6]] + w->C10[f[ 7]])
+	  + w->scale[1][0] * (w->S100[f[ 8]] + w->S100[f[ 9]] + w->S100[f[10]] + w->S100[f[11]])
+	  + w->scale[1][4] * (w->S101[f[12]] + w->S101[f[13]] + w->S101[f[14]] + w->S101[f[15]])
+	  + w->scale[2][0] * (w->S8x4[f[16]] + w->S8x4[f[17]] + w->S8x4[f[18]] + w->S8x4[f[19]])
+	  + w->scale[2][4] * (w->S8x4[f[20]] + w->S8x4[f[21]] + w->S8x4[f[22]] + w->S8x4[f[23]])
+	  + w->scale[5][0] * (w->S8x4[f[24]] + w->S8x4[f[25]] + w->S8x4[f[26]] + w->S8x4[f[27]])
+	  + w->scale[3][0] * (w->S7654[f[30]] + w->S7654[f[31]] + w->S7654[f[32]] + w->S7654[f[33]])
+	  + w->scale[3][4] * (w->S7654[f[34]] + w->S7654[f[35]] + w->S7654[f[36]] + w->S7654[f[37]])
+	  + w->scale[4][0] * (w->S7654[f[38]] + w->S7654[f[39]] + w->S7654[f[40]] + w->S7654[f[41]])
+	  + w->scale[4][4] * (w->S7654[f[42]] + w->S7654[f[43]] + w->S7654[f[44]] + w->S7654[f[45]]);
+#endif
+	return sum + w->scale[5][4] * (w->S8x4[f[28]] + w->S8x4[f[29]]) + w->S0;
+}
+
+/**
+ * @brief evaluate a midgame position with the evaluation function.
+ *
+ * @param ply	60 - n_empties
+ * @param eval	Evaluation function.
+ * @return An evaluated score.
+ */
+static inline int accumlate_eval(int ply, Eval *eval)
+{
+	if (EVAL_WEIGHT_8) return accumlate_eval_8(ply, eval);
+	return accumlate_eval_16(ply, eval);
+}
+
+/**
+ * @brief evaluate two sibling positions with the 16-bit evaluation weights.
+ *
+ * The gathers of both positions are interleaved, so that their cache misses
+ * overlap.
+ *
+ * @param ply	60 - n_empties
+ * @param eval	Evaluation functions of both positions.
+ * @param score	Evaluated scores.
+ */
+static void accumlate_eval_16x2(int ply, Eval eval[2], int score[2])
+{
+#if defined(__AVX2__) && !defined(__bdver4__) && !defined(__znver1__) && !defined(__znver2__)
+	const Eval_weight *w = &(*EVAL_WEIGHT)[eval_weight_ply(ply)];
+	unsigned short *f0 = eval[0].feature.us;
+	unsigned short *f1 = eval[1].feature.us;
+	enum {
+		W_C9 = offsetof(Eval_weight, C9) / sizeof(short) - 1,	// -1 to load the data into hi-word
+		W_C10 = offsetof(Eval_weight, C10) / sizeof(short) - 1,
+		W_S100 = offsetof(Eval_weight, S100) / sizeof(short) - 1,
+		W_S101 = offsetof(Eval_weight, S101) / sizeof(short) - 1
+	};
+	const __m256i W01 = _mm256_set_epi32(W_C10, W_C10, W_C10, W_C10, W_C9, W_C9, W_C9, W_C9);
+	const __m256i W23 = _mm256_set_epi32(W_S101, W_S101, W_S101, W_S101, W_S100, W_S100, W_S100, W_S100);
+
+	__m256i DD0 = _mm256_i32gather_epi32((int *) w, _mm256_add_epi32(_mm256_cvtepu16_epi32(eval[0].feature.v8[0]), W01), 2);
+	__m256i DD1 = _mm256_i32gather_epi32((int *) w, _mm256_add_epi32(_mm256_cvtepu16_epi32(eval[1].feature.v8[0]), W01), 2);
+	__m256i SS0 = _mm256_srai_epi32(DD0, 16);	// sign extend
+	__m256i SS1 = _mm256_srai_epi32(DD1, 16);
+
+	DD0 = _mm256_i32gather_epi32((int *) w, _mm256_add_epi32(_mm256_cvtepu16_epi32(eval[0].feature.v8[1]), W23), 2);
+	DD1 = _mm256_i32gather_epi32((int *) w, _mm256_add_epi32(_mm256_cvtepu16_epi32(eval[1].feature.v8[1]), W23), 2);
+	SS0 = _mm256_add_epi32(SS0, _mm256_srai_epi32(DD0, 16));
+	SS1 = _mm256_add_epi32(SS1, _mm256_srai_epi32(DD1, 16));
+
+	DD0 = _mm256_i32gather_epi32((int *)((short *) w->S8x4 - 1), _mm256_cvtepu16_epi32(eval[0].feature.v8[2]), 2);
+	DD1 = _mm256_i32gather_epi32((int *)((short *) w->S8x4 - 1), _mm256_cvtepu16_epi32(eval[1].feature.v8[2]), 2);
+	SS0 = _mm256_add_epi32(SS0, _mm256_srai_epi32(DD0, 16));
+	SS1 = _mm256_add_epi32(SS1, _mm256_srai_epi32(DD1, 16));
+
+	DD0 = _mm256_i32gather_epi32((int *)((short *) w->S7654 - 1), _mm256_cvtepu16_epi32(*(__m128i *) &f0[30]), 2);
+	DD1 = _mm256_i32gather_epi32((int *)((short *) w->S7654 - 1), _mm256_cvtepu16_epi32(*(__m128i *) &f1[30]), 2);
+	SS0 = _mm256_add_epi32(SS0, _mm256_srai_epi32(DD0, 16));
+	SS1 = _mm256_add_epi32(SS1, _mm256_srai_epi32(DD1, 16));
+
+	DD0 = _mm256_i32gather_epi32((int *)((short *) w->S7654 - 1), _mm256_cvtepu16_epi32(*(__m128i *) &f0[38]), 2);
+	DD1 = _mm256_i32gather_epi32((int *)((short *) w->S7654 - 1), _mm256_cvtepu16_epi32(*(__m128i *) &f1[38]), 2);
+	SS0 = _mm256_add_epi32(SS0, _mm256_srai_epi32(DD0, 16));
+	SS1 = _mm256_add_epi32(SS1, _mm256_srai_epi32(DD1, 16));
+
+	// f[24..27] of both positions
+	DD0 = _mm256_i32gather_epi32((int *)((short *) w->S8x4 - 1), _mm256_cvtepu16_epi32(_mm_unpacklo_epi64(eval[0].feature.v8[3], eval[1].feature.v8[3])), 2);
+	DD0 = _mm256_srai_epi32(DD0, 16);
+
+	// lanes 0-3: 1st position, lanes 4-7: 2nd position
+	SS0 = _mm256_add_epi32(_mm256_permute2x128_si256(SS0, SS1, 0x20), _mm256_permute2x128_si256(SS0, SS1, 0x31));
+	SS0 = _mm256_add_epi32(SS0, DD0);
+	SS0 = _mm256_hadd_epi32(SS0, SS0);
+	SS0 = _mm256_hadd_epi32(SS0, SS0);
+
+	score[0] = _mm_cvtsi128_si32(_mm256_castsi256_si128(SS0)) + w->S8x4[f0[28]] + w->S8x4[f0[29]] + w->S0;
+	score[1] = _mm256_extract_epi32(SS0, 4) + w->S8x4[f1[28]] + w->S8x4[f1[29]] + w->S0;
+
+#else
+	score[0] = accumlate_eval_16(ply, &eval[0]);
+	score[1] = accumlate_eval_16(ply, &eval[1]);
+#endif
+}
+
+/**
+ * @brief evaluate two sibling positions with the evaluation function.
+ *
+ * @param ply	60 - n_empties
+ * @param eval	Evaluation functions of both positions.
+ * @param score	Evaluated scores.
+ */
+static inline void accumlate_eval_x2(int ply, Eval eval[2], int score[2])
+{
+	if (EVAL_WEIGHT_8) {
+		score[0] = accumlate_eval_8(ply, &eval[0]);
+		score[1] = accumlate_eval_8(ply, &eval[1]);
+	} else accumlate_eval_16x2(ply, eval, score);
+}
+
+/**
+ * @brief Compare the 8-bit evaluation of a position to the 16-bit one.
+ *
+ * Both weight sets must be loaded (see eval_quantize()).
+ *
+ * @param error Error statistics to update.
+ * @param board Position to evaluate.
+ */
+void eval_error_add(EvalError *error, const Board *board)
+{
+	Eval eval;
+	int ply;
+	double e;
+
+	eval.n_empties = bit_count(~(board->player | board->opponent));
+	eval_set(&eval, board);
+	ply = 60 - eval.n_empties;
+
+	e = abs(accumlate_eval_8(ply, &eval) - accumlate_eval_16(ply, &eval)) / 128.0;
+	++error->n;
+	error->sum += e;
+	error->sum2 += e * e;
+	if (e > error->max) error->max = e;
+}
+
+/**
+ * @brief Print the deviation of the 8-bit evaluation.
+ *
+ * @param error Error statistics.
+ * @param file Tested file.
+ * @param f Output stream.
+ */
+void eval_error_print(const EvalError *error, const char *file, FILE *f)
+{
+	const double n = error->n ? (double) error->n : 1.0;
+
+	fprintf(f, "%.30s: %llu positions; 8-bit eval error (in discs): mean absolute = %.3f; rms = %.3f; max = %.2f\n",
+		file, error->n, error->sum / n, sqrt(error->sum2 / n), error->max);
+}
+
 /**
  * @brief evaluate a midgame position with the evaluation function.
  *
@@ -121,65 +370,127 @@ int search_eval_0(Search *search)
 }
 
 /**
- * @brief Evaluate a position at depth 1. (min stage)
+ * @brief Evaluate the children of a position at depth 1. (min stage)
  *
- * As an optimization, the last move is used to only updates the evaluation
- * features.
+ * With eval_batch, the children are evaluated by pairs, but scanned in
+ * order, so that the tree, the node count & the score are the same as
+ * when they are evaluated one by one: a second child is ignored once the
+ * first one reaches the cut.
  *
  * @param search Position to evaluate.
  * @param alpha Alpha bound.
- * @param beta Beta bound.
- * @param moves Next turn legal moves.
+ * @param moves Next turn legal moves (not empty).
+ * @param first Score (x 128) of the first child, if already evaluated, or NULL.
  * @return An evaluated min score.
  */
-int search_eval_1(Search *search, int alpha, int beta, unsigned long long moves)
+static int search_eval_1_children(Search *search, int alpha, unsigned long long moves, const int *first)
 {
-	int x, score, bestscore, alphathres;
+	int x, y, score[2], bestscore, alphathres;
+	const int ply = 60 - search->eval.n_empties + 1;
 	unsigned long long flipped;
-	Eval Ev;
+	Eval Ev[2];
 	V2DI board0;
 
-	SEARCH_STATS(++statistics.n_search_eval_1);
-	SEARCH_UPDATE_INTERNAL_NODES(search->n_nodes);
+	bestscore = SCORE_INF * 128;	// min stage
+	if (alpha < SCORE_MIN + 1) alphathres = ((SCORE_MIN + 1) * 128) + 64;
+	else alphathres = (alpha * 128) + 63 + (int) (alpha < 0);	// highest score rounded to alpha
 
-	if (moves) {
-		bestscore = SCORE_INF * 128;	// min stage
-		if (alpha < SCORE_MIN + 1) alphathres = ((SCORE_MIN + 1) * 128) + 64;
-		else alphathres = (alpha * 128) + 63 + (int) (alpha < 0);	// highest score rounded to alpha
+	board0.board = search->board;
+	x = NOMOVE;
+	if (first) {	// already evaluated by search_eval_2
+		do {
+			x = search->empties[x].next;
+		} while (!(moves & x_to_bit(x)));
 
-		board0.board = search->board;
-		x = NOMOVE;
+		moves &= ~x_to_bit(x);
+		SEARCH_UPDATE_EVAL_NODES(search->n_nodes);
+		bestscore = *first;
+	}
+
+	while (moves && (bestscore > alphathres)) {
 		do {
+			x = search->empties[x].next;
+		} while (!(moves & x_to_bit(x)));
+
+		moves &= ~x_to_bit(x);
+		flipped = vboard_flip(board0, x);
+		if (flipped == search->board.opponent)
+			return SCORE_MIN;	// wipeout
+
+		eval_update_leaf(x, flipped, &Ev[0], &search->eval);
+		SEARCH_UPDATE_EVAL_NODES(search->n_nodes);
+
+		if (options.eval_batch && moves) {	// pair it with the next child
+			y = x;
 			do {
-				x = search->empties[x].next;
-			} while (!(moves & x_to_bit(x)));
+				y = search->empties[y].next;
+			} while (!(moves & x_to_bit(y)));
+
+			flipped = vboard_flip(board0, y);
+			if (flipped != search->board.opponent) {
+				eval_update_leaf(y, flipped, &Ev[1], &search->eval);
+				accumlate_eval_x2(ply, Ev, score);
+				if (score[0] < bestscore)
+					bestscore = score[0];
+				if (bestscore <= alphathres)
+					break;	// the next child is not searched
+
+				x = y;
+				moves &= ~x_to_bit(x);
+				SEARCH_UPDATE_EVAL_NODES(search->n_nodes);
+				score[0] = score[1];
+			} else {	// wipeout by the next child, unless this one cuts
+				score[0] = accumlate_eval(ply, &Ev[0]);
+				if (score[0] < bestscore)
+					bestscore = score[0];
+				if (bestscore <= alphathres)
+					break;
+				return SCORE_MIN;
+			}
+		} else	score[0] = accumlate_eval(ply, &Ev[0]);
 
-			moves &= ~x_to_bit(x);
-			flipped = vboard_flip(board0, x);
-			if (flipped == search->board.opponent)
-				return SCORE_MIN;	// wipeout
+		if (score[0] < bestscore)
+			bestscore = score[0];
+	}
 
-			eval_update_leaf(x, flipped, &Ev, &search->eval);
-			SEARCH_UPDATE_EVAL_NODES(search->n_nodes);
+	if (bestscore >= 0) bestscore += 64; else bestscore -= 64;
+	bestscore /= 128;
 
-			score = accumlate_eval(60 - search->eval.n_empties + 1, &Ev);
+	if (bestscore < SCORE_MIN + 1) bestscore = SCORE_MIN + 1;
+	if (bestscore > SCORE_MAX - 1) bestscore = SCORE_MAX - 1;
 
-			if (score < bestscore)
-				bestscore = score;
-		} while (moves && (bestscore > alphathres));
+	return bestscore;
+}
 
-		if (bestscore >= 0) bestscore += 64; else bestscore -= 64;
-		bestscore /= 128;
+/**
+ * @brief Evaluate a position at depth 1. (min stage)
+ *
+ * As an optimization, the last move is used to only updates the evaluation
+ * features.
+ *
+ * @param search Position to evaluate.
+ * @param alpha Alpha bound.
+ * @param beta Beta bound.
+ * @param moves Next turn legal moves.
+ * @return An evaluated min score.
+ */
+int search_eval_1(Search *search, int alpha, int beta, unsigned long long moves)
+{
+	int bestscore;
+	Eval eval0;
 
-		if (bestscore < SCORE_MIN + 1) bestscore = SCORE_MIN + 1;
-		if (bestscore > SCORE_MAX - 1) bestscore = SCORE_MAX - 1;
+	SEARCH_STATS(++statistics.n_search_eval_1);
+	SEARCH_UPDATE_INTERNAL_NODES(search->n_nodes);
+
+	if (moves) {
+		bestscore = search_eval_1_children(search, alpha, moves, NULL);
 
 	} else {
 		moves = get_moves(search->board.opponent, search->board.player);
 		if (moves) {
-			search_update_pass_midgame(search, &Ev);
+			search_update_pass_midgame(search, &eval0);
 			bestscore = -search_eval_1(search, -beta, -alpha, moves);
-			search_restore_pass_midgame(search, &Ev);
+			search_restore_pass_midgame(search, &eval0);
 		} else { // game over
 			bestscore = -search_solve(search);
 		}
@@ -189,11 +500,63 @@ int search_eval_1(Search *search, int alpha, int beta, unsigned long long moves)
 	return bestscore;
 }
 
+/**
+ * @brief Evaluate a position at depth 1, whose first child is already evaluated.
+ *
+ * @param search Position to evaluate.
+ * @param alpha Alpha bound.
+ * @param moves Next turn legal moves (not empty).
+ * @param first Score (x 128) of the first child.
+ * @return An evaluated min score.
+ */
+static int search_eval_1_from_first(Search *search, int alpha, unsigned long long moves, const int *first)
+{
+	SEARCH_STATS(++statistics.n_search_eval_1);
+	SEARCH_UPDATE_INTERNAL_NODES(search->n_nodes);
+
+	return search_eval_1_children(search, alpha, moves, first);
+}
+
+/**
+ * @brief Get the first child of a position at depth 1, ready to be evaluated.
+ *
+ * @param search Search (for its empty square list).
+ * @param board Position.
+ * @param eval Evaluation function of the position.
+ * @param moves Legal moves of the position.
+ * @param child Evaluation function of the first child (output).
+ * @return false if there is no move, or if the first move wipes the opponent out.
+ */
+static bool search_eval_1_first_child(const Search *search, const Board *board, const Eval *eval, const unsigned long long moves, Eval *child)
+{
+	int x = NOMOVE;
+	unsigned long long flipped;
+	V2DI board0;
+
+	if (moves == 0) return false;
+
+	do {
+		x = search->empties[x].next;
+	} while (!(moves & x_to_bit(x)));
+
+	board0.board = *board;
+	flipped = vboard_flip(board0, x);	// as search_eval_1_children does
+	if (flipped == board->opponent) return false;
+
+	eval_update_leaf(x, flipped, child, eval);
+	return true;
+}
+
 /**
  * @brief Evaluate a position at depth 2.
  *
  * Simple alpha-beta with no move sorting.
  *
+ * With eval_batch, the children are searched by pairs of siblings: the first
+ * child of both siblings is evaluated together before the first sibling is
+ * searched. The first child of a searched position is always evaluated, so
+ * only the evaluation of the second sibling's child is lost on a cut.
+ *
  * @param search Position to evaluate.
  * @param alpha Lower bound
  * @param beta  Upper bound
@@ -202,9 +565,13 @@ int search_eval_1(Search *search, int alpha, int beta, unsigned long long moves)
  */
 int search_eval_2(Search *search, int alpha, int beta, unsigned long long moves)
 {
-	int x, bestscore, score;
-	unsigned long long flipped;
-	Eval eval0;
+	int x, y, bestscore, score, first[2];
+	unsigned long long flipped, child_moves;
+	Eval eval0, sibling, Ev[2];
+	Board sibling_board;
+	unsigned long long sibling_moves = 0;
+	const int *sibling_first = NULL;
+	bool has_sibling = false;
 	V2DI board0;
 
 	SEARCH_STATS(++statistics.n_search_eval_2);
@@ -227,9 +594,43 @@ int search_eval_2(Search *search, int alpha, int beta, unsigned long long moves)
 
 			moves &= ~x_to_bit(x);
 			// search->empties[prev].next = search->empties[x].next;	// let search_eval_1 skip the last occupied
-			flipped = vboard_next(board0, x, &search->board);
-			eval_update_leaf(x, flipped, &search->eval, &eval0);
-			score = search_eval_1(search, alpha, beta, board_get_moves(&search->board));
+
+			if (has_sibling) {	// prepared with the previous move
+				search->board = sibling_board;
+				search->eval.feature = sibling.feature;
+				if (sibling_first) score = search_eval_1_from_first(search, alpha, sibling_moves, sibling_first);
+				else score = search_eval_1(search, alpha, beta, sibling_moves);
+				has_sibling = false;
+
+			} else {
+				flipped = vboard_next(board0, x, &search->board);
+				eval_update_leaf(x, flipped, &search->eval, &eval0);
+				child_moves = board_get_moves(&search->board);
+
+				if (options.eval_batch && moves && search_eval_1_first_child(search, &search->board, &search->eval, child_moves, &Ev[0])) {
+					// prepare the next move & evaluate the first child of both
+					y = x;
+					do {
+						y = search->empties[y].next;
+					} while (!(moves & x_to_bit(y)));
+
+					flipped = vboard_next(board0, y, &sibling_board);
+					eval_update_leaf(y, flipped, &sibling, &eval0);
+					sibling.n_empties = search->eval.n_empties;
+					sibling_moves = board_get_moves(&sibling_board);
+					has_sibling = true;
+
+					if (search_eval_1_first_child(search, &sibling_board, &sibling, sibling_moves, &Ev[1])) {
+						accumlate_eval_x2(60 - search->eval.n_empties + 1, Ev, first);
+						sibling_first = first + 1;
+					} else {
+						first[0] = accumlate_eval(60 - search->eval.n_empties + 1, &Ev[0]);
+						sibling_first = NULL;
+					}
+					score = search_eval_1_from_first(search, alpha, child_moves, first);
+
+				} else score = search_eval_1(search, alpha, beta, child_moves);
+			}
 			// search->empties[prev].next = x;	// restore
 
 			if (score > bestscore) {
@@ -612,9 +1013,13 @@ int NWS_midgame(Search *search, const int alpha, int depth, Node *parent)
 
 	SEARCH_STATS(++statistics.n_NWS_midgame);
 	SEARCH_UPDATE_INTERNAL_NODES(search->n_nodes);
+	trace_node(search->trace, TRACE_ENTER, TRACE_NWS, depth, alpha, alpha + 1, 0, 0);
 
 	// stability cutoff
-	if (search_SC_NWS(search, alpha, &score)) return score;
+	if (search_SC_NWS(search, alpha, &score)) {
+		trace_node(search->trace, TRACE_EXIT, TRACE_SC, depth, alpha, alpha + 1, score, 0);
+		return score;
+	}
 
 	hash_code = board_get_hash_code(&search->board);
 	hash_prefetch(&search->hash_table, hash_code);
@@ -625,7 +1030,10 @@ int NWS_midgame(Search *search, const int alpha, int depth, Node *parent)
 
 	// transposition cutoff
 	if (hash_get(&search->hash_table, &search->board, hash_code, &hash_data.data) || hash_get(&search->pv_table, &search->board, hash_code, &hash_data.data))
-		if (search_TC_NWS(&hash_data.data, depth, search->selectivity, alpha, &score)) return score;
+		if (search_TC_NWS(&hash_data.data, depth, search->selectivity, alpha, &score)) {
+			trace_node(search->trace, TRACE_EXIT, TRACE_TC, depth, alpha, alpha + 1, score, 0);
+			return score;
+		}
 
 	if (movelist_is_empty(&movelist)) { // no moves ?
 		node_init(&node, search, alpha, alpha + 1, depth, movelist.n_moves, parent);
@@ -639,7 +1047,10 @@ int NWS_midgame(Search *search, const int alpha, int depth, Node *parent)
 
 	} else {
 		// probcut
-		if (search_probcut(search, alpha, depth, parent, &score)) return score;
+		if (search_probcut(search, alpha, depth, parent, &score)) {
+			trace_node(search->trace, TRACE_EXIT, TRACE_PROBCUT, depth, alpha, alpha + 1, score, 0);
+			return score;
+		}
 
 		// sort the list of moves
 		if (movelist.n_moves > 1) {
@@ -649,7 +1060,10 @@ int NWS_midgame(Search *search, const int alpha, int depth, Node *parent)
 		}
 
 		// ETC
-		if (search_ETC_NWS(search, &movelist, hash_code, depth, search->selectivity, alpha, &score)) return score;
+		if (search_ETC_NWS(search, &movelist, hash_code, depth, search->selectivity, alpha, &score)) {
+			trace_node(search->trace, TRACE_EXIT, TRACE_ETC, depth, alpha, alpha + 1, score, 0);
+			return score;
+		}
 
 		node_init(&node, search, alpha, alpha + 1, depth, movelist.n_moves, parent);
 
@@ -693,6 +1107,8 @@ int NWS_midgame(Search *search, const int alpha, int depth, Node *parent)
 		node.bestscore = alpha;
 	}
 
+	trace_node(search->trace, TRACE_EXIT, search->stop ? TRACE_STOP : (node.bestscore > alpha ? TRACE_CUT : TRACE_ALL),
+		depth, alpha, alpha + 1, node.bestscore, movelist.n_moves ? node.n_moves_done + 1 : 0);
 	node_free(&node);
 
 	return node.bestscore;
@@ -747,6 +1163,7 @@ int PVS_midgame(Search *search, const int alpha, const int beta, int depth, Node
 
 	nodes_org = search_count_nodes(search);
 	SEARCH_UPDATE_INTERNAL_NODES(search->n_nodes);
+	trace_node(search->trace, TRACE_ENTER, TRACE_PVS, depth, alpha, beta, 0, 0);
 
 	search_get_movelist(search, &movelist);
 	node_init(&node, search, alpha, beta, depth, movelist.n_moves, parent);
@@ -860,6 +1277,8 @@ int PVS_midgame(Search *search, const int alpha, const int beta, int depth, Node
 		node.bestscore = alpha;
 	}
 
+	trace_node(search->trace, TRACE_EXIT, search->stop ? TRACE_STOP : (node.bestscore >= beta ? TRACE_CUT : (node.bestscore <= alpha ? TRACE_ALL : TRACE_PV)),
+		depth, alpha, beta, node.bestscore, movelist.n_moves ? node.n_moves_done + 1 : 0);
 	node_free(&node);
 
 	return node.bestscore;
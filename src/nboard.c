@@ -65,11 +65,20 @@ static void nboard_send_move(Result *result)
 
 static void nboard_observer(Result *result)
 {
+	int i;
+
 	if (log_is_open(nboard_log)) {
 		fprintf(nboard_log->f, "edax> ");
 		result_print(result, nboard_log->f);
 		putc('\n', nboard_log->f);
 	}
+	// stream the multi-PV lines of a hint
+	spin_lock(result);
+	for (i = 0; i < result->n_lines; ++i) {
+		printf("search "); line_print(&result->line[i].pv, 10, NULL, stdout);
+		printf(" %d 0 %d\n", result->line[i].score, result->depth);
+	}
+	spin_unlock(result);
 	nboard_send("nodestats %lld %.2f", result->n_nodes, result->time);
 }
 
@@ -19,6 +19,8 @@
  * @version 4.4
  */
 #include "search.h"
+#include "histogram.h"
+#include "pool.h"
 #include "options.h"
 #include "const.h"
 #include "settings.h"
@@ -305,6 +307,7 @@ void obf_test(Search *search, const char *obf_file, const char *wrong_file)
 	search_set_observer(search, search_observer);
 	search->options.verbosity = (options.verbosity == 1 ? 0 : options.verbosity);
 	options.width -= 4;
+	search_recorder_start(&search_recorder);
 
 	// open script file with problems
 	f = fopen(obf_file, "r");
@@ -360,6 +363,8 @@ void obf_test(Search *search, const char *obf_file, const char *wrong_file)
 		printf("mean absolute score error = %.3f; ", score_error / n);
 		printf("mean absolute move error = %.3f\n", move_error / n);
 	}
+	search_recorder_print(&search_recorder, stdout);
+	search_recorder_stop(&search_recorder);
 
 	options.width += 4;
 
@@ -523,3 +528,199 @@ void obf_speed(Search *search, const int n)
 	options.width += 4;
 	
 }
+
+/**
+ * @brief Solve the first positions of an OBF file, silently.
+ *
+ * @param search Search.
+ * @param obf_file OBF file.
+ * @param n Number of positions to solve.
+ * @param time Solving time in ms (output).
+ * @param n_nodes Node count (output).
+ * @return false if the file cannot be read.
+ */
+bool obf_bench(Search *search, const char *obf_file, const int n, unsigned long long *time, unsigned long long *n_nodes)
+{
+	FILE *f;
+	OBF obf;
+	int i = 0, ok;
+	const int verbosity = options.verbosity;
+
+	*time = *n_nodes = 0;
+	f = fopen(obf_file, "r");
+	if (f == NULL) return false;
+
+	search_set_observer(search, search_observer);
+	search->options.verbosity = options.verbosity = 0;
+	while (i < n && (ok = obf_read(&obf, f)) != OBF_PARSE_END) {
+		if (ok == OBF_PARSE_OK) {
+			obf_search(search, &obf, ++i);
+			*time += search_time(search);
+			*n_nodes += search_count_nodes(search);
+		}
+		obf_free(&obf);
+	}
+	options.verbosity = verbosity;
+
+	fclose(f);
+	return i > 0;
+}
+
+/**
+ * @brief Count the split slaves working for a search.
+ *
+ * @param search Search.
+ * @return the number of slaves of the search & of its slaves.
+ */
+static int obf_count_slaves(Search *search)
+{
+	int i, n;
+
+	spin_lock(search);
+		n = search->n_child;
+		for (i = 0; i < search->n_child; ++i) n += obf_count_slaves(search->child[i]);
+	spin_unlock(search);
+
+	return n;
+}
+
+/**
+ * @brief Measure the stop latency of asynchronous searches on an OBF file.
+ *
+ * A pool of n_searches concurrent searches shares n_tasks tasks (even more
+ * than the host cpus), so that the stopped searches are loaded & split among
+ * helper tasks. Each of the first positions is solved several times by all
+ * the searches at once (each one on its own position); after a random delay,
+ * the searches are stopped one by one, in a random order, while the others
+ * are still running. The latency is the time between the stop request & the
+ * end of the search, i.e. the return of search_join(). A stop is counted as
+ * going through helpers if the search had split slaves when it was stopped.
+ *
+ * @param obf_file OBF file.
+ * @param n Number of positions to solve.
+ * @param n_tasks Number of tasks.
+ * @param n_searches Number of concurrent searches.
+ * @param latency_max Maximal latency in ms (output).
+ * @param latency_mean Mean latency in ms (output).
+ * @param n_helped Number of stops of searches with split slaves (output).
+ * @return the number of stopped searches, 0 if the file cannot be read.
+ */
+int obf_stop_latency(const char *obf_file, const int n, const int n_tasks, const int n_searches, long long *latency_max, double *latency_mean, int *n_helped)
+{
+	FILE *f;
+	OBF obf, *position;
+	SearchPool pool;
+	Search *search;
+	Random r;
+	int i, j, k, k_swap, tmp, ok, n_position = 0, n_stop = 0, order[MAX_THREADS];
+	long long t, latency, sum = 0;
+	bool has_slaves;
+	const int N_STOP = 4;
+
+	*latency_max = 0;
+	*latency_mean = 0.0;
+	*n_helped = 0;
+	f = fopen(obf_file, "r");
+	if (f == NULL) return 0;
+	position = (OBF*) malloc(n * sizeof (OBF));
+	if (position == NULL) fatal_error("Cannot allocate %d positions\n", n);
+	while (n_position < n && (ok = obf_read(&obf, f)) != OBF_PARSE_END) {
+		if (ok == OBF_PARSE_OK) position[n_position++] = obf;
+		else obf_free(&obf);
+	}
+	fclose(f);
+	if (n_position == 0) {
+		free(position);
+		return 0;
+	}
+
+	search_pool_init(&pool, n_searches, false);
+	search_set_task_number(&pool.master, n_tasks);
+	for (j = 0; j < n_searches; ++j) pool.search[j].options.verbosity = 0;
+
+	random_seed(&r, 42);
+	for (i = 0; i < n_position; ++i)
+	for (k = 0; k < N_STOP; ++k) {
+		for (j = 0; j < n_searches; ++j) {
+			search = pool.search + j;
+			search_pool_start(&pool, search);
+			search_set_board(search, &position[(i + j) % n_position].board, position[(i + j) % n_position].player);
+			search_set_level(search, 60, search->eval.n_empties);
+			search_set_game_time(search, TIME_MAX);
+			search_start(search);
+			order[j] = j;
+		}
+		for (j = n_searches - 1; j > 0; --j) {
+			k_swap = random_get(&r) % (j + 1);
+			tmp = order[j]; order[j] = order[k_swap]; order[k_swap] = tmp;
+		}
+
+		relax(1 + random_get(&r) % 200);
+		for (j = 0; j < n_searches; ++j) {
+			search = pool.search + order[j];
+			if (search_is_running(search)) {
+				has_slaves = (obf_count_slaves(search) > 0);
+				t = real_clock();
+				search_stop(search, STOP_ON_DEMAND);
+				search_join(search);
+				latency = real_clock() - t;
+				sum += latency;
+				if (latency > *latency_max) *latency_max = latency;
+				++n_stop;
+				*n_helped += has_slaves;
+			} else {
+				search_join(search);
+			}
+			search_pool_end(&pool, search);
+			relax(random_get(&r) % 20);	// let the other searches run
+		}
+	}
+	if (n_stop) *latency_mean = (double) sum / n_stop;
+
+	search_pool_free(&pool);
+	for (i = 0; i < n_position; ++i) obf_free(position + i);
+	free(position);
+
+	return n_stop;
+}
+
+/**
+ * @brief Measure the error of the 8-bit evaluation on an OBF file.
+ *
+ * Each position & each of its children are evaluated with both weight sets.
+ *
+ * @param obf_file OBF file.
+ */
+void obf_eval_error(const char *obf_file)
+{
+	FILE *f;
+	OBF obf;
+	EvalError error = {0, 0.0, 0.0, 0.0};
+	Board board;
+	Move move;
+	unsigned long long moves;
+	int x, ok;
+
+	f = fopen(obf_file, "r");
+	if (f == NULL) {
+		fprintf(stderr, "obf_eval_error: cannot open Othello Position Description's file %s\n", obf_file);
+		exit(EXIT_FAILURE);
+	}
+
+	while ((ok = obf_read(&obf, f)) != OBF_PARSE_END) {
+		if (ok == OBF_PARSE_OK) {
+			eval_error_add(&error, &obf.board);
+			moves = get_moves(obf.board.player, obf.board.opponent);
+			foreach_bit(x, moves) {
+				board = obf.board;
+				board_get_move_flip(&board, x, &move);
+				board_update(&board, &move);
+				eval_error_add(&error, &board);
+			}
+		}
+		obf_free(&obf);
+	}
+	eval_error_print(&error, obf_file, stdout);
+
+	fclose(f);
+}
@@ -12,12 +12,17 @@
 #define EDAX_OPDTEST_H
 
 
+#include <stdbool.h>
+
 struct Search;
 
 void obf_test(struct Search*, const char*, const char*);
 void script_to_obf(struct Search*, const char*, const char*);
 void obf_filter(const char*, const char *);
 void obf_speed(struct Search*, const int);
+bool obf_bench(struct Search*, const char*, const int, unsigned long long*, unsigned long long*);
+int obf_stop_latency(const char*, const int, const int, const int, long long*, double*, int*);
+void obf_eval_error(const char*);
 
 #endif /* EDAX_OPDTEST_H */
 
@@ -12,6 +12,7 @@
 #include "stats.h"
 #include "util.h"
 #include "search.h"
+#include "settings.h"
 
 #include <string.h>
 #include <ctype.h>
@@ -26,6 +27,8 @@ Options options = {
 
 	1, // n_task (will be set to system available cpus at run-time)
 	false, // cpu_affinity
+	1, // n_search (batch jobs)
+	false, // partition_hash
 
 	1, // verbosity
 	0, // noise
@@ -39,6 +42,7 @@ Options options = {
 	TIME_MAX, // infinite time
 	EDAX_FIXED_LEVEL, // play-type
 	true, // can ponder
+	1, // ponder candidates
 	-1, // depth
 	-1, // selectivity
 
@@ -46,6 +50,9 @@ Options options = {
 
 	10000000,  // speed (default = 10e6)
 	0,         // nps (default = 0)
+	true,      // learned time model
+	false,     // time model learning
+	NULL,      // learned time model file
 
 	SCORE_MIN, // alpha
 	SCORE_MAX, // beta
@@ -53,10 +60,14 @@ Options options = {
 	false, // all_best
 
 	NULL, // evaluation function's weights file.
+	false, // 8-bit evaluation weights
+	true, // evaluation weights cache
+	false, // batched leaf evaluation
 
 	NULL, // book file
 	true,            // book usage allowed
 	0,               // book randomness
+	300,             // book checkpoint period
 
 	NULL, // ggs host name
 	NULL, // ggs login name
@@ -72,6 +83,7 @@ Options options = {
 	NULL, // game file.
 
 	NULL, // search log file.
+	NULL, // trace file.
 	NULL, // ui log file.
 	NULL, // ggs log file.
 
@@ -102,6 +114,8 @@ void options_usage(void)
 		"  -h|hash-table-size <nbits>    hash table size.\n"
 		"  -n|n-tasks <n>                search in parallel using n tasks.\n"
 		"  -cpu                          search using 1 cpu/thread.\n"
+		"  -batch-searches <n>           run batch jobs (base check, wtest, json...) with n searches.\n"
+		"  -partition-hash <on/off>      give each search of a pool (json) its own hash table.\n"
 #ifdef __APPLE__
 		"\nCassio protocol options:\n"
 		"  -debug-cassio                 print extra-information in cassio.\n"
@@ -112,15 +126,24 @@ void options_usage(void)
 		"  -t|game-time <n>              search using limited time per game.\n"
 		"  -move-time <n>                search using limited time per move.\n"
 		"  -ponder <on/off>              search during opponent time.\n"
+		"  -ponder-candidates <n>        ponder on the n most likely opponent replies at once.\n"
+		"  -time-model <on/off>          use the search speed learned on this host (for game-time play).\n"
+		"  -time-model-learn <on/off>    learn the search speed from the searches & save it on exit.\n"
+		"  -time-model-file <file>       read & save the learned search speed in this file.\n"
 		"  -eval-file                    read eval weight from this file.\n"
+		"  -eval-int8 <on/off>           use 8-bit quantized eval weights (smaller & less accurate).\n"
+		"  -eval-cache <on/off>          map unpacked eval weights from a cache file (eval file + .bin).\n"
+		"  -eval-batch <on/off>          evaluate sibling leaves by pairs.\n"
 		"  -book-file                    load opening book from this file.\n"
 		"  -book-usage <on/off>          play from the opening book.\n"
 		"  -book-randomness <n>          play various but worse moves from the opening book.\n"
+		"  -book-checkpoint <seconds>    time between two checkpoints of a long book job.\n"
 		"  -auto-start <on/off>          automatically restart a new game.\n"
 		"  -auto-swap <on/off>           automatically Edax's color between games\n"
 		"  -auto-store <on/off>          automatically save played games\n"
 		"  -game-file <file>             file to store all played game/s.\n"
 		"  -search-log-file <file>       file to store search detailed output/s.\n"
+		"  -trace-file <file>            file to store a binary trace of the search tree.\n"
 		"  -ui-log-file <file>           file to store input/output to the (U)ser (I)nterface.\n");
 
 	exit(EXIT_SUCCESS);
@@ -159,6 +182,8 @@ int options_read(const char *option, const char *value)
 
 		else if (strcmp(option, "h") == 0  || strcmp(option, "hash-table-size") == 0) options.hash_table_size = string_to_int(value, options.hash_table_size);
 		else if (strcmp(option, "n") == 0 || strcmp(option, "n-tasks") == 0) options.n_task = string_to_int(value, options.n_task);
+		else if (strcmp(option, "batch-searches") == 0) options.n_search = string_to_int(value, options.n_search);
+		else if (strcmp(option, "partition-hash") == 0) parse_boolean(value, &options.partition_hash);
 		else if (strcmp(option, "l") == 0 || strcmp(option, "level") == 0) {
 			options.level = string_to_int(value, options.level);
 			options.play_type = EDAX_FIXED_LEVEL;
@@ -182,6 +207,7 @@ int options_read(const char *option, const char *value)
 		else if (strcmp(option, "speed") == 0) options.speed = string_to_real(value, options.speed);
 		else if (strcmp(option, "nps") == 0) options.nps = 0.001 * string_to_real(value, options.nps);
 		else if (strcmp(option, "ponder") == 0) parse_boolean(value, &options.can_ponder);
+		else if (strcmp(option, "ponder-candidates") == 0) parse_int(value, &options.ponder_candidates);
 		else if (strcmp(option, "mode") == 0) parse_int(value, &options.mode);
 
 		else if (strcmp(option, "inc-pvnode-sort-depth") == 0) options.inc_sort_depth[PV_NODE] = string_to_int(value, options.inc_sort_depth[PV_NODE]);
@@ -202,13 +228,22 @@ int options_read(const char *option, const char *value)
 
 		else if (strcmp(option, "game-file") == 0) options.game_file = string_duplicate(value);
 
+		else if (strcmp(option, "time-model") == 0) parse_boolean(value, &options.time_model);
+		else if (strcmp(option, "time-model-learn") == 0) parse_boolean(value, &options.time_model_learn);
+		else if (strcmp(option, "time-model-file") == 0) options.time_model_file = string_duplicate(value);
+
 		else if (strcmp(option, "eval-file") == 0) options.eval_file = string_duplicate(value);	// 11/13/2015
+		else if (strcmp(option, "eval-int8") == 0) parse_boolean(value, &options.eval_int8);
+		else if (strcmp(option, "eval-cache") == 0) parse_boolean(value, &options.eval_cache);
+		else if (strcmp(option, "eval-batch") == 0) parse_boolean(value, &options.eval_batch);
 
 		else if (strcmp(option, "book-file") == 0) options.book_file = string_duplicate(value);
 		else if (strcmp(option, "book-usage") == 0) parse_boolean(value, &options.book_allowed);
 		else if (strcmp(option, "book-randomness") == 0) parse_int(value, &options.book_randomness);
+		else if (strcmp(option, "book-checkpoint") == 0) parse_int(value, &options.book_checkpoint);
 
 		else if (strcmp(option, "search-log-file") == 0) options.search_log_file = string_duplicate(value);
+		else if (strcmp(option, "trace-file") == 0) options.trace_file = string_duplicate(value);
 		else if (strcmp(option, "ui-log-file") == 0) options.ui_log_file = string_duplicate(value);
 		else if (strcmp(option, "ggs-log-file") == 0) options.ggs_log_file = string_duplicate(value);
 
@@ -298,17 +333,20 @@ void options_bound(void)
 
 	max_threads = MIN(get_cpu_number(), MAX_THREADS);
 	BOUND(options.n_task, 1, max_threads, "n-tasks");
+	BOUND(options.n_search, 1, MAX_THREADS, "batch-searches");
 
 	BOUND(options.verbosity, 0, 4, "verbosity");
 	BOUND(options.noise, 0, 60, "noise");
 	BOUND(options.width, 3, 250, "width");
 	BOUND(options.level, 0, 60, "level");
 	BOUND(options.time, 1000, TIME_MAX, "time");
+	BOUND(options.book_checkpoint, 1, 86400, "book-checkpoint");
 
 	BOUND(options.alpha, SCORE_MIN, SCORE_MAX, "alpha");
 	BOUND(options.beta, SCORE_MIN, SCORE_MAX, "beta");
 
 	BOUND(options.speed, 1e5, 1e12, "speed");
+	BOUND(options.ponder_candidates, 1, PONDER_MAX_CANDIDATES, "ponder-candidates");
 
 	if (options.alpha > options.beta) {
 		fprintf(stderr, "WARNING: alphabeta [%d, %d] will be inverted.\n", options.alpha, options.beta);
@@ -321,6 +359,7 @@ void options_bound(void)
 	if (options.game_file == NULL) options.game_file = string_duplicate("data/game.ggf");
 	if (options.eval_file == NULL) options.eval_file = string_duplicate("data/eval.dat");
 	if (options.book_file == NULL) options.book_file = string_duplicate("data/book.dat");
+	if (options.time_model_file == NULL) options.time_model_file = string_duplicate("data/time.dat");
 }
 
 /**
@@ -347,21 +386,29 @@ void options_dump(FILE *f)
 	fprintf(f, "\tsize (in number of bits) of the hash table: %d\n", options.hash_table_size);
 	fprintf(f, "\tsorting depth increment: pv = %d, all = %d, cut = %d\n",  options.inc_sort_depth[0], options.inc_sort_depth[1], options.inc_sort_depth[2]);
 	fprintf(f, "\ttask number for parallel search: %d\n", options.n_task);
+	fprintf(f, "\tsearch number for batch jobs: %d\n", options.n_search);
+	fprintf(f, "\tpartitioned hash table of a search pool: %s\n", boolean_string[options.partition_hash]);
 	fprintf(f, "\tsearch level: %d\n", options.level);
 	fprintf(f, "\tsearch alloted time:"); time_print(options.time, false, stdout); fprintf(f, "\n");
 	fprintf(f, "\tsearch with: %s\n", play_type[options.play_type]);
 	fprintf(f, "\tsearch pondering: %s\n", boolean_string[options.can_ponder]);
+	fprintf(f, "\tsearch pondering candidates: %d\n", options.ponder_candidates);
 	fprintf(f, "\tsearch depth: %d\n", options.depth);
 	fprintf(f, "\tsearch selectivity: %d\n", options.selectivity);
 	fprintf(f, "\tsearch speed %.0f N/s\n", options.speed);
 	fprintf(f, "\tsearch nps %.0f N/s\n", options.nps);
+	fprintf(f, "\tsearch time model: %s, learning: %s (%s)\n", boolean_string[options.time_model], boolean_string[options.time_model_learn], options.time_model_file);
 	fprintf(f, "\tsearch alpha: %d\n", options.alpha);
 	fprintf(f, "\tsearch beta: %d\n", options.beta);
 	fprintf(f, "\tsearch all best moves: %s\n", boolean_string[options.all_best]);
 	fprintf(f, "\teval file: %s\n", options.eval_file);
+	fprintf(f, "\teval 8-bit weights: %s\n", boolean_string[options.eval_int8]);
+	fprintf(f, "\teval weights cache: %s\n", boolean_string[options.eval_cache]);
+	fprintf(f, "\teval batch: %s\n", boolean_string[options.eval_batch]);
 	fprintf(f, "\tbook file: %s\n", options.book_file);
 	fprintf(f, "\tbook allowed: %s\n", boolean_string[options.book_allowed]);
-	fprintf(f, "\tbook randomness: %d\n\n", options.book_randomness);
+	fprintf(f, "\tbook randomness: %d\n", options.book_randomness);
+	fprintf(f, "\tbook checkpoint: %d s\n\n", options.book_checkpoint);
 
 	fprintf(f, "ggs options\n");
 	fprintf(f, "\thost: %s\n", options.ggs_host ? options.ggs_host : "?");
@@ -379,6 +426,7 @@ void options_dump(FILE *f)
 
 	fprintf(f, "log files\n");
 	fprintf(f, "\tsearch: %s\n", options.search_log_file ? options.search_log_file : "?");
+	fprintf(f, "\ttrace: %s\n", options.trace_file ? options.trace_file : "?");
 	fprintf(f, "\tui: %s\n", options.ui_log_file ? options.ui_log_file : "?");
 	fprintf(f, "\tggs: %s\n", options.ggs_log_file ? options.ggs_log_file : "?");
 
@@ -406,9 +454,11 @@ void options_free(void)
 	free(options.game_file);
 	free(options.ui_log_file);
 	free(options.search_log_file);
+	free(options.trace_file);
 	free(options.ggs_log_file);
 	free(options.name);
 	free(options.book_file);
 	free(options.eval_file);
+	free(options.time_model_file);
 }
 
@@ -28,6 +28,8 @@ typedef struct {
 
 	int n_task;                           /**< search in parallel, using n_tasks */
 	bool cpu_affinity;                    /**< set one cpu/thread to diminish context change */
+	int n_search;                         /**< run batch jobs (base check, wtest...) with n searches */
+	bool partition_hash;                  /**< one hash table per search of a search pool, instead of a shared one */
 
 	int verbosity;                        /**< search display */
  	int noise;                            /**< search display min depth */
@@ -41,6 +43,7 @@ typedef struct {
 	long long time;                       /**< time in sec. */
 	PlayType play_type;                   /**< game|move-time switch */
 	bool can_ponder;                      /**< pondering on/off */
+	int ponder_candidates;                /**< number of opponent replies pondered at once */
 	int depth;                            /**< depth (only for testing) */
 	int selectivity;                      /**< selectivity (only for testing) */
 
@@ -48,6 +51,9 @@ typedef struct {
 
 	double speed;                         /**< edax speed in N/S (for a more accurate time management) */
 	double nps;                           /**< edax assumed speed (for nps based timing */                           
+	bool time_model;                      /**< use the learned search speed (for time management) */
+	bool time_model_learn;                /**< learn the search speed from completed searches & save it */
+	char *time_model_file;                /**< learned time model file */
 
 	int alpha;                            /**< alpha bound */
 	int beta;                             /**< beta bound */
@@ -55,10 +61,14 @@ typedef struct {
 	bool all_best;                        /**< search for all best moves when solving problem */
 
 	char *eval_file;                      /**< evaluation file */
+	bool eval_int8;                       /**< use 8-bit quantized evaluation weights */
+	bool eval_cache;                      /**< map the unpacked evaluation weights from a cache file */
+	bool eval_batch;                      /**< evaluate sibling leaves together */
 
 	char *book_file;                      /**< opening book filename */
 	bool book_allowed;                    /**< switch to use or not the opening book*/
 	int book_randomness;                  /**< book randomness */
+	int book_checkpoint;                  /**< time between two checkpoints of a long book job (in seconds) */
 
 	char *ggs_host;                       /**< ggs host (ip or host name) */
 	char *ggs_login;                      /**< ggs login */
@@ -75,6 +85,7 @@ typedef struct {
 	char *game_file;                      /**< game file */
 
 	char *search_log_file;                /**< log file (for search) */
+	char *trace_file;                     /**< binary search-tree trace file */
 	char *ui_log_file;                    /**< log file (for user interface) */
 	char *ggs_log_file;                   /**< log file (for ggs) */
 
@@ -18,6 +18,7 @@
 #include "settings.h"
 
 #include <assert.h>
+#include <math.h>
 
 /**
  * @brief Initialization.
@@ -26,6 +27,8 @@
  */
 void play_init(Play *play, Book *book)
 {
+	int i;
+
 	search_init(&play->search);
 	play->book = book;
 	board_init(&play->initial_board);
@@ -38,7 +41,11 @@ void play_init(Play *play, Book *book)
 	play->time[1].extra = 0;
 	play_new(play);
 	lock_init(&play->ponder);
+	spin_init(&play->ponder);
+	play->tasks_limit = MAX_THREADS;
 	play->ponder.launched = false;
+	for (i = 0; i < PONDER_MAX_CANDIDATES; ++i) play->ponder.candidate[i].search = NULL;
+	play->ponder.candidate[0].search = &play->search;
 	spin_init(&play->result);
 	play->ponder.verbose = false;
 	memset(play->error_message, 0, PLAY_MESSAGE_MAX_LENGTH);
@@ -51,7 +58,15 @@ void play_init(Play *play, Book *book)
  */
 void play_free(Play *play)
 {
+	int i;
+
 	play_stop_pondering(play);
+	for (i = 1; i < PONDER_MAX_CANDIDATES; ++i) {
+		if (play->ponder.candidate[i].search) {
+			search_free_shared(play->ponder.candidate[i].search);
+			mm_free(play->ponder.candidate[i].search);
+		}
+	}
 	search_free(&play->search);
 }
 
@@ -66,6 +81,7 @@ void play_new(Play *play)
 	play->board = play->initial_board;
 	play->player = play->initial_player;
 	play->ponder.board.player = play->ponder.board.opponent = 0;
+	play->ponder.n_candidate = 0;
 	search_cleanup(&play->search);
 	play->i_game = play->n_game = 0;
 	play->state = IS_WAITING;
@@ -206,6 +222,103 @@ bool play_must_pass(Play *play)
 }
 #endif
 
+/**
+ * @brief Share the helper tasks of the play among its running searches.
+ *
+ * The helper tasks given to the play (play->tasks_limit) are only set by its
+ * UI, through play_set_tasks_limit(); the pondering code only shares them:
+ * while several opponent replies are pondered on, each running search gets,
+ * besides its own thread, a share of the helpers proportional to the
+ * likelihood of its reply, the rounding leftover going to the most likely
+ * running reply. Otherwise the running search (or the play search) gets all
+ * of them.
+ *
+ * @param play Play.
+ */
+static void play_share_tasks(Play *play)
+{
+	PonderCandidate *candidate = play->ponder.candidate;
+	int i, k, n, n_running, n_helper, n_left, limit[PONDER_MAX_CANDIDATES];
+	double sum;
+
+	spin_lock(&play->ponder);
+		n = play->ponder.n_candidate;
+		for (sum = 0.0, k = -1, n_running = i = 0; i < n; ++i) {
+			limit[i] = MAX_THREADS;
+			if (!candidate[i].done) {
+				sum += candidate[i].likelihood;
+				if (k < 0) k = i;
+				++n_running;
+			}
+		}
+
+		if (n_running > 1) {
+			n_helper = n_left = MAX(0, MIN(play->search.tasks->n, play->tasks_limit + 1) - n_running);
+			for (i = 0; i < n; ++i) {
+				if (i != k && !candidate[i].done) n_left -= (limit[i] = (int) (n_helper * candidate[i].likelihood / sum));
+			}
+			limit[k] = n_left;
+		} else {
+			if (k >= 0) limit[k] = play->tasks_limit;
+			spin_lock(&play->search);
+				play->search.tasks_limit = play->tasks_limit;
+			spin_unlock(&play->search);
+		}
+
+		for (i = 0; i < n; ++i) {
+			if (!candidate[i].done) {
+				spin_lock(candidate[i].search);
+					candidate[i].search->tasks_limit = limit[i];
+				spin_unlock(candidate[i].search);
+			}
+		}
+	spin_unlock(&play->ponder);
+}
+
+/**
+ * @brief Set the helper tasks given to the play.
+ *
+ * @param play Play.
+ * @param tasks_limit Number of helper tasks.
+ */
+void play_set_tasks_limit(Play *play, const int tasks_limit)
+{
+	play->tasks_limit = tasks_limit;
+	play_share_tasks(play);
+}
+
+/**
+ * @brief Get the search that pondered on the current position.
+ *
+ * When several opponent moves were pondered on, stop the searches of the
+ * other moves & let the right one use all the tasks.
+ *
+ * @param play Play.
+ * @return The search, or NULL if the current position was not pondered on.
+ */
+static Search* play_ponder_hit(Play *play)
+{
+	PonderCandidate *candidate = play->ponder.candidate;
+	Search *search = NULL;
+	int i;
+
+	for (i = 0; i < play->ponder.n_candidate; ++i) {
+		if (board_equal(&play->board, &candidate[i].board)) search = candidate[i].search;
+	}
+	if (search == NULL) return board_equal(&play->board, &play->ponder.board) ? &play->search : NULL;
+
+	for (i = 0; i < play->ponder.n_candidate; ++i) {
+		// a search stopped before it starts would run again, so wait its end.
+		while (candidate[i].search != search && !candidate[i].done) {
+			search_stop_all(candidate[i].search, STOP_PONDERING);
+			relax(1);
+		}
+	}
+	play_share_tasks(play);
+
+	return search;
+}
+
 /**
  * @brief Start thinking.
  * @param play Play.
@@ -218,7 +331,7 @@ void play_go(Play *play, const bool update)
 	long long t_real = -real_clock();
 	long long t_cpu = -cpu_clock();
 	Move move;
-	Search *const search = &play->search;
+	Search *search = &play->search;
 	char s_move[4];
 
 	if (play_is_game_over(play)) return;
@@ -269,12 +382,12 @@ void play_go(Play *play, const bool update)
 				if (search->options.separator) puts(search->options.separator);
 			} 
 		}
-	} else if (play->state == IS_PONDERING && board_equal(&play->board, &play->ponder.board)) {
+	} else if (play->state == IS_PONDERING && (search = play_ponder_hit(play)) != NULL) {
 		play->state = IS_THINKING;
 
 		search->options.verbosity = options.verbosity;
 		if (options.verbosity) {
-			info("\n[switch from pondering to thinking (id.%d)]\n", play->search.id);
+			info("\n[switch from pondering to thinking (id.%d)]\n", search->id);
 			if (search->options.header) puts(search->options.header);
 			if (search->options.separator) puts(search->options.separator);
 		}
@@ -309,6 +422,7 @@ void play_go(Play *play, const bool update)
 	} else {
 
 		play_stop_pondering(play);
+		search = &play->search;
 
 		play->state = IS_THINKING;
 
@@ -332,7 +446,8 @@ void play_go(Play *play, const bool update)
 				search->options.depth, selectivity_table[search->options.selectivity].percent);
 		}
 		
-		search_run(search);
+		search_start(search);
+		search_join(search);
 		play->result = *search->result;
 		play->state = IS_WAITING;
 		if (!board_get_move_flip(&play->board, search->result->move, &move) && move.x != PASS) {
@@ -357,7 +472,8 @@ void play_go(Play *play, const bool update)
 /**
  * @brief Start thinking.
  *
- * Evaluate first best moves of the position.
+ * Evaluate first best moves of the position: the book moves, then the n best
+ * moves left, searched together in multi-PV mode.
  *
  * @param play Play.
  * @param n Number of (best) moves to evaluate.
@@ -370,6 +486,7 @@ void play_hint(Play *play, int n)
 	MoveList book_moves;
 	GameStats stat;
 	Board b;
+	int i;
 
 	if (play_is_game_over(play)) return;
 
@@ -378,6 +495,7 @@ void play_hint(Play *play, int n)
 	play->state = IS_THINKING;
 
 	search->options.verbosity = options.verbosity;
+	if (play->type == UI_NBOARD) search->options.verbosity = MAX(options.verbosity, 2); // stream the search lines
 	if (options.verbosity) {
 		info("\n[start thinking]\n");
 		if (search->options.header) puts(search->options.header);
@@ -406,20 +524,28 @@ void play_hint(Play *play, int n)
 		}
 	}
 
-	while (n--) {
+	// search the n best moves at once
+	if (n > 0) {
+		Result *result = search->result;
 		if (options.play_type == EDAX_TIME_PER_MOVE) search_set_move_time(search, options.time);
 		else search_set_game_time(search, play->time[play->player].left);
-		if (n) search->options.multipv_depth = 60;
-		search_run(search);
-		search->options.multipv_depth = MULTIPV_DEPTH;
+		search->options.multipv = n;
+		search_start(search);
+		search_join(search);
+		search->options.multipv = 1;
 		if (play->type == UI_NBOARD) {
-			printf("search "); line_print(&search->result->pv, 10, NULL, stdout);
-			printf(" %d 0 %d\n", search->result->score, search->result->depth);
+			if (result->n_lines > 1) {
+				for (i = 0; i < result->n_lines; ++i) {
+					printf("search "); line_print(&result->line[i].pv, 10, NULL, stdout);
+					printf(" %d 0 %d\n", result->line[i].score, result->depth);
+				}
+			} else {
+				printf("search "); line_print(&result->pv, 10, NULL, stdout);
+				printf(" %d 0 %d\n", result->score, result->depth);
+			}
 		} else {
-			if (options.verbosity == 0) search->observer(search->result);
+			if (options.verbosity == 0) search->observer(result);
 		}
-		if (search->stop != STOP_END) break;
-		movelist_exclude(&search->movelist, search->result->move);
 	}
 	if (options.verbosity) {
 		info("\n[stop thinking]\n");
@@ -427,6 +553,170 @@ void play_hint(Play *play, int n)
 	}
 }
 
+/**
+ * @brief Score an opponent move from the hash tables.
+ *
+ * @param search Search.
+ * @param board Position after the opponent move.
+ * @param score Score of the move, from the opponent's point of view (output).
+ * @return true if the position was searched.
+ */
+static bool play_ponder_score(Search *search, const Board *board, int *score)
+{
+	HashData hash_data;
+	const unsigned long long hash_code = board_get_hash_code(board);
+
+	if (!hash_get(&search->pv_table, board, hash_code, &hash_data)
+	 && !hash_get(&search->hash_table, board, hash_code, &hash_data)) return false;
+
+	if (hash_data.lower > SCORE_MIN && hash_data.upper < SCORE_MAX) *score = -(hash_data.lower + hash_data.upper) / 2;
+	else if (hash_data.lower > SCORE_MIN) *score = -hash_data.lower;
+	else if (hash_data.upper < SCORE_MAX) *score = -hash_data.upper;
+	else return false;
+
+	return true;
+}
+
+/**
+ * @brief Select the opponent moves to ponder on.
+ *
+ * Each opponent move is scored from the opening book, or else from the hash
+ * tables filled by the previous searches. Its likelihood decreases
+ * exponentially with its score difference to the best move. The moves never
+ * searched are scored a little below the worst known move.
+ *
+ * @param play Play.
+ * @param board Position, with the opponent to move.
+ * @param candidate Most likely moves, sorted by decreasing likelihood (output).
+ * @return The number of moves to ponder on, 0 to ponder on a single move.
+ */
+static int play_ponder_select(Play *play, const Board *board, PonderCandidate *candidate)
+{
+	Search *search = &play->search;
+	MoveList movelist, book_movelist;
+	Move *move, *book_move;
+	const int guess = search_guess(search, board);
+	int i, n, best = -SCORE_INF, worst = SCORE_INF;
+	bool in_book;
+	double sum;
+
+	n = MIN(options.ponder_candidates, search_count_tasks(search));
+	if (n < 2 || movelist_get_moves(&movelist, board) < 2) return 0;
+	in_book = options.book_allowed && book_get_moves(play->book, board, &book_movelist);
+
+	foreach_move(move, movelist) {
+		move->score = -SCORE_INF;
+		if (in_book) foreach_move(book_move, book_movelist) {
+			if (book_move->x == move->x) move->score = book_move->score;
+		}
+		if (move->score == -SCORE_INF) {
+			Board next;
+			board_next(board, move->x, &next);
+			if (!play_ponder_score(search, &next, &move->score)) move->score = -SCORE_INF;
+		}
+		if (move->score > -SCORE_INF) {
+			best = MAX(best, move->score);
+			worst = MIN(worst, move->score);
+		}
+	}
+	if (best == -SCORE_INF) return 0;
+
+	sum = 0.0;
+	foreach_move(move, movelist) {
+		if (move->score == -SCORE_INF) move->score = (move->x == guess ? best : worst - 8);
+		sum += exp((move->score - best) / PONDER_TEMPERATURE);
+	}
+	movelist_sort(&movelist);
+
+	n = MIN(n, movelist.n_moves);
+	for (i = 0, move = movelist.move->next; i < n; ++i, move = move->next) {
+		candidate[i].move = *move;
+		candidate[i].likelihood = exp((move->score - best) / PONDER_TEMPERATURE) / sum;
+		board_next(board, move->x, &candidate[i].board);
+	}
+
+	return n;
+}
+
+/**
+ * @brief Search a pondered position.
+ *
+ * @param v Pondered move.
+ * @return NULL (unused).
+ */
+static void* play_ponder_candidate_run(void *v)
+{
+	PonderCandidate *candidate = (PonderCandidate*) v;
+
+	search_run(candidate->search);
+	candidate->done = true;
+
+	return NULL;
+}
+
+/**
+ * @brief Ponder on several opponent moves at once.
+ *
+ * Each move gets its own search, sharing the hash tables & the tasks of the
+ * play search. Besides its own thread, each search may use a share of the
+ * helper tasks proportional to the likelihood of the move.
+ *
+ * @param play Play.
+ * @param player Player to move after the opponent move.
+ * @param n Number of moves to ponder on.
+ */
+static void play_ponder_candidates(Play *play, const int player, const int n)
+{
+	PonderCandidate *candidate = play->ponder.candidate;
+	Search *const search = &play->search;
+	int i;
+	char m[4];
+
+	// hash tables are shared, so keep their date through all the searches.
+	if (!search->options.keep_date) {
+		hash_clear(&search->hash_table);
+		hash_clear(&search->pv_table);
+		hash_clear(&search->shallow_table);
+		search->options.keep_date = true;
+	}
+
+	for (i = 0; i < n; ++i) {
+		if (i > 0) {
+			if (candidate[i].search == NULL) {
+				candidate[i].search = (Search*) mm_malloc(sizeof (Search));
+				if (candidate[i].search == NULL) fatal_error("Cannot allocate a pondering search\n");
+				search_init_shared(candidate[i].search, search);
+			} else {
+				search_update_shared(candidate[i].search, search);
+			}
+			candidate[i].search->options.verbosity = 0;
+		}
+		search_set_board(candidate[i].search, &candidate[i].board, player ^ 1);
+		search_set_level(candidate[i].search, options.level, candidate[i].search->eval.n_empties);
+		candidate[i].done = false;
+	}
+	play->ponder.board = candidate[0].board;
+	play->ponder.n_candidate = n;
+
+	play_share_tasks(play);
+	for (i = 0; i < n; ++i) {
+		info("[ponder after %s: likelihood = %.0f%%, helpers = %d]\n", move_to_string(candidate[i].move.x, player ^ 1, m), 100.0 * candidate[i].likelihood, candidate[i].search->tasks_limit);
+	}
+
+	for (i = 1; i < n; ++i) thread_create(&candidate[i].thread, play_ponder_candidate_run, candidate + i);
+	play_ponder_candidate_run(candidate);
+	for (i = 1; i < n; ++i) thread_join(candidate[i].thread);
+
+	for (i = 0; i < n; ++i) {
+		if (options.info && play->state == IS_PONDERING) {
+			printf("[ponder after %s id.%d: ", move_to_string(candidate[i].move.x, player ^ 1, m), candidate[i].search->id);
+			result_print(candidate[i].search->result, stdout);
+			printf("]\n");
+		}
+	}
+	play_share_tasks(play);
+}
+
 /**
  * @brief do ponderation.
  *
@@ -448,6 +738,7 @@ void* play_ponder_run(void *v)
 	Board board;
 	Move move;
 	char m[4];
+	int n;
 
 	lock(&play->ponder);
 	if (play->state == IS_PONDERING || play->state == IS_ANALYZING) {
@@ -460,8 +751,12 @@ void* play_ponder_run(void *v)
 
 		move.x = search_guess(search, &board);
 
+		// ponder on the most likely opponent moves at once
+		if (play->state == IS_PONDERING && (n = play_ponder_select(play, &board, play->ponder.candidate)) > 1) {
+			play_ponder_candidates(play, player, n);
+
 		// guess opponent move and start the search
-		if (play->state == IS_PONDERING && move.x != NOMOVE) {
+		} else if (play->state == IS_PONDERING && move.x != NOMOVE) {
 			board_get_move_flip(&board, move.x, &move);
 
 			board_update(&board, &move);
@@ -511,6 +806,7 @@ void play_ponder(Play *play)
 	if (play_is_game_over(play)) return;
 	if (options.can_ponder && play->state == IS_WAITING) {
 		play->ponder.board.player = play->ponder.board.opponent = 0;
+		play->ponder.n_candidate = 0;
 		play->state = IS_PONDERING;
 		info("\n[start ponderation]\n");
 		thread_create(&play->ponder.thread, play_ponder_run, play);
@@ -528,9 +824,12 @@ void play_ponder(Play *play)
  */
 void play_stop_pondering(Play *play)
 {
+	int i;
+
 	while (play->state == IS_PONDERING) {
 		info("[stop pondering]\n");
 		search_stop_all(&play->search, STOP_PONDERING);
+		for (i = 1; i < play->ponder.n_candidate; ++i) search_stop_all(play->ponder.candidate[i].search, STOP_PONDERING);
 		relax(10);
 	}
 
@@ -548,7 +847,11 @@ void play_stop_pondering(Play *play)
  */
 void play_stop(Play *play)
 {
-	search_stop_all(&play->search, STOP_ON_DEMAND);
+	int i;
+
+	if (search_is_running(&play->search)) search_stop(&play->search, STOP_ON_DEMAND);	// thinking (play_go, play_hint)
+	else search_stop_all(&play->search, STOP_ON_DEMAND);	// pondering, in the pondering thread
+	for (i = 1; i < play->ponder.n_candidate; ++i) search_stop_all(play->ponder.candidate[i].search, STOP_ON_DEMAND);
 	info("[stop on user demand]\n");
 }
 
@@ -16,11 +16,22 @@
 #include "book.h"
 #include "search.h"
 #include "move.h"
+#include "settings.h"
 #include "util.h"
 
 /** error message max length */
 #define PLAY_MESSAGE_MAX_LENGTH 4096
 
+/** opponent reply pondered alongside others */
+typedef struct PonderCandidate {
+	Board board;               /**< position after the reply */
+	Move move;                 /**< the reply */
+	double likelihood;         /**< estimated probability the reply is played */
+	Search *search;            /**< search of the position (the play search for the first candidate) */
+	Thread thread;             /**< search thread */
+	volatile bool done;        /**< search ended */
+} PonderCandidate;
+
 /** play structure */
 typedef struct Play {
 	Board board;               /**< current board. */
@@ -37,6 +48,7 @@ typedef struct Play {
 	volatile PlayState state;  /**< current state */
 	int level;                 /**< search level */
 	long long clock;           /**< internal clock */
+	int tasks_limit;           /**< helper tasks given to the play by its UI (see play_set_tasks_limit()) */
 	struct {
 		long long spent;       /**< time spent */
 		long long left;        /**< time left */
@@ -55,6 +67,9 @@ typedef struct Play {
 		Board board;           /**< pondered position */
 		bool launched;         /**< launched thread */
 		bool verbose;          /**< verbose pondering */
+		PonderCandidate candidate[PONDER_MAX_CANDIDATES]; /**< replies pondered at once */
+		volatile int n_candidate;  /**< number of replies pondered at once */
+		SpinLock spin;         /**< lock of the task sharing */
 	} ponder;                  /**< pondering thread */
 	char error_message[PLAY_MESSAGE_MAX_LENGTH]; /**< error message */
 } Play;
@@ -74,6 +89,7 @@ void* play_ponder_run(void*);
 void play_ponder(Play*);
 void* play_ponder_loop(void*);
 void play_stop_pondering(Play*);
+void play_set_tasks_limit(Play*, const int);
 void play_update(Play*, Move*);
 void play_pass(Play*);
 void play_undo(Play*);
@@ -0,0 +1,193 @@
+/**
+ * @file pool.c
+ *
+ * Search pool.
+ *
+ * Several searches, each one analyzing its own position in its own thread,
+ * share the task stack (& by default the hash tables) of a main search,
+ * instead of each one owning them: the host runs as many threads as tasks,
+ * whatever the number of concurrent searches, and the hash memory is not
+ * duplicated. The helper tasks are shared fairly among the running searches:
+ * each time a search starts or ends, the task limits of the running searches
+ * are updated (see search_init_shared()).
+ * With a partitioned hash table, each search owns an equal part of the hash
+ * memory, which makes its result independent of the other searches.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#include "pool.h"
+
+#include "options.h"
+
+/**
+ * @brief Share the helper tasks among the running searches.
+ *
+ * Each running search uses its own thread, so the helpers are the tasks left
+ * once a task is counted for each of them.
+ *
+ * @param pool Search pool.
+ */
+static void search_pool_balance(SearchPool *pool)
+{
+	int i, k, n_helper;
+
+	if (pool->n_active == 0) return;
+
+	n_helper = MAX(0, pool->master.tasks->n - pool->n_active);
+	for (i = k = 0; i < pool->n_search; ++i) {
+		if (pool->is_active[i]) {
+			pool->search[i].tasks_limit = n_helper / pool->n_active + (k < n_helper % pool->n_active);
+			++k;
+		}
+	}
+	info("<pool: %d running searches, %d helper tasks>\n", pool->n_active, n_helper);
+}
+
+/**
+ * @brief Initialize a search pool.
+ *
+ * @param pool Search pool.
+ * @param n_search Number of searches.
+ * @param is_partitioned Give each search its own part of the hash memory.
+ */
+void search_pool_init(SearchPool *pool, const int n_search, const bool is_partitioned)
+{
+	const int hash_table_size = options.hash_table_size;
+	int i, n_bits;
+
+	pool->n_search = n_search;
+	pool->n_active = 0;
+	pool->is_partitioned = is_partitioned;
+	pool->search = (Search*) mm_malloc(n_search * sizeof (Search));
+	pool->is_active = (bool*) calloc(n_search, sizeof (bool));
+	if (pool->search == NULL || pool->is_active == NULL) fatal_error("Cannot allocate a pool of %d searches\n", n_search);
+	lock_init(pool);
+
+	for (n_bits = 0; (1 << n_bits) < n_search; ++n_bits) ;
+	if (is_partitioned) options.hash_table_size = 10;
+	search_init(&pool->master);
+	options.hash_table_size = hash_table_size;
+
+	for (i = 0; i < n_search; ++i) {
+		Search *search = pool->search + i;
+		search_init_shared(search, &pool->master);
+		search->id = i + 1;
+		if (is_partitioned) {
+			search->hash_table.hash = search->pv_table.hash = search->shallow_table.hash = NULL;
+			search->options.hash_size = 0;
+			options.hash_table_size = MAX(10, hash_table_size - n_bits);
+			search_resize_hashtable(search);
+			options.hash_table_size = hash_table_size;
+		}
+	}
+	info("<pool: %d searches sharing %d tasks and %s hash table>\n", n_search, pool->master.tasks->n, is_partitioned ? "a partitioned" : "one");
+}
+
+/**
+ * @brief Free a search pool.
+ *
+ * @param pool Search pool.
+ */
+void search_pool_free(SearchPool *pool)
+{
+	int i;
+
+	for (i = 0; i < pool->n_search; ++i) {
+		Search *search = pool->search + i;
+		if (pool->is_partitioned) {
+			hash_free(&search->hash_table);
+			hash_free(&search->pv_table);
+			hash_free(&search->shallow_table);
+		}
+		search_free_shared(search);
+	}
+	search_free(&pool->master);
+	mm_free(pool->search);
+	free(pool->is_active);
+	lock_free(pool);
+}
+
+/**
+ * @brief Get a search of the pool.
+ *
+ * @param pool Search pool.
+ * @param i Search index.
+ * @return the search.
+ */
+Search* search_pool_get(SearchPool *pool, const int i)
+{
+	return pool->search + i;
+}
+
+/**
+ * @brief Start a search of the pool.
+ *
+ * To be called before search_run(). With a shared hash table, the hash date
+ * is advanced here once for all the searches, so that search_run() keeps it:
+ * the table is never cleaned up while another search is running. As each
+ * search holds a copy of the shared tables, the new date is also given to
+ * the searches already running, so that all of them store with the same date.
+ *
+ * @param pool Search pool.
+ * @param search Search.
+ */
+void search_pool_start(SearchPool *pool, Search *search)
+{
+	Search *master = &pool->master;
+	const int i = search - pool->search;
+	int k;
+
+	lock(pool);
+		search->tasks = master->tasks;
+		search->allow_node_splitting = master->allow_node_splitting;
+		if (!pool->is_partitioned) {
+			if (pool->n_active == 0 || master->hash_table.date < 127) {
+				hash_clear(&master->hash_table);
+				hash_clear(&master->pv_table);
+				hash_clear(&master->shallow_table);
+			}
+			search->hash_table = master->hash_table;
+			search->pv_table = master->pv_table;
+			search->shallow_table = master->shallow_table;
+			search->options.keep_date = true;
+			// the running searches hold a copy of the tables: bring their date up to date too.
+			for (k = 0; k < pool->n_search; ++k) {
+				if (pool->is_active[k]) {
+					pool->search[k].hash_table.date = master->hash_table.date;
+					pool->search[k].pv_table.date = master->pv_table.date;
+					pool->search[k].shallow_table.date = master->shallow_table.date;
+				}
+			}
+		}
+		if (!pool->is_active[i]) {
+			pool->is_active[i] = true;
+			++pool->n_active;
+			search_pool_balance(pool);
+		}
+	unlock(pool);
+}
+
+/**
+ * @brief End a search of the pool.
+ *
+ * Its helper tasks are shared among the searches still running.
+ *
+ * @param pool Search pool.
+ * @param search Search.
+ */
+void search_pool_end(SearchPool *pool, Search *search)
+{
+	const int i = search - pool->search;
+
+	lock(pool);
+		if (pool->is_active[i]) {
+			pool->is_active[i] = false;
+			--pool->n_active;
+			search->tasks_limit = MAX_THREADS;
+			search_pool_balance(pool);
+		}
+	unlock(pool);
+}
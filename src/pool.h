@@ -0,0 +1,33 @@
+/**
+ * @file pool.h
+ *
+ * Search pool header.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#ifndef EDAX_POOL_H
+#define EDAX_POOL_H
+
+#include "search.h"
+
+/** A pool of searches, sharing one task stack & one hash table */
+typedef struct SearchPool {
+	Search master;               /**< main search, owning the task stack & the shared hash tables */
+	Search *search;              /**< searches of the pool */
+	bool *is_active;             /**< running searches */
+	int n_search;                /**< number of searches */
+	int n_active;                /**< number of running searches */
+	bool is_partitioned;         /**< one hash table per search */
+	Lock lock;                   /**< lock */
+} SearchPool;
+
+void search_pool_init(SearchPool*, const int, const bool);
+void search_pool_free(SearchPool*);
+Search* search_pool_get(SearchPool*, const int);
+void search_pool_start(SearchPool*, Search*);
+void search_pool_end(SearchPool*, Search*);
+
+#endif
@@ -11,8 +11,11 @@
 #include "search.h"
 
 #include "bit.h"
+#include "histogram.h"
 #include "options.h"
 #include "stats.h"
+#include "timemodel.h"
+#include "trace.h"
 #include "util.h"
 #include "ybwc.h"
 #include "settings.h"
@@ -135,6 +138,52 @@ static int guess_move(Search *search, Board *board)
 	return hash_data.move[0];
 }
 
+/**
+ * @brief Get the principal variation of a root move, from the hash tables.
+ *
+ * The PV is followed as long as the hash data agree with the expected level
+ * & score bounds.
+ *
+ * @param search Search.
+ * @param x Root move.
+ * @param expected_bound Score bounds of the move.
+ * @param expected_depth Depth of the move search.
+ * @param guess_pv Guess the moves missing from a fail-low PV.
+ * @param fail_low The move search failed low.
+ * @param pv Principal variation (output).
+ */
+static void get_pv(Search *search, int x, Bound expected_bound, int expected_depth, const bool guess_pv, bool fail_low, Line *pv)
+{
+	Board board;
+	Move move;
+	unsigned long long hash_code;
+	HashData hash_data;
+	const int expected_selectivity = search->selectivity;
+	int tmp;
+
+	board = search->board;
+	line_init(pv, search->player);
+
+	while (x != NOMOVE) {
+		board_get_move_flip(&board, x, &move);
+		if (board_check_move(&board, &move)) {
+			board_update(&board, &move);
+			--expected_depth; 
+			tmp = expected_bound.upper; expected_bound.upper = -expected_bound.lower; expected_bound.lower = -tmp;
+			fail_low = !fail_low;
+			line_push(pv, move.x);
+
+			hash_code = board_get_hash_code(&board);
+			if ((hash_get(&search->pv_table, &board, hash_code, &hash_data) || hash_get(&search->hash_table, &board, hash_code, &hash_data)) 
+			 && (hash_data.wl.c.depth >= expected_depth && hash_data.wl.c.selectivity >= expected_selectivity)
+			 && (hash_data.upper <= expected_bound.upper && hash_data.lower >= expected_bound.lower)) {
+				x = hash_data.move[0];
+			} else x = NOMOVE;
+			if (guess_pv && x == NOMOVE && fail_low) x = guess_move(search, &board);
+		} else x = NOMOVE;
+	}
+}
+
 /**
  * @brief Record best move.
  *
@@ -146,20 +195,11 @@ static int guess_move(Search *search, Board *board)
  */
 void record_best_move(Search *search, const Move *bestmove, const int alpha, const int beta, const int depth)
 {
-	Board board;
-	Move move;
 	Result *result = search->result;
-	int x;
-	unsigned long long hash_code;
-	HashData hash_data;
 	bool has_changed;
 	Bound *bound = result->bound + bestmove->x;
 	bool fail_low;
 	bool guess_pv;
-	int expected_depth, expected_selectivity, tmp;
-	Bound expected_bound;
-
-	board = search->board;
 
 	spin_lock(result);
 
@@ -177,34 +217,12 @@ void record_best_move(Search *search, const Move *bestmove, const int alpha, con
 		if (result->score > alpha) bound->lower = result->score; else bound->lower = search->stability_bound.lower;
 	}
 
-	expected_depth = result->depth = depth;
-	expected_selectivity = result->selectivity = search->selectivity;
-	expected_bound = *bound;
-
-	line_init(&result->pv, search->player);
-	x = bestmove->x;
+	result->depth = depth;
+	result->selectivity = search->selectivity;
 
 	guess_pv = (search->options.guess_pv && depth == search->eval.n_empties && (bestmove->score <= alpha || bestmove->score >= beta));
 	fail_low = (bestmove->score <= alpha);
-
-	while (x != NOMOVE) {
-		board_get_move_flip(&board, x, &move);
-		if (board_check_move(&board, &move)) {
-			board_update(&board, &move);
-			--expected_depth; 
-			tmp = expected_bound.upper; expected_bound.upper = -expected_bound.lower; expected_bound.lower = -tmp;
-			fail_low = !fail_low;
-			line_push(&result->pv, move.x);
-
-			hash_code = board_get_hash_code(&board);
-			if ((hash_get(&search->pv_table, &board, hash_code, &hash_data) || hash_get(&search->hash_table, &board, hash_code, &hash_data)) 
-			 && (hash_data.wl.c.depth >= expected_depth && hash_data.wl.c.selectivity >= expected_selectivity)
-			 && (hash_data.upper <= expected_bound.upper && hash_data.lower >= expected_bound.lower)) {
-				x = hash_data.move[0];
-			} else x = NOMOVE;
-			if (guess_pv && x == NOMOVE && fail_low) x = guess_move(search, &board);
-		} else x = NOMOVE;
-	}
+	get_pv(search, bestmove->x, *bound, depth, guess_pv, fail_low, &result->pv);
 
 	result->time = search_time(search);
 	result->n_nodes = search_count_nodes(search);
@@ -233,6 +251,72 @@ void record_best_move(Search *search, const Move *bestmove, const int alpha, con
 	if (has_changed && options.noise <= depth && search->options.verbosity == 3) search->observer(search->result);
 }
 
+/**
+ * @brief Record the score bounds of a root move, in multi-PV mode.
+ *
+ * @param search Search.
+ * @param move Searched move.
+ * @param alpha Alpha bound of the move search.
+ * @param beta Beta bound of the move search.
+ */
+static void record_move_bound(Search *search, const Move *move, const int alpha, const int beta)
+{
+	Result *result = search->result;
+	Bound *bound = result->bound + move->x;
+
+	spin_lock(result);
+	bound->lower = (move->score > alpha ? move->score : search->stability_bound.lower);
+	bound->upper = (move->score < beta ? move->score : search->stability_bound.upper);
+	spin_unlock(result);
+}
+
+/**
+ * @brief Record the multi-PV lines.
+ *
+ * The root moves are supposed to be sorted, the best ones first.
+ *
+ * @param search Search.
+ * @param depth Depth.
+ */
+static void record_multipv(Search *search, const int depth)
+{
+	Result *result = search->result;
+	const Move *move;
+	ResultLine *line;
+
+	spin_lock(result);
+	result->n_lines = 0;
+	foreach_move(move, search->movelist) {
+		if (result->n_lines == search->options.multipv) break;
+		line = result->line + result->n_lines++;
+		line->move = move->x;
+		line->score = move->score;
+		get_pv(search, move->x, result->bound[move->x], depth, false, false, &line->pv);
+	}
+	spin_unlock(result);
+}
+
+/**
+ * @brief Insert a score among the best scores, in decreasing order.
+ *
+ * @param best Best scores.
+ * @param n Number of best scores.
+ * @param n_max Maximal number of best scores.
+ * @param score Score to insert.
+ * @return the new number of best scores.
+ */
+static int multipv_insert(int *best, int n, const int n_max, const int score)
+{
+	int i;
+
+	if (n < n_max) ++n;
+	else if (score <= best[n - 1]) return n;
+	for (i = n - 1; i > 0 && best[i - 1] < score; --i) best[i] = best[i - 1];
+	best[i] = score;
+
+	return n;
+}
+
 void show_current_move(FILE *f, Search *search, const Move *move, const int alpha, const int beta, const bool parallel) {
 	char s[4];
 
@@ -334,6 +418,8 @@ int PVS_root(Search *search, const int alpha, const int beta, const int depth)
 	Eval eval0;
 	Board board0;
 	long long nodes_org = search_count_nodes(search);
+	const int multipv = search->options.multipv;
+	int best[MAX_MOVE], n_best = 0, multipv_alpha = alpha;
 	assert(alpha < beta);
 	assert(SCORE_MIN <= alpha && alpha <= SCORE_MAX);
 	assert(SCORE_MIN <= beta && beta <= SCORE_MAX);
@@ -381,16 +467,21 @@ int PVS_root(Search *search, const int alpha, const int beta, const int depth)
 			search->board = board0;
 			if (log_is_open(search_log)) show_current_move(search_log->f, search, move, alpha, beta, false);
 			node_update(&node, move);
+			if (multipv > 1) {
+				record_move_bound(search, move, alpha, beta);
+				n_best = multipv_insert(best, n_best, multipv, move->score);
+				if (n_best == multipv) multipv_alpha = MAX(multipv_alpha, best[multipv - 1]);
+			}
 			if (search->options.verbosity == 4) pv_debug(search, move, stdout);
 
 			search->time.can_update = true;
 
-			// other moves : try to refute the first/best one
+			// other moves : try to refute the first/best one (or the worst of the multipv best ones)
 			while ((move = node_next_move(&node))) {
-				const int alpha = depth > search->options.multipv_depth ? node.alpha : SCORE_MIN;
+				const int alpha = depth > search->options.multipv_depth ? (multipv > 1 ? multipv_alpha : node.alpha) : SCORE_MIN;
 
 				assert(board_check_move(&search->board, move));
-				if (depth > search->options.multipv_depth && node_split(&node, move)) {
+				if (depth > search->options.multipv_depth && multipv == 1 && node_split(&node, move)) {
 				} else {
 					search_update_midgame(search, move);
 						move->score = -search_route_PVS(search, -alpha - 1, -alpha, depth - 1, &node);
@@ -404,6 +495,11 @@ int PVS_root(Search *search, const int alpha, const int beta, const int depth)
 					search->board = board0;
 					if (log_is_open(search_log)) show_current_move(search_log->f, search, move, alpha, beta, false);
 					node_update(&node, move);
+					if (multipv > 1) {
+						record_move_bound(search, move, alpha, beta);
+						n_best = multipv_insert(best, n_best, multipv, move->score);
+						if (n_best == multipv) multipv_alpha = MAX(multipv_alpha, best[multipv - 1]);
+					}
 					assert(SCORE_MIN <= node.bestscore && node.bestscore <= SCORE_MAX);
 				}
 				if (search->options.verbosity == 4) pv_debug(search, move, stdout);
@@ -417,9 +513,10 @@ int PVS_root(Search *search, const int alpha, const int beta, const int depth)
 		hash_code = board_get_hash_code(&search->board);
 		hash_get(&search->pv_table, &search->board, hash_code, &hash_data.data);
 		if (movelist->n_moves) {	// 4.5.1
-			if (depth < search->options.multipv_depth) movelist_sort(movelist);
+			if (depth < search->options.multipv_depth || multipv > 1) movelist_sort(movelist);
 			else movelist_sort_cost(movelist, &hash_data.data);
 			movelist_sort_bestmove(movelist, node.bestmove);
+			if (multipv > 1) record_multipv(search, depth);
 		}
 		record_best_move(search, movelist_first(movelist), alpha, beta, depth);
 
@@ -478,8 +575,8 @@ int aspiration_search(Search *search, int alpha, int beta, const int depth, int
 		beta += (beta & 1);
 	}
 
-	// at shallow depths always use a large window, for better move ordering
-	if (depth <= search->options.multipv_depth) {
+	// at shallow depths (or to search several best moves) always use a large window, for better move ordering
+	if (depth <= search->options.multipv_depth || search->options.multipv > 1) {
 		alpha = SCORE_MIN;
 		beta = SCORE_MAX;
 	}
@@ -504,7 +601,7 @@ int aspiration_search(Search *search, int alpha, int beta, const int depth, int
 		old_score = score;
 
 		// if in multipv mode or the alphabeta window is already small, search directly
-		if (depth <= search->options.multipv_depth || beta - alpha <= 2 * width) {
+		if (depth <= search->options.multipv_depth || search->options.multipv > 1 || beta - alpha <= 2 * width) {
 			log_print(search_log, "direct root_PVS [%d, %d]:\n", low, high);
 			score = PVS_root(search, alpha, beta, depth);
 		} else { // otherwise iterate search with small windows until the score is bounded by the window, or a cut
@@ -611,6 +708,28 @@ static bool get_last_level(Search *search, int *depth, int *selectivity)
 }
 
 
+/**
+ * @brief Learn the time of a completed endgame iteration.
+ *
+ * The time predicted before learning it is logged, to follow the accuracy of
+ * the time model.
+ *
+ * @param search Search.
+ * @param n_nodes Number of nodes of the iteration.
+ * @param time Time of the iteration (in ms).
+ */
+static void record_endgame_iteration(Search *search, const unsigned long long n_nodes, const long long time)
+{
+	const int n_tasks = search_count_tasks(search);
+	const long long predicted = time_model_iteration_time(search->depth, search->selectivity, n_tasks);
+
+	if (predicted >= 0 && MAX(predicted, time) >= 10 && log_is_open(search_log)) {
+		lock(search_log);
+		log_print(search_log, "time model: level %d@%d%%: predicted = %.3fs, actual = %.3fs\n", search->depth, selectivity_table[search->selectivity].percent, 0.001 * predicted, 0.001 * time);
+		unlock(search_log);
+	}
+	if (options.nps <= 0) time_model_record(search->depth, search->selectivity, n_tasks, n_nodes, time);
+}
 
 /**
  * @brief Iterative deepening.
@@ -630,7 +749,8 @@ void iterative_deepening(Search *search, int alpha, int beta)
 	Move *bestmove, *move;
 	HashData hash_data;
 	int score, end, start;
-	long long t;
+	long long t, iteration_time;
+	unsigned long long iteration_nodes;
 	bool has_time;
 	int old_depth, old_selectivity, tmp_selectivity;
 
@@ -791,32 +911,33 @@ void iterative_deepening(Search *search, int alpha, int beta)
 			search->selectivity = search->options.selectivity;
 		}
 		if (search->selectivity == search->options.selectivity) search_adjust_time(search, true);
+		iteration_nodes = search_count_nodes(search);
+		iteration_time = search_time(search);
 		score = aspiration_search(search, alpha, beta, search->depth, score);
+		if (search->stop == RUNNING && search->depth == search->eval.n_empties) {
+			record_endgame_iteration(search, search_count_nodes(search) - iteration_nodes, search_time(search) - iteration_time);
+		}
 		if (!search_continue(search)) return;
 	}
 	if (search->selectivity > search->options.selectivity) search->selectivity = search->options.selectivity;
 }
 
 /**
- * @brief Search the bestmove of a given board.
+ * @brief Search the bestmove of a given board, once the search is running.
  *
- * this is a function runable within its own thread.
  * The board is supposed to have been set (by search_set_board()), and all
  * search options (level, time, etc.) too. this function proceeds to some
  * internal initialisations and then call the iterative deepening function, from
  * where the search is actually done. After the search ends, some finalizations
  * are done before the function returns.
  *
- * @param v Search cast as void.
+ * @param search Search.
  * @return The search result.
  */
-void* search_run(void *v)
+static Result* search_execute(Search *search)
 {
-	Search *search = (Search*) v;
 	Move *move;
 
-	search->stop = RUNNING;
-
 	//initialisations
 	search->n_nodes = 0;
 	search->child_nodes = 0;
@@ -835,6 +956,7 @@ void* search_run(void *v)
 	search->result->score = search_bound(search, search_eval_0(search));
 	search->result->n_moves_left = search->result->n_moves = search->movelist.n_moves;
 	search->result->book_move = false;
+	search->result->n_lines = 0;
 
 	if (!movelist_is_empty(&search->movelist)) {
 		foreach_move(move, search->movelist) {
@@ -868,7 +990,12 @@ void* search_run(void *v)
 		else if (search->stop == STOP_PARALLEL_SEARCH) log_print(search_log, "### BUG: stop parallel search reached root! ###");
 		else if (search->stop == RUNNING) log_print(search_log, "completed");
 		else log_print(search_log, "### BUG: unkwown stop condition %d ###", search->stop);
-		log_print(search_log, " ***\n\n");
+		log_print(search_log, " ***\n");
+		if (search->options.time < TIME_MAX && search->time.extra > 0) {
+			const long long spent = search_time(search);
+			log_print(search_log, "time allocation: alloted = %.3fs, spent = %.3fs, error = %+.1f%%\n", 0.001 * search->time.extra, 0.001 * spent, 100.0 * (spent - search->time.extra) / search->time.extra);
+		}
+		log_print(search_log, "\n");
 		unlock(search_log);
 	}
 
@@ -878,9 +1005,98 @@ void* search_run(void *v)
 
 	statistics_sum_nodes(search);
 	if (search->options.verbosity >= 3) statistics_print(stdout);
+	search_recorder_add(&search_recorder, search);
+	trace_buffer_flush(search->trace);
 
 	assert(search->height == 0);
 
 	return search->result;
 }
 
+/**
+ * @brief Search the bestmove of a given board.
+ *
+ * this is a function runable within its own thread (see search_execute()).
+ *
+ * @param v Search cast as void.
+ * @return The search result.
+ */
+void* search_run(void *v)
+{
+	Search *search = (Search*) v;
+
+	search->stop = RUNNING;
+	return search_execute(search);
+}
+
+/**
+ * @brief Run an asynchronous search, in its own thread.
+ *
+ * @param v Search cast as void.
+ * @return The search result.
+ */
+static void* search_run_async(void *v)
+{
+	Search *search = (Search*) v;
+	Result *result = search_execute(search);
+
+	search->is_running = false;
+	return result;
+}
+
+/**
+ * @brief Start an asynchronous search.
+ *
+ * The search is set running before its thread is created, so that a stop
+ * requested from now on is never lost. Each search_start() must be followed
+ * by a search_join().
+ *
+ * @param search Search.
+ */
+void search_start(Search *search)
+{
+	assert(!search->is_running);
+	search_set_state(search, RUNNING);
+	search->is_running = true;
+	thread_create(&search->thread, search_run_async, search);
+}
+
+/**
+ * @brief Poll an asynchronous search.
+ *
+ * @param search Search.
+ * @return true while the search runs.
+ */
+bool search_is_running(const Search *search)
+{
+	return search->is_running;
+}
+
+/**
+ * @brief Stop an asynchronous search, without waiting for it.
+ *
+ * The stop reaches the master search, its split slaves & their leaf solvers,
+ * that all poll their own stop flag, so that the search ends within
+ * STOP_LATENCY_MAX ms (see obf_stop_latency()).
+ *
+ * @param search Search.
+ * @param stop Source of stopping.
+ */
+void search_stop(Search *search, const Stop stop)
+{
+	if (search->is_running) search_stop_all(search, stop);
+}
+
+/**
+ * @brief Wait for the end of an asynchronous search.
+ *
+ * @param search Search.
+ * @return The search result.
+ */
+Result* search_join(Search *search)
+{
+	thread_join(search->thread);
+	assert(!search->is_running);
+	return search->result;
+}
+
@@ -62,6 +62,8 @@
 #include "bit.h"
 #include "options.h"
 #include "stats.h"
+#include "timemodel.h"
+#include "trace.h"
 #include "util.h"
 #include "ybwc.h"
 #include "settings.h"
@@ -343,6 +345,7 @@ void search_global_init(void)
 		LEVEL[level][n_empties].selectivity = sel;
 	}
 	search_log->f = NULL;
+	trace_init();
 }
 
 void search_resize_hashtable(Search *search) {
@@ -370,6 +373,7 @@ void search_init(Search *search)
 
 	/* running state */
 	search->stop = STOP_END;
+	search->is_running = false;
 
 	/* hash_table */
 	search->options.hash_size = 0;
@@ -391,6 +395,10 @@ void search_init(Search *search)
 	// radom generator
 	random_seed(&search->random, real_clock());
 
+	/* trace (opened before the tasks start) */
+	trace_open(options.trace_file);
+	search->trace = trace_buffer_create();
+
 	/* task stack */
 	search->tasks = (TaskStack*) malloc(sizeof (TaskStack));
 	if (search->tasks == NULL) {
@@ -399,6 +407,8 @@ void search_init(Search *search)
 	if (options.cpu_affinity) thread_set_cpu(thread_self(), 0);
 	task_stack_init(search->tasks, options.n_task);
 	search->allow_node_splitting = (search->tasks->n > 1);
+	search->tasks_limit = MAX_THREADS;
+	search->tasks_used = 0;
 
 	/* task associated with the current search */
 	search->task = search->tasks->task;
@@ -443,6 +453,7 @@ void search_init(Search *search)
 	search->options.separator = NULL;
 	search->options.guess_pv = options.pv_guess;
 	search->options.multipv_depth = MULTIPV_DEPTH;
+	search->options.multipv = 1;
 
 	log_open(search_log, options.search_log_file);
 }
@@ -468,9 +479,84 @@ void search_free(Search *search)
 	spin_free(search->result);
 	free(search->result);
 
+	trace_buffer_free(search->trace);
+	trace_close();
 	log_close(search_log);
 }
 
+/**
+ * @brief Init a search sharing the hash tables & the tasks of a main search.
+ *
+ * Such a search runs alongside the main search (to ponder on several moves,
+ * for example), each one taking at most tasks_limit tasks from the shared
+ * task stack.
+ *
+ * @param search Search.
+ * @param master Main search.
+ */
+void search_init_shared(Search *search, Search *master)
+{
+	search->id = master->id;
+	search->stop = STOP_END;
+	search->is_running = false;
+	search->board.player = search->board.opponent = 0;
+	search->player = EMPTY;
+	random_seed(&search->random, real_clock());
+
+	search->task = NULL;
+	search->parent = NULL;
+	search->n_child = 0;
+	search->master = search;
+	search->tasks_limit = MAX_THREADS;
+	search->tasks_used = 0;
+	spin_init(search);
+
+	search->result = (Result*) malloc(sizeof (Result));
+	if (search->result == NULL) {
+		fatal_error("Cannot allocate a search result\n");
+	}
+	spin_init(search->result);
+	search->result->move = NOMOVE;
+	search->n_nodes = 0;
+	search->child_nodes = 0;
+	search->trace = trace_buffer_create();
+
+	search_update_shared(search, master);
+}
+
+/**
+ * @brief Share again the hash tables, the tasks & the options of a main search.
+ *
+ * To be called before each search, as the main search may have resized its
+ * hash tables or its task stack since.
+ *
+ * @param search Search initialized by search_init_shared().
+ * @param master Main search.
+ */
+void search_update_shared(Search *search, Search *master)
+{
+	search->hash_table = master->hash_table;
+	search->pv_table = master->pv_table;
+	search->shallow_table = master->shallow_table;
+	search->tasks = master->tasks;
+	search->allow_node_splitting = master->allow_node_splitting;
+	search->observer = master->observer;
+	search->options = master->options;
+}
+
+/**
+ * @brief Free a search initialized by search_init_shared().
+ *
+ * @param search Search.
+ */
+void search_free_shared(Search *search)
+{
+	spin_free(search);
+	spin_free(search->result);
+	free(search->result);
+	trace_buffer_free(search->trace);
+}
+
 /**
  * @brief Set up various structure once the board has been set.
  *
@@ -634,6 +720,8 @@ void search_set_ponder_level(Search *search, const int level, const int n_emptie
  * This is a very approximate computation... 
  * SMP_W & SMP_C depends on the depth and the position.
  * The branching factor depends also of the position. 
+ * Once the time model has learned them on this host, its predicted solving
+ * time is used instead.
  *
  * @param limit Time limit in ms.
  * @param n_tasks Number of parallel tasks.
@@ -643,7 +731,15 @@ int solvable_depth(const long long limit, int n_tasks)
 {
 	int d;
 	long long t;
-	double speed = 0.001 * (options.speed * (SMP_W + SMP_C) / (SMP_W / n_tasks + SMP_C));
+	double speed;
+
+	if (time_model_solve_time(15, n_tasks) >= 0) {
+		for (d = 15; d < 60 && time_model_solve_time(d + 1, n_tasks) <= limit; ++d) ;
+		return d;
+	}
+
+	speed = time_model_speed(n_tasks);
+	if (speed <= 0.0) speed = 0.001 * (options.speed * (SMP_W + SMP_C) / (SMP_W / n_tasks + SMP_C));
 
 	for (t = 0.0, d = 15; d <= 60 && t <= limit; ++d) {
 		t += pow(BRANCHING_FACTOR, d) / speed;
@@ -651,6 +747,30 @@ int solvable_depth(const long long limit, int n_tasks)
 	return d - 1;
 }
 
+/**
+ * @brief Time for the next move, when the time is given for the whole game.
+ *
+ * The remaining time is shared between the moves to play before the position
+ * is solvable with 10% of it, once the predicted solving time is kept.
+ *
+ * @param t Remaining time in ms.
+ * @param n_empties Number of empty squares.
+ * @param n_tasks Number of parallel tasks.
+ * @param sd Solvable depth (output).
+ * @param d Number of moves to play before solving (output).
+ * @return time in ms.
+ */
+static long long game_move_time(long long t, const int n_empties, const int n_tasks, int *sd, int *d)
+{
+	long long solve;
+
+	*sd = solvable_depth(t / 10, n_tasks); // depth solvable with 10% of the time
+	*d = MAX((n_empties - *sd) / 2, 2); // unsolvable ply to play
+	solve = (n_empties > *sd) ? time_model_solve_time(*sd, n_tasks) : -1;
+	if (solve > 0) t -= MIN(solve, t / 10);
+	return MAX(t / *d - 10, 100); // keep 0.25 s./remaining move, make at least 0.1 s available
+}
+
 /**
  * @brief set time to search.
  *
@@ -697,10 +817,8 @@ void search_time_init(Search *search)
 			info("<Time-alloted: mini = %.2f; maxi = %.2f; extra = %.2f>\n", 0.001 * search->time.mini,  0.001 * search->time.maxi,  0.001 * search->time.extra);
 		}
 	} else {
-		long long t = search->options.time;
-		const int sd = solvable_depth(t / 10, search_count_tasks(search)); // depth solvable with 10% of the time
-		const int d = MAX((search->eval.n_empties - sd) / 2, 2); // unsolvable ply to play
-		t = MAX(t / d - 10, 100); // keep 0.25 s./remaining move, make at least 1s. available
+		int sd, d;
+		const long long t = game_move_time(search->options.time, search->eval.n_empties, search_count_tasks(search), &sd, &d);
 		search->time.extra = t;
 		search->time.maxi = t * 3 / 4;
 		search->time.mini = t / 4;
@@ -711,6 +829,7 @@ void search_time_init(Search *search)
 	}
 	search->time.extended = false;
 	search->time.can_update = true;
+	search->time.n_extensions = 0;
 }
 
 /**
@@ -735,10 +854,8 @@ void search_time_reset(Search *search, const Board *initial_board)
 			info("<Time-alloted: mini = %.2f; maxi = %.2f; extra = %.2f>\n", 0.001 * search->time.mini,  0.001 * search->time.maxi,  0.001 * search->time.extra);
 		}
 	} else {
-		long long t = search->options.time;
-		const int sd = solvable_depth(t / 10, search_count_tasks(search)); // depth solvable with 10% of the time
-		const int d = MAX((n_empties - sd) / 2, 2); // unsolvable ply to play
-		t = MAX(t / d - 10, 100); // keep 0.25 s./remaining move, make at least 0.1 s available
+		int sd, d;
+		const long long t = game_move_time(search->options.time, n_empties, search_count_tasks(search), &sd, &d);
 		search->time.extra = spent + t;
 		search->time.maxi = spent + t * 3 / 4;
 		search->time.mini = spent + t / 4;
@@ -768,6 +885,7 @@ void search_adjust_time(Search *search, const bool once)
 		search->time.maxi = MIN(search->time.mini * 4 / 3, t);
 		search->time.extra = MIN(search->time.maxi * 4 / 3, t);
 		search->time.extended = once;
+		if (search->options.time < TIME_MAX) ++search->time.n_extensions;
 		if (search->options.verbosity >= 2) {
 			info("\n<Time-adjusted: mini = %.2f; maxi = %.2f; extra = %.2f>\n", 0.001 * search->time.mini,  0.001 * search->time.maxi,  0.001 * search->time.extra);
 		}
@@ -1094,12 +1212,15 @@ void search_set_observer(Search *search, void (*observer)(Result*))
 }
 
 /**
- * @brief Print the current search result.
+ * @brief Print a line of the current search result.
  *
  * @param result Last search result.
+ * @param move First move of the line.
+ * @param score Score of the line.
+ * @param pv Principal variation of the line.
  * @param f output stream.
  */
-void result_print(Result *result, FILE *f)
+static void result_print_line(const Result *result, const int move, const int score, const Line *pv, FILE *f)
 {
 	char bound;
 #ifdef _WIN32
@@ -1108,23 +1229,45 @@ void result_print(Result *result, FILE *f)
 	const int PRINTED_WIDTH = 52;
 #endif
 
-	spin_lock(result);
-
-	if (result->bound[result->move].lower < result->score && result->score == result->bound[result->move].upper) bound = '<';
-	else if (result->bound[result->move].lower == result->score && result->score < result->bound[result->move].upper) bound = '>';
-	else if (result->bound[result->move].lower == result->score && result->score == result->bound[result->move].upper) bound = ' ';
+	if (result->bound[move].lower < score && score == result->bound[move].upper) bound = '<';
+	else if (result->bound[move].lower == score && score < result->bound[move].upper) bound = '>';
+	else if (result->bound[move].lower == score && score == result->bound[move].upper) bound = ' ';
 	else bound = '?';
 
 	if (result->selectivity < 5) fprintf(f, "%2d@%2d%% ", result->depth, selectivity_table[result->selectivity].percent);
 	else fprintf(f, "   %2d  ", result->depth);
-	fprintf(f, "%c%+03d ", bound, result->score);
+	fprintf(f, "%c%+03d ", bound, score);
 	time_print(result->time, true, f);
 	if (result->n_nodes) {
 		fprintf(f, " %13lld ", result->n_nodes);
 		if (result->time > 0) fprintf(f, "%10.0f ", 1000.0 * result->n_nodes / result->time);
 		else fprintf(f, "           ");
 	} else fputs("                          ", f);
-	line_print(&result->pv, options.width - PRINTED_WIDTH, " ", f);
+	line_print(pv, options.width - PRINTED_WIDTH, " ", f);
+}
+
+/**
+ * @brief Print the current search result.
+ *
+ * In multi-PV mode, a line is printed for each of the best moves.
+ *
+ * @param result Last search result.
+ * @param f output stream.
+ */
+void result_print(Result *result, FILE *f)
+{
+	int i;
+
+	spin_lock(result);
+
+	if (result->n_lines > 1) {
+		for (i = 0; i < result->n_lines; ++i) {
+			if (i) putc('\n', f);
+			result_print_line(result, result->line[i].move, result->line[i].score, &result->line[i].pv, f);
+		}
+	} else {
+		result_print_line(result, result->move, result->score, &result->pv, f);
+	}
 	fflush(f);
 
 	spin_unlock(result);
@@ -1339,12 +1482,14 @@ void search_share(const Search *src, Search *dest)
 /**
  * @brief Count the number of tasks used in parallel search.
  *
+ * A search sharing its task stack only uses its own limit of helper tasks.
+ *
  * @param search Search.
  * @return number of tasks.
  */
 int search_count_tasks(const Search *search)
 {
-	return search->tasks->n;
+	return MIN(search->tasks->n, search->tasks_limit + 1);
 }
 
 /**
@@ -38,6 +38,13 @@ typedef struct Bound {
 	int upper;
 } Bound;
 
+/** A line of a multi-PV result */
+typedef struct ResultLine {
+	int move;                    /**< first move */
+	int score;                   /**< score of the move */
+	Line pv;                     /**< principal variation */
+} ResultLine;
+
 /** Result */
 typedef struct Result {
 	int depth;                   /**< searched depth */
@@ -51,9 +58,19 @@ typedef struct Result {
 	bool book_move;              /**< book move origin */
 	int n_moves;                 /**< total moves to search */
 	int n_moves_left;            /**< left moves to search */
+	int n_lines;                 /**< number of multi-PV lines */
+	ResultLine line[MAX_MOVE];   /**< multi-PV lines, best first */
 	SpinLock spin;
 } Result;
 
+/** Deviation of the 8-bit evaluation from the 16-bit one */
+typedef struct EvalError {
+	unsigned long long n;        /**< number of evaluated positions */
+	double sum;                  /**< sum of absolute errors (in discs) */
+	double sum2;                 /**< sum of squared errors */
+	double max;                  /**< maximal absolute error */
+} EvalError;
+
 /** levels */
 extern struct Level {
 	unsigned char depth;         /** search depth */
@@ -92,12 +109,17 @@ typedef struct Search {
 	int probcut_level;                            /**< probcut recursivity level */
 	int depth_pv_extension;                       /**< depth for pv_extension */
 	volatile Stop stop;                           /**< thinking status */
+	Thread thread;                                /**< thread of an asynchronous search */
+	volatile bool is_running;                     /**< true while an asynchronous search runs */
 	bool allow_node_splitting;                    /**< allow parallelism */
+	int tasks_limit;                              /**< maximal number of tasks taken from the (shared) task stack */
+	int tasks_used;                               /**< number of tasks taken from the task stack */
 	struct {
 		long long  extra;                         /**< extra alloted time */
 		volatile long long spent;                 /**< time spent thinking */
 		bool extended;                            /**< flag to extend time only once */
 		bool can_update;                          /**< flag allowing to extend time */
+		int n_extensions;                         /**< number of time extensions */
 		long long  mini;                          /**< minimal alloted time */
 		long long  maxi;                          /**< maximal alloted time */
 	} time;                                       /**< time */
@@ -117,10 +139,12 @@ typedef struct Search {
 		const char *separator;                    /**< separator for search output */
 		bool guess_pv;                            /**< guess PV (in cassio mode only) */
 		int multipv_depth;                        /**< multi PV depth */
+		int multipv;                              /**< number of best moves to search exactly */
 		int hash_size;                            /**< hashtable size */
 	} options;                                    /**< local (threadable) options. */
 
 	Result *result;                               /**< shared result */
+	struct TraceBuffer *trace;                    /**< search-tree trace buffer (NULL if off) */
 
 	void (*observer)(Result*);                    /**< call back function to print search result */
 } Search;
@@ -139,6 +163,9 @@ extern const unsigned char SQUARE_TYPE[];
 void search_global_init(void);
 void search_init(Search*);
 void search_free(Search*);
+void search_init_shared(Search*, Search*);
+void search_update_shared(Search*, Search*);
+void search_free_shared(Search*);
 void search_cleanup(Search*);
 void search_setup(Search*);
 void search_clone(Search*, Search*);
@@ -189,9 +216,13 @@ int board_solve(const unsigned long long, const int);
 int search_solve(const Search*);
 int search_solve_0(const Search*);
 int board_score_1(unsigned long long, int, int);
+int search_solve_4(Search*, int);
+int search_shallow(Search*, const int, bool);
 int NWS_endgame(Search*, const int);
 
 int search_eval_0(Search*);
+void eval_error_add(EvalError*, const Board*);
+void eval_error_print(const EvalError*, const char*, FILE*);
 int search_eval_1(Search*, int, int, unsigned long long);
 int search_eval_2(Search*, int, int, unsigned long long);
 int NWS_midgame(Search*, const int, int, struct Node*);
@@ -205,6 +236,10 @@ int PVS_root(Search*, const int, const int, const int);
 int aspiration_search(Search*, int, int, const int, int);
 void iterative_deepening(Search*, int, int);
 void* search_run(void*);
+void search_start(Search*);
+bool search_is_running(const Search*);
+void search_stop(Search*, const Stop);
+Result* search_join(Search*);
 int search_guess(Search*, const Board*);
 void search_stop_all(Search*, const Stop);
 void search_set_state(Search*, const Stop);
@@ -165,5 +165,18 @@
 /** multi_pv depth */
 #define MULTIPV_DEPTH 10
 
+/** Maximal delay (in ms) between a stop request & the end of a search. */
+#define STOP_LATENCY_MAX 50
+
+/** Tasks & concurrent searches of the stop latency test (see obf_stop_latency()). */
+#define STOP_TEST_TASKS 4
+#define STOP_TEST_SEARCHES 3
+
+/** Maximal number of opponent replies pondered at once. */
+#define PONDER_MAX_CANDIDATES 8
+
+/** Score difference (in discs) dividing by e the likelihood of a pondered reply. */
+#define PONDER_TEMPERATURE 4.0
+
 #endif /* EDAX_SETTINGS_H */
 
@@ -98,8 +98,9 @@ void statistics_sum_nodes(Search *search)
 {
 	int i;
 
-	statistics.n_parallel_nodes += search->child_nodes;
-	statistics.n_nodes += search->n_nodes;
+	// atomic, as several searches may end at once
+	atomic_add(&statistics.n_parallel_nodes, search->child_nodes);
+	atomic_add(&statistics.n_nodes, search->n_nodes);
 	for (i = 0; i < search->tasks->n; ++i) {
 		statistics.n_task_nodes[i] = search->tasks->task[i].n_nodes;
 		statistics.n_task[i] = search->tasks->task[i].n_calls;
@@ -0,0 +1,262 @@
+/**
+ * @file timemodel.c
+ *
+ * Learned time model.
+ *
+ * The time to solve a position is estimated from the nodes & the time of the
+ * endgame iterations completed by previous searches on this host, instead of
+ * fixed constants (BRANCHING_FACTOR, SMP_W, SMP_C & options.speed):
+ *   - for each selectivity, log(nodes) of an iteration is fitted as a line of
+ *     the number of empties, which gives the effective branching factor;
+ *   - the time per node is fitted as a line of 1 / tasks (Amdahl's law), which
+ *     gives the parallel efficiency. With a single number of tasks observed,
+ *     the default SMP_W & SMP_C shape is scaled to the observed speed.
+ * Old samples are slowly forgotten, so the model follows changes of the host
+ * or of the engine. The model is read from a small text file, and, when
+ * learning is on, updated with the completed searches & saved back on exit.
+ *
+ * @date 2026
+ * @author agent
+ * @version 4.5
+ */
+
+#include "timemodel.h"
+
+#include "const.h"
+#include "settings.h"
+#include "util.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/** selectivity levels (NO_SELECTIVITY + 1) */
+#define TIME_MODEL_N_SELECTIVITY 6
+
+/** weight kept by past samples at each new sample */
+#define TIME_MODEL_DECAY 0.99
+
+/** minimal (weighted) number of samples of a fit */
+#define TIME_MODEL_MIN_SAMPLES 8.0
+
+/** minimal time (in ms) of a recorded iteration: shorter ones are too noisy */
+#define TIME_MODEL_MIN_TIME 20
+
+/** weighted sums of a least-square line fit */
+typedef struct TimeFit {
+	double n, x, y, xx, xy;
+} TimeFit;
+
+/** the time model */
+static struct {
+	TimeFit solve[TIME_MODEL_N_SELECTIVITY];  /**< log(nodes) of an endgame iteration vs empties */
+	TimeFit smp;                              /**< time per node vs 1 / tasks */
+	char *file;                               /**< file to save the model in */
+	bool modified;                            /**< new samples to save */
+	bool learn;                               /**< record new samples & save them */
+	bool is_open;                             /**< model in use */
+	Lock lock;                                /**< lock */
+} time_model;
+
+/**
+ * @brief Add a sample to a line fit.
+ *
+ * @param f Line fit.
+ * @param x Sample abscissa.
+ * @param y Sample ordinate.
+ */
+static void fit_add(TimeFit *f, const double x, const double y)
+{
+	f->n  = f->n  * TIME_MODEL_DECAY + 1.0;
+	f->x  = f->x  * TIME_MODEL_DECAY + x;
+	f->y  = f->y  * TIME_MODEL_DECAY + y;
+	f->xx = f->xx * TIME_MODEL_DECAY + x * x;
+	f->xy = f->xy * TIME_MODEL_DECAY + x * y;
+}
+
+/**
+ * @brief Fit the line y = a + b.x
+ *
+ * @param f Line fit.
+ * @param min_variance Minimal variance of the abscissa to fit a slope.
+ * @param a Intercept (output).
+ * @param b Slope (output).
+ * @return false if the samples are too few or too close.
+ */
+static bool fit_line(const TimeFit *f, const double min_variance, double *a, double *b)
+{
+	double mx, my, variance;
+
+	if (f->n < TIME_MODEL_MIN_SAMPLES) return false;
+	mx = f->x / f->n;
+	my = f->y / f->n;
+	variance = f->xx / f->n - mx * mx;
+	if (variance < min_variance) return false;
+	*b = (f->xy / f->n - mx * my) / variance;
+	*a = my - *b * mx;
+	return true;
+}
+
+/**
+ * @brief Open the time model.
+ *
+ * Read the model saved by a previous session, if any.
+ *
+ * @param file Model file, or NULL to keep the fixed time constants.
+ * @param learn Learn from the completed searches & save the model on close.
+ */
+void time_model_open(const char *file, const bool learn)
+{
+	FILE *f;
+	TimeFit fit;
+	char line[256];
+	int s;
+
+	time_model.modified = time_model.is_open = false;
+	time_model.learn = learn;
+	if (file == NULL) return;
+
+	lock_init(&time_model);
+	time_model.file = string_duplicate(file);
+	time_model.is_open = true;
+
+	f = fopen(file, "r");
+	if (f == NULL) return;
+	while (fgets(line, sizeof line, f)) {
+		if (sscanf(line, "solve %d %lf %lf %lf %lf %lf", &s, &fit.n, &fit.x, &fit.y, &fit.xx, &fit.xy) == 6) {
+			if (0 <= s && s < TIME_MODEL_N_SELECTIVITY) time_model.solve[s] = fit;
+		} else if (sscanf(line, "smp %lf %lf %lf %lf %lf", &fit.n, &fit.x, &fit.y, &fit.xx, &fit.xy) == 5) {
+			time_model.smp = fit;
+		}
+	}
+	fclose(f);
+}
+
+/**
+ * @brief Close the time model.
+ *
+ * Save the model if learning is on & it learned new samples.
+ */
+void time_model_close(void)
+{
+	FILE *f;
+	int s;
+
+	if (!time_model.is_open) return;
+
+	if (time_model.modified) {
+		f = fopen(time_model.file, "w");
+		if (f == NULL) {
+			warn("Cannot save the time model to %s\n", time_model.file);
+		} else {
+			fprintf(f, "# Edax time model: n, sum x, sum y, sum x^2, sum x.y\n");
+			fprintf(f, "# solve <selectivity>: x = empties, y = log(nodes) of an endgame iteration\n");
+			fprintf(f, "# smp: x = 1 / tasks, y = ms per node\n");
+			for (s = 0; s < TIME_MODEL_N_SELECTIVITY; ++s) {
+				const TimeFit *fit = time_model.solve + s;
+				fprintf(f, "solve %d %.17g %.17g %.17g %.17g %.17g\n", s, fit->n, fit->x, fit->y, fit->xx, fit->xy);
+			}
+			fprintf(f, "smp %.17g %.17g %.17g %.17g %.17g\n", time_model.smp.n, time_model.smp.x, time_model.smp.y, time_model.smp.xx, time_model.smp.xy);
+			fclose(f);
+		}
+	}
+
+	free(time_model.file);
+	lock_free(&time_model);
+	time_model.is_open = false;
+}
+
+/**
+ * @brief Record a completed endgame iteration.
+ *
+ * @param n_empties Number of empty squares (= depth) of the iteration.
+ * @param selectivity Selectivity of the iteration.
+ * @param n_tasks Number of parallel tasks.
+ * @param n_nodes Number of nodes of the iteration.
+ * @param time Time of the iteration (in ms).
+ */
+void time_model_record(const int n_empties, const int selectivity, const int n_tasks, const unsigned long long n_nodes, const long long time)
+{
+	if (!time_model.is_open || !time_model.learn || time < TIME_MODEL_MIN_TIME || n_nodes == 0) return;
+	if (selectivity < 0 || selectivity >= TIME_MODEL_N_SELECTIVITY) return;
+
+	lock(&time_model);
+		fit_add(time_model.solve + selectivity, n_empties, log((double) n_nodes));
+		fit_add(&time_model.smp, 1.0 / n_tasks, (double) time / n_nodes);
+		time_model.modified = true;
+	unlock(&time_model);
+}
+
+/**
+ * @brief Learned search speed.
+ *
+ * @param n_tasks Number of parallel tasks.
+ * @return speed in nodes per ms, or 0 if not learned yet.
+ */
+double time_model_speed(const int n_tasks)
+{
+	double a, b, y = 0.0;
+
+	if (!time_model.is_open) return 0.0;
+
+	lock(&time_model);
+		if (time_model.smp.n >= TIME_MODEL_MIN_SAMPLES) {
+			if (!fit_line(&time_model.smp, 1e-3, &a, &b) || (y = a + b / n_tasks) <= 0.0) {
+				// too few task numbers observed: Amdahl's law with the default parallel work
+				const double x0 = time_model.smp.x / time_model.smp.n;
+				y = time_model.smp.y / time_model.smp.n * (SMP_W / n_tasks + SMP_C) / (SMP_W * x0 + SMP_C);
+			}
+		}
+	unlock(&time_model);
+
+	return y > 0.0 ? 1.0 / y : 0.0;
+}
+
+/**
+ * @brief Predict the time of an endgame iteration.
+ *
+ * @param n_empties Number of empty squares.
+ * @param selectivity Selectivity of the iteration.
+ * @param n_tasks Number of parallel tasks.
+ * @return time in ms, or -1 if not learned yet.
+ */
+long long time_model_iteration_time(const int n_empties, const int selectivity, const int n_tasks)
+{
+	const double speed = time_model_speed(n_tasks);
+	double a, b;
+	bool ok;
+
+	if (speed <= 0.0 || selectivity < 0 || selectivity >= TIME_MODEL_N_SELECTIVITY) return -1;
+
+	lock(&time_model);
+		ok = fit_line(time_model.solve + selectivity, 1.0, &a, &b);
+	unlock(&time_model);
+	if (!ok) return -1;
+
+	b = MAX(0.4, MIN(b, 1.4)); // branching factor within [1.5, 4.0]
+	return (long long) MIN(exp(a + b * n_empties) / speed, (double) TIME_MAX);
+}
+
+/**
+ * @brief Predict the time to solve a position.
+ *
+ * Sum of the predicted iterations at each learned selectivity, up to the
+ * exact one. As in iterative_deepening(), the selective iterations are skipped
+ * below 18 + 3 * selectivity empties.
+ *
+ * @param n_empties Number of empty squares.
+ * @param n_tasks Number of parallel tasks.
+ * @return time in ms, or -1 if not learned yet.
+ */
+long long time_model_solve_time(const int n_empties, const int n_tasks)
+{
+	long long t, sum;
+	int s;
+
+	sum = time_model_iteration_time(n_empties, TIME_MODEL_N_SELECTIVITY - 1, n_tasks);
+	if (sum < 0) return -1;
+	for (s = 0; s < TIME_MODEL_N_SELECTIVITY - 1 && (s == 0 || n_empties >= 18 + 3 * s); ++s) {
+		t = time_model_iteration_time(n_empties, s, n_tasks);
+		if (t > 0) sum = MIN(sum + t, TIME_MAX);
+	}
+	return sum;
+}
@@ -0,0 +1,23 @@
+/**
+ * @file timemodel.h
+ *
+ * Learned time model header.
+ *
+ * @date 2026
+ * @author agent
+ * @version 4.5
+ */
+
+#ifndef EDAX_TIMEMODEL_H
+#define EDAX_TIMEMODEL_H
+
+#include <stdbool.h>
+
+void time_model_open(const char*, const bool);
+void time_model_close(void);
+void time_model_record(const int, const int, const int, const unsigned long long, const long long);
+double time_model_speed(const int);
+long long time_model_iteration_time(const int, const int, const int);
+long long time_model_solve_time(const int, const int);
+
+#endif
@@ -0,0 +1,307 @@
+/**
+ * @file trace.c
+ *
+ * @brief Binary search-tree trace.
+ *
+ * Unlike the search log, the trace records the search tree itself, in a
+ * compact binary form cheap enough to be enabled under load: each thread
+ * appends fixed-size events (node entries & exits, splits & joins) to a block
+ * of its own buffer, without lock. A full block is queued to a writer thread,
+ * which writes it to the trace file & recycles it, while the search thread
+ * goes on with a free block: the search threads only take the lock of the
+ * trace to swap blocks, and only wait for the file I/O when TRACE_MAX_QUEUED
+ * blocks are already waiting to be written. The trace file starts with the
+ * TRACE_MAGIC string, followed by the raw TraceEvent structures. Events of a
+ * same thread are in order, but the blocks of the threads are interleaved.
+ * The trace_summary tool (see trace_summary.c) summarizes a trace file.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#include "trace.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/time.h>
+#endif
+
+/** Trace file, shared by all the threads */
+static struct {
+	FILE *f;                       /**< trace file */
+	int n_users;                   /**< number of searches using the trace */
+	bool used[TRACE_MAX_THREADS];  /**< thread ids in use */
+	TraceBlock *first;             /**< first block to write */
+	TraceBlock *last;              /**< last block to write */
+	TraceBlock *free_list;         /**< free blocks */
+	int n_queued;                  /**< number of blocks to write */
+	bool stop;                     /**< true to stop the writer thread */
+	Thread writer;                 /**< writer thread */
+	unsigned long long origin;     /**< time origin (in microseconds) */
+	Lock lock;                     /**< lock */
+	Condition cond;                /**< condition */
+} search_trace;
+
+/**
+ * @brief Measure wall clock time.
+ *
+ * @return time in microseconds.
+ */
+unsigned long long trace_clock(void)
+{
+#if defined(_WIN32)
+	return GetTickCount() * 1000ULL - search_trace.origin;
+#elif _POSIX_TIMERS > 0
+	struct timespec tv;
+	clock_gettime(CLOCK_MONOTONIC, &tv);
+	return tv.tv_sec * 1000000ULL + tv.tv_nsec / 1000ULL - search_trace.origin;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000ULL + tv.tv_usec - search_trace.origin;
+#endif
+}
+
+/**
+ * @brief Initialize the trace.
+ *
+ * The lock is initialized once, for the whole program, as several searches
+ * may open & close the trace concurrently.
+ */
+void trace_init(void)
+{
+	static bool is_init = false;
+
+	if (!is_init) {
+		lock_init(&search_trace);
+		condition_init(&search_trace);
+		is_init = true;
+	}
+}
+
+/**
+ * @brief Write the queued blocks to the trace file.
+ *
+ * The writer thread takes the whole queue at once, writes it without holding
+ * the lock, then puts the written blocks into the free list & wakes up the
+ * search threads waiting for a free block. It leaves once asked to stop and
+ * the queue is empty.
+ *
+ * @param v Unused.
+ * @return NULL.
+ */
+static void* trace_write(void *v)
+{
+	TraceBlock *list, *block, *last;
+	int n;
+
+	(void) v;
+	lock(&search_trace);
+	for (;;) {
+		while (search_trace.first == NULL && !search_trace.stop) condition_wait(&search_trace);
+		list = search_trace.first;
+		if (list == NULL) break;
+		search_trace.first = search_trace.last = NULL;
+		unlock(&search_trace);
+
+		n = 0;
+		for (block = last = list; block; block = block->next) {
+			fwrite(block->event, sizeof (TraceEvent), block->n, search_trace.f);
+			last = block;
+			++n;
+		}
+
+		lock(&search_trace);
+		last->next = search_trace.free_list;
+		search_trace.free_list = list;
+		search_trace.n_queued -= n;
+		condition_broadcast(&search_trace);
+	}
+	unlock(&search_trace);
+
+	return NULL;
+}
+
+/**
+ * @brief Get a free block, or allocate a new one.
+ *
+ * Called under the lock of the trace.
+ *
+ * @return a block, or NULL if out of memory.
+ */
+static TraceBlock* trace_block_get(void)
+{
+	TraceBlock *block = search_trace.free_list;
+
+	if (block) search_trace.free_list = block->next;
+	else block = (TraceBlock*) malloc(sizeof (TraceBlock));
+	if (block) block->n = 0;
+
+	return block;
+}
+
+/**
+ * @brief Open the trace file.
+ *
+ * Several searches may open the trace: the file is opened, and the writer
+ * thread started, by the first one, and both are closed by the last one.
+ *
+ * @param file Trace file name (if NULL, the trace is off).
+ */
+void trace_open(const char *file)
+{
+	if (file == NULL) return;
+
+	lock(&search_trace);
+	if (search_trace.n_users++ == 0) {
+		search_trace.f = fopen(file, "wb");
+		if (search_trace.f == NULL) {
+			warn("cannot open trace file %s\n", file);
+		} else {
+			fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), search_trace.f);
+			memset(search_trace.used, 0, sizeof search_trace.used);
+			search_trace.first = search_trace.last = NULL;
+			search_trace.n_queued = 0;
+			search_trace.stop = false;
+			search_trace.origin = 0;
+			search_trace.origin = trace_clock();
+			thread_create(&search_trace.writer, trace_write, NULL);
+		}
+	}
+	unlock(&search_trace);
+}
+
+/**
+ * @brief Close the trace file.
+ *
+ * The last user waits for the writer thread to write the queued blocks
+ * before closing the file.
+ */
+void trace_close(void)
+{
+	TraceBlock *block;
+
+	lock(&search_trace);
+	if (search_trace.n_users > 0 && --search_trace.n_users == 0 && search_trace.f) {
+		search_trace.stop = true;
+		condition_broadcast(&search_trace);
+		unlock(&search_trace);
+
+		thread_join(search_trace.writer);
+
+		lock(&search_trace);
+		fclose(search_trace.f);
+		search_trace.f = NULL;
+		while ((block = search_trace.free_list) != NULL) {
+			search_trace.free_list = block->next;
+			free(block);
+		}
+	}
+	unlock(&search_trace);
+}
+
+/**
+ * @brief Create the event buffer of a thread.
+ *
+ * The buffer gets the smallest thread id not used by another buffer, so that
+ * the ids stay below TRACE_MAX_THREADS while the searches come & go.
+ *
+ * @return a new buffer, or NULL if the trace is off.
+ */
+TraceBuffer* trace_buffer_create(void)
+{
+	TraceBuffer *buffer;
+	int i;
+
+	buffer = (TraceBuffer*) malloc(sizeof (TraceBuffer));
+	if (buffer == NULL) {
+		warn("cannot allocate a trace buffer\n");
+		return NULL;
+	}
+
+	lock(&search_trace);
+	if (search_trace.f == NULL) {
+		unlock(&search_trace);
+		free(buffer);
+		return NULL;
+	}
+	for (i = 0; i < TRACE_MAX_THREADS && search_trace.used[i]; ++i) ;
+	buffer->block = i < TRACE_MAX_THREADS ? trace_block_get() : NULL;
+	if (buffer->block) search_trace.used[i] = true;
+	unlock(&search_trace);
+
+	if (buffer->block == NULL) {
+		if (i < TRACE_MAX_THREADS) warn("cannot allocate a trace buffer\n");
+		else warn("too many traced threads (%d)\n", TRACE_MAX_THREADS);
+		free(buffer);
+		return NULL;
+	}
+	buffer->event = buffer->block->event;
+	buffer->n = 0;
+	buffer->thread = i;
+
+	return buffer;
+}
+
+/**
+ * @brief Flush the events of a buffer to the trace file.
+ *
+ * The full block is queued to the writer thread, and replaced by a free one.
+ * The events are lost if the trace is closed or out of memory.
+ *
+ * @param buffer Trace buffer.
+ */
+void trace_buffer_flush(TraceBuffer *buffer)
+{
+	TraceBlock *block;
+
+	if (buffer == NULL || buffer->n == 0) return;
+
+	lock(&search_trace);
+	if (search_trace.f) {
+		while (search_trace.n_queued >= TRACE_MAX_QUEUED) condition_wait(&search_trace);
+		block = trace_block_get();
+		if (block) {
+			buffer->block->n = buffer->n;
+			buffer->block->next = NULL;
+			if (search_trace.last) search_trace.last->next = buffer->block;
+			else search_trace.first = buffer->block;
+			search_trace.last = buffer->block;
+			++search_trace.n_queued;
+			condition_broadcast(&search_trace);
+			buffer->block = block;
+			buffer->event = block->event;
+		}
+	}
+	unlock(&search_trace);
+	buffer->n = 0;
+}
+
+/**
+ * @brief Flush & free the event buffer of a thread.
+ *
+ * @param buffer Trace buffer.
+ */
+void trace_buffer_free(TraceBuffer *buffer)
+{
+	if (buffer == NULL) return;
+
+	trace_buffer_flush(buffer);
+	lock(&search_trace);
+	search_trace.used[buffer->thread] = false;
+	if (search_trace.f) {
+		buffer->block->next = search_trace.free_list;
+		search_trace.free_list = buffer->block;
+	} else {
+		free(buffer->block);
+	}
+	unlock(&search_trace);
+	free(buffer);
+}
+
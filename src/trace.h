@@ -0,0 +1,159 @@
+/**
+ * @file trace.h
+ *
+ * @brief Binary search-tree trace.
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#ifndef EDAX_TRACE_H
+#define EDAX_TRACE_H
+
+#include <stdbool.h>
+
+/** Trace file magic string */
+#define TRACE_MAGIC "EDAXTRC1"
+
+/** Number of events buffered per thread before a flush to the trace file */
+#define TRACE_BUFFER_SIZE 4096
+
+/** Maximal number of flushed blocks waiting to be written */
+#define TRACE_MAX_QUEUED 64
+
+/** Maximal number of threads traced at the same time (thread ids are bytes) */
+#define TRACE_MAX_THREADS 256
+
+/** Trace event types */
+enum {
+	TRACE_ENTER,      /**< entering a node */
+	TRACE_EXIT,       /**< leaving a node */
+	TRACE_SPLIT,      /**< a move of a node is given to a helper task */
+	TRACE_WAIT,       /**< a node starts waiting for its helper tasks */
+	TRACE_JOIN,       /**< all the helper tasks of a node are done */
+	TRACE_TASK_START, /**< a helper task starts to search */
+	TRACE_TASK_END,   /**< a helper task ends to search */
+	TRACE_TYPE_SIZE
+};
+
+/** Reasons to leave a node */
+enum {
+	TRACE_ALL,        /**< all moves searched, without a cutoff (fail-low) */
+	TRACE_CUT,        /**< beta cutoff while searching the moves (fail-high) */
+	TRACE_PV,         /**< exact score inside the window */
+	TRACE_TC,         /**< transposition cutoff */
+	TRACE_SC,         /**< stability cutoff */
+	TRACE_ETC,        /**< enhanced transposition cutoff */
+	TRACE_PROBCUT,    /**< probcut */
+	TRACE_STOP,       /**< search stopped */
+	TRACE_REASON_SIZE
+};
+
+/** Node kinds, at node entry */
+enum {
+	TRACE_NWS,        /**< null window search */
+	TRACE_PVS,        /**< principal variation search */
+};
+
+/**
+ * A trace event, as written in the trace file (in the host byte order).
+ *
+ * Only the parallel events (split, wait, join & task events) are timestamped,
+ * to keep the node events cheap.
+ */
+typedef struct TraceEvent {
+	unsigned char type;       /**< event type */
+	unsigned char info;       /**< node kind (enter) or reason (exit) */
+	unsigned char depth;      /**< search depth */
+	unsigned char thread;     /**< thread id */
+	signed char alpha;        /**< lower bound */
+	signed char beta;         /**< upper bound */
+	signed char score;        /**< score (exit) */
+	unsigned char n_moves;    /**< moves searched (exit) or slaves (split) */
+	unsigned long long time;  /**< time in microseconds (parallel events) */
+} TraceEvent;
+
+/** Block of events, written to the trace file by the writer thread */
+typedef struct TraceBlock {
+	struct TraceBlock *next;             /**< next block in the write queue or in the free list */
+	int n;                               /**< number of events */
+	TraceEvent event[TRACE_BUFFER_SIZE]; /**< events */
+} TraceBlock;
+
+/** Per thread event buffer */
+typedef struct TraceBuffer {
+	TraceBlock *block;                   /**< block being filled */
+	TraceEvent *event;                   /**< events of the block */
+	int n;                               /**< number of events */
+	int thread;                          /**< thread id */
+} TraceBuffer;
+
+void trace_init(void);
+void trace_open(const char*);
+void trace_close(void);
+TraceBuffer* trace_buffer_create(void);
+void trace_buffer_free(TraceBuffer*);
+void trace_buffer_flush(TraceBuffer*);
+unsigned long long trace_clock(void);
+
+/**
+ * @brief Record an event.
+ *
+ * @param buffer Trace buffer.
+ * @param type Event type.
+ * @param info Node kind or exit reason.
+ * @param depth Depth.
+ * @param alpha Lower bound.
+ * @param beta Upper bound.
+ * @param score Score.
+ * @param n_moves Number of moves.
+ * @param time Time.
+ */
+static inline void trace_push(TraceBuffer *buffer, const int type, const int info, const int depth, const int alpha, const int beta, const int score, const int n_moves, const unsigned long long time)
+{
+	TraceEvent *event = buffer->event + buffer->n;
+
+	event->type = type;
+	event->info = info;
+	event->depth = depth;
+	event->thread = buffer->thread;
+	event->alpha = alpha;
+	event->beta = beta;
+	event->score = score;
+	event->n_moves = n_moves;
+	event->time = time;
+	if (++buffer->n == TRACE_BUFFER_SIZE) trace_buffer_flush(buffer);
+}
+
+/**
+ * @brief Record a node event.
+ *
+ * @param buffer Trace buffer (NULL when the trace is off).
+ * @param type Event type.
+ * @param info Node kind or exit reason.
+ * @param depth Depth.
+ * @param alpha Lower bound.
+ * @param beta Upper bound.
+ * @param score Score.
+ * @param n_moves Number of moves.
+ */
+static inline void trace_node(TraceBuffer *buffer, const int type, const int info, const int depth, const int alpha, const int beta, const int score, const int n_moves)
+{
+	if (buffer) trace_push(buffer, type, info, depth, alpha, beta, score, n_moves, 0);
+}
+
+/**
+ * @brief Record a timestamped parallel event.
+ *
+ * @param buffer Trace buffer (NULL when the trace is off).
+ * @param type Event type.
+ * @param depth Depth.
+ * @param n Number of slaves.
+ */
+static inline void trace_parallel(TraceBuffer *buffer, const int type, const int depth, const int n)
+{
+	if (buffer) trace_push(buffer, type, 0, depth, 0, 0, 0, n, trace_clock());
+}
+
+#endif
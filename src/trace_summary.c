@@ -0,0 +1,250 @@
+/**
+ * @file trace_summary.c
+ *
+ * Summary of a binary search-tree trace (see trace.c).
+ *
+ * The trace is read thread by thread to report:
+ *   - for each node kind & depth, how the nodes were left: by a transposition,
+ *     stability, enhanced transposition or probcut cutoff, or after a search
+ *     of the moves, and for the fail-high nodes, how often the first move was
+ *     enough (a measure of the move ordering quality);
+ *   - for each thread, the number of splits & tasks, its busy time and its
+ *     idle time, either spent waiting for the helper tasks at a join, or, for
+ *     the helper threads, spent waiting for a task.
+ *
+ * Build it with `make trace-summary`, and run it as:
+ * trace_summary <trace file>
+ *
+ * @date 2025
+ * @author Richard Delorme
+ * @version 4.5
+ */
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Maximal depth reported */
+#define SUMMARY_DEPTH 64
+
+/** Maximal nested waits per thread */
+#define SUMMARY_STACK 64
+
+/** Maximal height of the traced nodes */
+#define SUMMARY_HEIGHT 128
+
+/** Number of threads (thread ids are reused, see trace_buffer_create()) */
+#define SUMMARY_THREADS TRACE_MAX_THREADS
+
+/** Node statistics of a node kind at a depth */
+typedef struct NodeSummary {
+	unsigned long long n;                         /**< number of nodes */
+	unsigned long long n_reason[TRACE_REASON_SIZE]; /**< number of nodes per exit reason */
+	unsigned long long n_move_cut;                /**< fail-high nodes with moves (not passing) */
+	unsigned long long n_first_cut;               /**< fail-high nodes cut by their first move */
+	unsigned long long n_cut_moves;               /**< moves searched by the fail-high nodes */
+} NodeSummary;
+
+/** Parallel statistics of a thread */
+typedef struct ThreadSummary {
+	unsigned long long n_events;                  /**< number of events */
+	unsigned long long n_nodes;                   /**< number of nodes entered */
+	unsigned long long n_nodes_out_of_task;       /**< number of nodes entered outside a task */
+	unsigned long long n_split;                   /**< number of splits */
+	unsigned long long n_join;                    /**< number of joins */
+	unsigned long long n_task;                    /**< number of tasks */
+	unsigned long long busy;                      /**< time spent in tasks (started out of a task) */
+	unsigned long long idle;                      /**< time spent waiting at joins */
+	unsigned long long task_start[SUMMARY_STACK]; /**< start time of the running tasks */
+	int n_running_task;                           /**< number of nested running tasks */
+	unsigned long long wait_start[SUMMARY_STACK]; /**< start time of the waits */
+	unsigned long long wait_busy[SUMMARY_STACK];  /**< time spent helping during the waits */
+	int n_wait;                                   /**< number of nested waits */
+	unsigned char kind[SUMMARY_HEIGHT];           /**< kind of the nodes entered & not left yet */
+	int height;                                   /**< number of nodes entered & not left yet */
+} ThreadSummary;
+
+static const char *REASON_NAME[TRACE_REASON_SIZE] = {"all", "cut", "pv", "TC", "SC", "ETC", "probcut", "stop"};
+
+/**
+ * @brief Update the statistics with an event.
+ *
+ * @param node Node statistics [kind][depth].
+ * @param thread Thread statistics.
+ * @param e Event.
+ */
+static void summary_update(NodeSummary node[2][SUMMARY_DEPTH], ThreadSummary *thread, const TraceEvent *e)
+{
+	ThreadSummary *t = thread + e->thread;
+	NodeSummary *s;
+	unsigned long long d;
+	const int depth = e->depth < SUMMARY_DEPTH ? e->depth : SUMMARY_DEPTH - 1;
+
+	++t->n_events;
+	switch (e->type) {
+	case TRACE_ENTER:
+		++t->n_nodes;
+		if (t->n_running_task == 0) ++t->n_nodes_out_of_task;
+		if (t->height < SUMMARY_HEIGHT) t->kind[t->height] = (e->info == TRACE_PVS);
+		++t->height;
+		break;
+	case TRACE_EXIT:
+		// the nodes of a thread are nested: an exit matches the last entry
+		if (t->height > 0) --t->height;
+		s = &node[t->height < SUMMARY_HEIGHT ? t->kind[t->height] : 0][depth];
+		++s->n;
+		if (e->info < TRACE_REASON_SIZE) ++s->n_reason[e->info];
+		if (e->info == TRACE_CUT && e->n_moves > 0) {
+			++s->n_move_cut;
+			s->n_first_cut += (e->n_moves == 1);
+			s->n_cut_moves += e->n_moves;
+		}
+		break;
+	case TRACE_SPLIT:
+		++t->n_split;
+		break;
+	case TRACE_WAIT:
+		if (t->n_wait < SUMMARY_STACK) {
+			t->wait_start[t->n_wait] = e->time;
+			t->wait_busy[t->n_wait] = 0;
+		}
+		++t->n_wait;
+		break;
+	case TRACE_JOIN:
+		++t->n_join;
+		if (t->n_wait > 0 && --t->n_wait < SUMMARY_STACK) {
+			d = e->time - t->wait_start[t->n_wait];
+			if (d > t->wait_busy[t->n_wait]) t->idle += d - t->wait_busy[t->n_wait];
+		}
+		break;
+	case TRACE_TASK_START:
+		++t->n_task;
+		if (t->n_running_task < SUMMARY_STACK) t->task_start[t->n_running_task] = e->time;
+		++t->n_running_task;
+		break;
+	case TRACE_TASK_END:
+		if (t->n_running_task > 0 && --t->n_running_task < SUMMARY_STACK) {
+			d = e->time - t->task_start[t->n_running_task];
+			if (t->n_wait > 0 && t->n_wait <= SUMMARY_STACK) t->wait_busy[t->n_wait - 1] += d; // helping while waiting
+			else if (t->n_running_task == 0) t->busy += d;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief Print the node statistics.
+ *
+ * @param node Node statistics [kind][depth].
+ */
+static void summary_print_nodes(NodeSummary node[2][SUMMARY_DEPTH])
+{
+	static const char *KIND_NAME[2] = {"NWS", "PVS"};
+	int k, d, r;
+
+	printf("Node exits (%% of the nodes):\n");
+	printf("kind depth        nodes");
+	for (r = 0; r < TRACE_REASON_SIZE; ++r) printf(" %7s", REASON_NAME[r]);
+	printf(" | 1st-cut  moves/cut\n");
+	for (k = 0; k < 2; ++k)
+	for (d = 0; d < SUMMARY_DEPTH; ++d) {
+		const NodeSummary *s = &node[k][d];
+		const unsigned long long n_cut = s->n_move_cut;
+		if (s->n == 0) continue;
+		printf("%s  %5d %12llu", KIND_NAME[k], d, s->n);
+		for (r = 0; r < TRACE_REASON_SIZE; ++r) printf(" %6.2f%%", 100.0 * s->n_reason[r] / s->n);
+		if (n_cut) printf(" | %6.2f%% %10.2f\n", 100.0 * s->n_first_cut / n_cut, (double) s->n_cut_moves / n_cut);
+		else printf(" |       -          -\n");
+	}
+}
+
+/**
+ * @brief Print the parallel statistics.
+ *
+ * The master threads (the ones entering nodes out of a task) are only idle
+ * while waiting at a join, and busy otherwise; the helper threads are also
+ * idle between tasks.
+ *
+ * @param thread Thread statistics.
+ * @param span Time between the first & last timestamped events.
+ */
+static void summary_print_threads(const ThreadSummary *thread, const unsigned long long span)
+{
+	int i;
+	unsigned long long idle, busy, total_idle = 0, total = 0;
+
+	printf("\nThreads (time span: %.3f s):\n", 1e-6 * span);
+	printf("thread   role       nodes   splits    joins    tasks    busy (s)    idle (s)  idle\n");
+	for (i = 0; i < SUMMARY_THREADS; ++i) {
+		const ThreadSummary *t = thread + i;
+		const bool is_master = (t->n_nodes_out_of_task > 0);
+		if (t->n_events == 0) continue;
+		idle = t->idle;
+		if (!is_master) idle += (span > t->busy ? span - t->busy : 0);
+		busy = is_master ? (span > idle ? span - idle : 0) : t->busy;
+		total_idle += idle;
+		total += span;
+		printf("%6d %6s %11llu %8llu %8llu %8llu %11.3f %11.3f %5.1f%%\n", i, is_master ? "master" : "helper",
+			t->n_nodes, t->n_split, t->n_join, t->n_task, 1e-6 * busy, 1e-6 * idle, span ? 100.0 * idle / span : 0.0);
+	}
+	if (total) printf("parallel idle time: %.1f%%\n", 100.0 * total_idle / total);
+}
+
+/**
+ * @brief Main function.
+ *
+ * @param argc Number of arguments.
+ * @param argv Arguments.
+ * @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int main(int argc, char **argv)
+{
+	static NodeSummary node[2][SUMMARY_DEPTH];
+	static ThreadSummary thread[SUMMARY_THREADS];
+	static TraceEvent event[TRACE_BUFFER_SIZE];
+	char magic[sizeof TRACE_MAGIC];
+	unsigned long long n_events = 0, first = 0, last = 0;
+	bool has_time = false;
+	size_t i, n;
+	FILE *f;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	f = fopen(argv[1], "rb");
+	if (f == NULL) {
+		fprintf(stderr, "cannot open trace file %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (fread(magic, 1, strlen(TRACE_MAGIC), f) != strlen(TRACE_MAGIC) || memcmp(magic, TRACE_MAGIC, strlen(TRACE_MAGIC)) != 0) {
+		fprintf(stderr, "%s is not a trace file\n", argv[1]);
+		fclose(f);
+		return EXIT_FAILURE;
+	}
+
+	while ((n = fread(event, sizeof (TraceEvent), TRACE_BUFFER_SIZE, f)) > 0) {
+		for (i = 0; i < n; ++i) {
+			if (event[i].type >= TRACE_SPLIT) {
+				if (!has_time || event[i].time < first) first = event[i].time;
+				if (!has_time || event[i].time > last) last = event[i].time;
+				has_time = true;
+			}
+			summary_update(node, thread, event + i);
+		}
+		n_events += n;
+	}
+	fclose(f);
+
+	printf("%s: %llu events\n\n", argv[1], n_events);
+	summary_print_nodes(node);
+	if (has_time) summary_print_threads(thread, last - first);
+
+	return EXIT_SUCCESS;
+}
+
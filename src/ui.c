@@ -54,6 +54,12 @@ bool ui_switch(UI *ui, const char *ui_type)
 		ui->free = ui_free_ggs;
 		ui->loop = ui_loop_ggs;
 		return true;
+	} else if (strcmp(ui_type, "json") == 0) {
+		ui->type = UI_JSON;
+		ui->init = ui_init_json;
+		ui->free = ui_free_json;
+		ui->loop = ui_loop_json;
+		return true;
 	} else if (strcmp(ui_type, "cassio") == 0) {
 		ui->type = UI_CASSIO;
 		return true;
@@ -91,7 +97,10 @@ static void ui_read_input(UI *ui)
 		if (ui->type == UI_GTP) gtp_preprocess(buffer);
 		parse_word(buffer, cmd, 5);
 		string_to_lowercase(cmd);
-		if (strcmp(cmd, "stop") == 0) {
+		if (ui->type == UI_JSON) {
+			// requests are parsed by the json loop, that stops & quits by itself
+			if (strcmp(cmd, "quit") == 0 || strcmp(cmd, "q") == 0) event->loop = false;
+		} else if (strcmp(cmd, "stop") == 0) {
 			event_clear_messages(event);
 			info("<stop>\n");
 			play_stop(play);
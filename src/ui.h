@@ -26,7 +26,6 @@ typedef struct UI {
 	Play play[2];              /**< Play Control */
 	Book book;                 /**< Opening book */
 	struct GGSClient *ggs;     /**< GGS Client */
-	bool is_same_play;         /**< true if play[0] == play[1] */
 	int type;                  /**< type of UI */
 	int mode;                  /**< computer's color mode TODO: remove me*/
 	Event event;               /**< event */
@@ -68,6 +67,10 @@ void ui_init_cassio(UI*);
 void ui_loop_cassio(UI*);
 void ui_free_cassio(UI*);
 
+void ui_init_json(UI*);
+void ui_loop_json(UI*);
+void ui_free_json(UI*);
+
 void ui_book_init(UI*);
 
 #endif
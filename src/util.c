@@ -36,6 +36,8 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 
 #endif // __unix__ || __APPLE__
 
@@ -50,6 +52,7 @@
 
 #include <winsock2.h>
 #include <windows.h>
+#include <io.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -922,6 +925,119 @@ char* file_add_ext(const char *base, const char *ext, char *file)
 	return file;
 }
 
+/**
+ * @brief Initialize an empty file mapping.
+ *
+ * @param map File mapping.
+ */
+void file_map_init(FileMap *map)
+{
+	map->data = NULL;
+	map->size = 0;
+	map->handle = NULL;
+}
+
+/**
+ * @brief Map a whole file into memory.
+ *
+ * The mapping is read-only: pages are shared with the system file cache (and
+ * with other processes mapping the same file). Data to be modified must be
+ * copied first.
+ *
+ * @param map File mapping.
+ * @param file File name.
+ * @return true if the file is mapped, false otherwise.
+ */
+bool file_map(FileMap *map, const char *file)
+{
+#if defined(__unix__) || defined(__APPLE__)
+	struct stat st;
+	void *data;
+	int fd;
+
+	file_map_init(map);
+	fd = open(file, O_RDONLY);
+	if (fd == -1) return false;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return false;
+
+	map->data = data;
+	map->size = (size_t) st.st_size;
+	return true;
+
+#elif defined(_WIN32)
+	HANDLE f, m;
+	LARGE_INTEGER size;
+	void *data;
+
+	file_map_init(map);
+	f = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (f == INVALID_HANDLE_VALUE) return false;
+	if (!GetFileSizeEx(f, &size) || size.QuadPart == 0 || (unsigned long long) size.QuadPart > (size_t) -1) {
+		CloseHandle(f);
+		return false;
+	}
+	m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(f);
+	if (m == NULL) return false;
+	data = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) {
+		CloseHandle(m);
+		return false;
+	}
+
+	map->data = data;
+	map->size = (size_t) size.QuadPart;
+	map->handle = m;
+	return true;
+
+#else
+	file_map_init(map); (void) file;
+	return false;
+#endif
+}
+
+/**
+ * @brief Unmap a file.
+ *
+ * @param map File mapping.
+ */
+void file_unmap(FileMap *map)
+{
+	if (map->data) {
+#if defined(__unix__) || defined(__APPLE__)
+		munmap(map->data, map->size);
+#elif defined(_WIN32)
+		UnmapViewOfFile(map->data);
+		CloseHandle((HANDLE) map->handle);
+#endif
+	}
+	file_map_init(map);
+}
+
+/**
+ * @brief Write the buffered data of a file to the disk.
+ *
+ * @param f File.
+ * @return true in case of success.
+ */
+bool file_sync(FILE *f)
+{
+	if (fflush(f) != 0) return false;
+#if defined(__unix__) || defined(__APPLE__)
+	return fsync(fileno(f)) == 0;
+#elif defined(_WIN32)
+	return _commit(fileno(f)) == 0;
+#else
+	return true;
+#endif
+}
+
 /**
  * @brief Create a thread.
  *
@@ -76,6 +76,20 @@ void path_get_dir(const char*, char*);
 char* file_add_ext(const char*, const char*, char*); 
 bool is_stdin_keyboard(void);
 
+/*
+ * File mapping.
+ */
+typedef struct FileMap {
+	void *data;     /**< mapped file contents */
+	size_t size;    /**< mapped size, in bytes */
+	void *handle;   /**< system mapping handle (windows only) */
+} FileMap;
+
+void file_map_init(FileMap*);
+bool file_map(FileMap*, const char*);
+void file_unmap(FileMap*);
+bool file_sync(FILE*);
+
 /*
  * random
  */
@@ -25,41 +25,65 @@
 
 Log xboard_log[1];
 
+/** number of best moves searched in analysis mode */
+static int xboard_multipv = 1;
+
 typedef struct {
 	unsigned long long time;
 	unsigned long long n_nodes;
 	int n_games;
 } XBoardStats;
 
+/**
+ * @brief Print a search line, in the xboard format.
+ * @param result Search Result.
+ * @param score Score of the line.
+ * @param pv Principal variation of the line.
+ * @param f Output stream.
+ */
+static void xboard_print_line(const Result *result, const int score, const Line *pv, FILE *f)
+{
+	fprintf(f, "%2d ", result->depth);
+	fprintf(f, "%4d ", 100 * score);
+	fprintf(f, "%6lld ", result->time / 10);
+	fprintf(f, "%10lld ", result->n_nodes);
+	if (result->selectivity < 5) fprintf(f, "@%2d%% ", selectivity_table[result->selectivity].percent);	
+	if (result->book_move) fputc('(', f);
+	line_print(pv, -200, " ", f);
+	if (result->book_move) fputc(')', f);
+	putc('\n', f);
+}
+
 /**
  * @brief Search oberver.
+ *
+ * In multi-PV mode, a line is sent for each of the best moves.
+ *
  * @param result Search Result.
  */
 static void xboard_observer(Result *result)
 {
+	int i;
+
 	spin_lock(result);
 
-	printf("%2d ", result->depth);
-	printf("%4d ", 100 * result->score);
-	printf("%6lld ", result->time / 10);
-	printf("%10lld ", result->n_nodes);
-	if (result->selectivity < 5) printf("@%2d%% ", selectivity_table[result->selectivity].percent);	
-	if (result->book_move) putchar('(');
-	line_print(&result->pv, -200, " ", stdout);
-	if (result->book_move) putchar(')');
-	putchar('\n');
+	if (result->n_lines > 1) {
+		for (i = 0; i < result->n_lines; ++i) xboard_print_line(result, result->line[i].score, &result->line[i].pv, stdout);
+	} else {
+		xboard_print_line(result, result->score, &result->pv, stdout);
+	}
 	fflush(stdout);
 
 	if (log_is_open(xboard_log)) {
-		fprintf(xboard_log->f, "edax> %2d ", result->depth);
-		fprintf(xboard_log->f, "%4d ", 100 * result->score);
-		fprintf(xboard_log->f, "%6lld ", result->time / 10);
-		fprintf(xboard_log->f, "%10lld ", result->n_nodes);
-		if (result->selectivity < 5) fprintf(xboard_log->f, "@%2d%% ", selectivity_table[result->selectivity].percent);	
-		if (result->book_move) fputc('(', xboard_log->f);
-		line_print(&result->pv, -200, " ", xboard_log->f);
-		if (result->book_move) fputc(')', xboard_log->f);
-		putc('\n', xboard_log->f);
+		if (result->n_lines > 1) {
+			for (i = 0; i < result->n_lines; ++i) {
+				fprintf(xboard_log->f, "edax> ");
+				xboard_print_line(result, result->line[i].score, &result->line[i].pv, xboard_log->f);
+			}
+		} else {
+			fprintf(xboard_log->f, "edax> ");
+			xboard_print_line(result, result->score, &result->pv, xboard_log->f);
+		}
 		fflush(xboard_log->f);
 	}
 	spin_unlock(result);
@@ -327,10 +351,31 @@ void xboard_stop_analyzing(Play *play)
 	if (play->ponder.launched) {
 		thread_join(play->ponder.thread);
 		play->ponder.launched = false;
+		play->search.options.multipv = 1;
 		log_print(xboard_log, "edax (analyze)> stopped\n");
 	}
 }
 
+/**
+ * @brief Set an engine option.
+ *
+ * @param param Option, as name=value.
+ */
+static void xboard_option(const char *param)
+{
+	char name[16];
+	const char *value = parse_field(param, name, 15, '=');
+
+	string_to_lowercase(name);
+	if (strcmp(name, "multipv") == 0) {
+		xboard_multipv = string_to_int(value, 1);
+		BOUND(xboard_multipv, 1, MAX_MOVE, "multipv");
+		log_print(xboard_log, "edax setup> multipv: %d\n", xboard_multipv);
+	} else {
+		xboard_error("(unknown option): %s", param);
+	}
+}
+
 /**
  * @brief Analyze.
  *
@@ -349,6 +394,7 @@ static void xboard_analyze(Play *play)
 		play->ponder.board.player = play->ponder.board.opponent = 0;
 		play->state = IS_ANALYZING;
 		search_cleanup(&play->search);
+		play->search.options.multipv = xboard_multipv;
 		log_print(xboard_log, "edax (analyze)> start\n");
 		thread_create(&play->ponder.thread, play_ponder_run, play);
 		play->ponder.launched = true;
@@ -405,6 +451,11 @@ static void xboard_loop_analyze(UI *ui)
 			if (play->initial_player == EMPTY) xboard_error("(bad FEN): %s\n", param);
 			xboard_analyze(play);
 
+		} else if (strcmp(cmd, "option") == 0) {
+			xboard_stop_analyzing(play);
+			xboard_option(param);
+			xboard_analyze(play);
+
 		} else if (strcmp(cmd, "exit") == 0) {
 			xboard_stop_analyzing(play);
 			free(cmd); free(param);
@@ -482,13 +533,14 @@ void ui_loop_xboard(UI *ui)
 						   "sigint=0 "
 						   "sigterm=0 "
 						   "analyze=1 "
+						   "option=\"MultiPV -spin 1 1 %d\" "
 		                   "myname=\"%s\" "
 						   "variants=\"reversi\" "
 						   "colors=0 "
 		                   "nps=1 "
 		                   "memory=1 "
 		                   "smp=1 "
-		                   "done=1\n", options.name);
+		                   "done=1\n", MAX_MOVE, options.name);
 				}
 
 			// accepted features
@@ -708,7 +760,7 @@ void ui_loop_xboard(UI *ui)
 			} else if ((strcmp(cmd, "cores") == 0)) {
 				options.n_task = string_to_int(param, 1);
 				log_print(xboard_log, "edax setup> cores: %d\n", options.n_task);
-				if (search_count_tasks(&play->search) != options.n_task) {
+				if (play->search.tasks->n != options.n_task) {
 					play_stop_pondering(play);
 					search_set_task_number(&play->search, options.n_task);
 				}
@@ -717,7 +769,7 @@ void ui_loop_xboard(UI *ui)
 				xboard_error("(unknown command): %s %s", cmd, param);
 				
 			} else if ((strcmp(cmd, "option") == 0)) {
-				xboard_error("(unknown command): %s %s", cmd, param);
+				xboard_option(param);
 
 			// move
 			} else if (strcmp(cmd, "usermove") == 0) {
@@ -34,6 +34,7 @@
 #include "util.h"
 #include "search.h"
 #include "stats.h"
+#include "trace.h"
 #include "settings.h"
 
 #include <assert.h>
@@ -125,6 +126,7 @@ static bool get_helper(Node *master, Node *node, Move *move)
 				task->node = node;
 				task->move = move;
 				search_clone(task->search, node->search);
+				task->search->trace = master->search->trace; // the helper runs within the thread of the waiting master
 				lock(node);
 					node->slave[node->n_slave++] = task->search;
 				unlock(node);			
@@ -142,6 +144,30 @@ static bool get_helper(Node *master, Node *node, Move *move)
 	return found;
 }
 
+/**
+ * @brief Get an idle task for a search.
+ *
+ * Several main searches may share the same task stack (see
+ * search_init_shared()), each one using at most its own limit of tasks.
+ *
+ * @param search Search.
+ * @return An idle task, or NULL.
+ */
+static Task* get_idle_task(Search *search)
+{
+	Search *master = search->master;
+	Task *task = NULL;
+
+	spin_lock(master);
+	if (master->tasks_used < master->tasks_limit) {
+		task = task_stack_get_idle_task(search->tasks);
+		if (task) ++master->tasks_used;
+	}
+	spin_unlock(master);
+
+	return task;
+}
+
 /**
  * @brief Node split.
  *
@@ -178,8 +204,9 @@ bool node_split(Node *node, Move *move)
 
 		if (get_helper(node->parent, node, move)) {
 			YBWC_STATS(atomic_add(&statistics.n_master_helper, 1);)
+			trace_parallel(search->trace, TRACE_SPLIT, node->depth, node->n_slave);
 			return true;
-		} else if ((task = task_stack_get_idle_task(search->tasks)) != NULL) {
+		} else if ((task = get_idle_task(search)) != NULL) {
 			task->node = node;
 			task->move = move;
 			search_clone(task->search, search);
@@ -187,6 +214,7 @@ bool node_split(Node *node, Move *move)
 				node->slave[node->n_slave++] = task->search;
 			unlock(node);
 			YBWC_STATS(atomic_add(&statistics.n_split_success, 1);)
+			trace_parallel(search->trace, TRACE_SPLIT, node->depth, node->n_slave);
 
 			lock(task);
 				task->run = true;
@@ -212,6 +240,7 @@ bool node_split(Node *node, Move *move)
 void node_wait_slaves(Node* node)
 {
 	int i;
+	bool has_waited;
 
 	lock(node);
 	// stop slaves ?
@@ -223,7 +252,9 @@ void node_wait_slaves(Node* node)
 	}
 
 	// wait slaves
+	has_waited = (node->n_slave > 0);
 	YBWC_STATS(atomic_add(&statistics.n_waited_slave, node->n_slave > 0);)
+	if (has_waited) trace_parallel(node->search->trace, TRACE_WAIT, node->depth, node->n_slave);
 	while (node->n_slave) {
 		node->is_waiting = true;
 		assert(node->is_helping == false);
@@ -238,13 +269,16 @@ void node_wait_slaves(Node* node)
 			node->is_waiting = false;
 		}
 	}
+	if (has_waited) trace_parallel(node->search->trace, TRACE_JOIN, node->depth, 0);
 
-	// wake-up master thread!
+	// wake-up master thread! (unless a stop has been requested meanwhile)
+	spin_lock(node->search);
 	if (node->search->stop == STOP_PARALLEL_SEARCH && node->stop_point) {
 		node->search->stop = RUNNING;
 		node->stop_point = false;
 		YBWC_STATS(atomic_add(&statistics.n_wake_up, 1);)
 	}
+	spin_unlock(node->search);
 	unlock(node);
 }
 
@@ -369,9 +403,13 @@ void task_search(Task *task)
 	Board board0;
 	int i;
 
+	// inherit the state of the master, atomically with respect to search_stop_all()
+	spin_lock(node->search);
 	search_set_state(search, node->search->stop);
+	spin_unlock(node->search);
 
 	YBWC_STATS(++task->n_calls;)
+	trace_parallel(search->trace, TRACE_TASK_START, node->depth, 0);
 
 	while (move && !search->stop) {
 		const int alpha = node->alpha;
@@ -404,10 +442,14 @@ void task_search(Task *task)
 			}
 			if (node->bestscore > node->alpha) {
 				node->alpha = node->bestscore;
-				if (node->alpha >= node->beta && node->search->stop == RUNNING) { // stop the master thread?
-					node->stop_point = true;
-					node->search->stop = STOP_PARALLEL_SEARCH;
-					YBWC_STATS(atomic_add(&statistics.n_stopped_master, 1);)
+				if (node->alpha >= node->beta) { // stop the master thread?
+					spin_lock(node->search);
+					if (node->search->stop == RUNNING) {
+						node->stop_point = true;
+						node->search->stop = STOP_PARALLEL_SEARCH;
+						YBWC_STATS(atomic_add(&statistics.n_stopped_master, 1);)
+					}
+					spin_unlock(node->search);
 				}
 			}
 		}
@@ -416,6 +458,7 @@ void task_search(Task *task)
 	}
 
 	search_set_state(search, STOP_END);
+	trace_parallel(search->trace, TRACE_TASK_END, node->depth, 0);
 
 	spin_lock(search->parent);
 		for (i = 0; i < search->parent->n_child; ++i) {
@@ -461,17 +504,24 @@ void* task_loop(void *param)
 
 	lock(task);
 	task->loop = true;
+	task->search->trace = trace_buffer_create();
 
 	while (task->loop) {
 		if (!task->run) {
 			condition_wait(task);
 		}
 		if (task->run) {
+			Search *master = task->search->master;
 			task_search(task);
+			spin_lock(master);
+				--master->tasks_used;
+			spin_unlock(master);
 			task_stack_put_idle_task(task->container, task);
 		}
 	}
 
+	trace_buffer_free(task->search->trace);
+	task->search->trace = NULL;
 	unlock(task);
 
 	return NULL;
@@ -498,6 +548,7 @@ static Search* task_search_create(Task *task)
 	spin_init(search);
 	search->task = task;
 	search->stop = STOP_END;
+	search->trace = NULL;
 
 	return search;
 }
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Mock GGS server, replaying recorded GGS protocol transcripts to test Edax.
+
+A transcript is a GGS log of Edax (see the -ggs-log-file option), or a file
+in the same format, so that a real session can be recorded & replayed:
+
+    GGS [2025/ 1/ 2 12:34:56] <== /os: + match .3 2000.0 edax 1800.0 opp s8r20 R
+    GGS [2025/ 1/ 2 12:34:58] ==> tell /os play .3.0 d3/0/1.20
+
+The "GGS" prefix & the time stamp are optional. "<==" lines were received by
+the client: the mock sends them. "==>" lines were sent by the client: the mock
+waits for them before sending the next "<==" lines. A line without any marker
+continues the previous one, and lines starting with "#" are comments.
+
+The chat lines of the client ("tell .<channel or user> ...", like the search
+reports of Edax) are free text, so they are not awaited. Any other awaited
+line matches the next client line equal to it, the client lines in between
+being ignored, except that:
+  - consecutive awaited lines are received in any order (the moves of several
+    games at once are sent in the order they are found);
+  - "tell /os play <game> <move>/<eval>/<time>" matches any move of the game
+    (use --strict to also match the move), as the search is not deterministic;
+  - "~<regex>" matches the client lines matching the python regex (e.g. a
+    password edited out of a recorded transcript).
+
+The transcripts of tools/ggs/ are:
+  - single.log: a single game, where Edax replies to f5 with white;
+  - synchro.log: a synchro match of two games, .3.0 (Edax is black) & .3.1
+    (Edax is white, after f5), thought at the same time, so that both share
+    the helper tasks (see ggs_balance_tasks() in src/ggs.c).
+
+Usage, from a directory holding the data/ files of Edax:
+
+    python3 tools/ggs_mock.py 5000 tools/ggs/synchro.log 2> mock.log &
+    (sleep 25; echo quit) | ./edax -ggs -ggs-host 127.0.0.1 -ggs-port 5000 \\
+        -ggs-login edax -ggs-password x -n 4 -vv -book-usage off > edax.log
+
+mock.log ends with the moves received for each game & when they were
+received (in seconds since the last message sent), e.g.:
+
+    MOCK: moves {'.3.0': ('d3', 1.1), '.3.1': ('f6', 1.2)}
+
+The mock exits with status 1 if an awaited line is not received in time (a
+minute by default), and with status 2 on a bad transcript.
+"""
+
+import argparse
+import re
+import socket
+import sys
+import time
+
+LINE = re.compile(r"^(?:GGS\s*(?:\[[^\]]*\])?\s*)?(<==|==>) ?(.*)$")
+PLAY = re.compile(r"^tell /os play (\S+) (\S+?)/")
+CHAT = re.compile(r"^tell \.")
+
+
+def read_transcript(path):
+    """Read a transcript as a list of (direction, lines) steps, a direction being '<==' or '==>'."""
+    steps = []
+    with open(path) as f:
+        for n, raw in enumerate(f, 1):
+            raw = raw.rstrip("\r\n")
+            if raw.startswith("#") or not raw.strip():
+                continue
+            m = LINE.match(raw)
+            if m:
+                direction, text = m.group(1), m.group(2)
+            elif steps:
+                direction, text = steps[-1][0], raw
+            else:
+                sys.stderr.write("%s:%d: line without direction\n" % (path, n))
+                sys.exit(2)
+            if direction == "==>" and CHAT.match(text):
+                continue
+            if steps and steps[-1][0] == direction:
+                steps[-1][1].append(text)
+            else:
+                steps.append((direction, [text]))
+    return steps
+
+
+def matches(expected, line, strict):
+    """Check if a client line matches an awaited line."""
+    if expected.startswith("~"):
+        return re.search(expected[1:], line) is not None
+    m, e = PLAY.match(line), PLAY.match(expected)
+    if m and e and not strict:
+        return m.group(1) == e.group(1)
+    return line == expected
+
+
+class Client:
+    """The connection to the tested client."""
+
+    def __init__(self, port):
+        server = socket.socket()
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind(("127.0.0.1", port))
+        server.listen(1)
+        self.sock, _ = server.accept()
+        self.sock.settimeout(1)
+        self.buf = ""
+
+    def send(self, lines):
+        for line in lines:
+            sys.stderr.write("MOCK <== " + line + "\n")
+        self.sock.sendall(("\n".join(lines) + "\n").encode())
+
+    def readline(self, end):
+        """Read the next client line, or None once the time is over."""
+        while "\n" not in self.buf:
+            if time.time() > end:
+                return None
+            try:
+                data = self.sock.recv(65536).decode(errors="replace")
+                if not data:
+                    return None
+                self.buf += data
+            except socket.timeout:
+                pass
+        line, self.buf = self.buf.split("\n", 1)
+        return line.rstrip("\r")
+
+    def expect(self, awaited, timeout, strict):
+        """Wait for the awaited lines, in any order; return the received lines."""
+        end = time.time() + timeout
+        pending = list(awaited)
+        received = []
+        while pending:
+            line = self.readline(end)
+            if line is None:
+                sys.stderr.write("MOCK: timeout on %s\n" % pending)
+                sys.exit(1)
+            for e in pending:
+                if matches(e, line, strict):
+                    pending.remove(e)
+                    received.append(line)
+                    sys.stderr.write("MOCK ==> %s\n" % line)
+                    break
+        return received
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay a GGS transcript to a client.")
+    parser.add_argument("port", type=int)
+    parser.add_argument("transcript")
+    parser.add_argument("--timeout", type=float, default=60.0, help="time to wait for each client step (s)")
+    parser.add_argument("--strict", action="store_true", help="also match the moves of the client")
+    args = parser.parse_args()
+
+    steps = read_transcript(args.transcript)
+    client = Client(args.port)
+
+    moves = {}
+    t0 = time.time()
+    for direction, lines in steps:
+        if direction == "<==":
+            client.send(lines)
+            t0 = time.time()
+        else:
+            for line in client.expect(lines, args.timeout, args.strict):
+                m = PLAY.match(line)
+                if m:
+                    moves[m.group(1)] = (m.group(2), round(time.time() - t0, 1))
+    sys.stderr.write("MOCK: moves %s\n" % moves)
+
+    time.sleep(1)
+    client.sock.close()
+
+
+if __name__ == "__main__":
+    main()